@@ -79,6 +79,13 @@ antlrcpp::Any CodeGenVisitor::visitFunction_definition(ifccParser::Function_defi
         funcDef->setParameters(paramsTypes);
     }
 
+    // On crée le bloc de fin de la fonction, vers lequel sautent les return (il est ajouté en dernier)
+    currentCfg->epilogue_bb = new BasicBlock(currentCfg, currentCfg->get_epilogue_label());
+    if (funcDef->getType() != VarType::VOID)
+    {
+        currentCfg->return_var = currentCfg->currentScope->addTempVariable(funcDef->getType());
+    }
+
     // On crée le bloc de début de la fonction
     BasicBlock *bbStart = new BasicBlock(currentCfg, currentCfg->new_BB_name());
     currentCfg->add_bb(bbStart);
@@ -88,10 +95,15 @@ antlrcpp::Any CodeGenVisitor::visitFunction_definition(ifccParser::Function_defi
     // On traite le bloc de la fonction
     this->visit(ctx->block());
 
-    // On crée le bloc de fin de la fonction
-    BasicBlock *bbEnd = new BasicBlock(currentCfg, currentCfg->get_epilogue_label());
+    // Le bloc de fin de la fonction place la valeur de retour dans le registre de retour
+    BasicBlock *bbEnd = currentCfg->epilogue_bb;
     currentCfg->add_bb(bbEnd);
     currentCfg->current_bb->exit_true = bbEnd;
+    if (!currentCfg->return_var.empty())
+    {
+        string funcReturnReg = (funcDef->getType() == VarType::FLOAT) ? floatReturnReg : returnReg;
+        bbEnd->add_IRInstr(IRInstr::copy, funcDef->getType(), {funcReturnReg, currentCfg->return_var});
+    }
 
     currentCfg = nullptr; // On remet le CFG à nullptr pour éviter les erreurs de traitement
     return 0;
@@ -262,9 +274,7 @@ antlrcpp::Any CodeGenVisitor::visitAssignmentStatement(ifccParser::AssignmentSta
         }
         else if (op == "/=")
         {
-            string tempReg = (type == VarType::FLOAT_PTR) ? floatRegs[1] : tempRegs[4];
-            currentCfg->current_bb->add_IRInstr(IRInstr::copy, Symbol::getBaseType(type), {tempReg, typedExprResult});
-            currentCfg->current_bb->add_IRInstr(IRInstr::divTblx, type, {varName, tempReg, pos});
+            currentCfg->current_bb->add_IRInstr(IRInstr::divTblx, type, {varName, typedExprResult, pos});
         }
         else if (op == "%=")
         {
@@ -273,8 +283,7 @@ antlrcpp::Any CodeGenVisitor::visitAssignmentStatement(ifccParser::AssignmentSta
                 exit(1);
             }
 
-            currentCfg->current_bb->add_IRInstr(IRInstr::copy, Symbol::getBaseType(type), {tempRegs[4], typedExprResult});
-            currentCfg->current_bb->add_IRInstr(IRInstr::modTblx, type, {varName, tempRegs[4], pos});
+            currentCfg->current_bb->add_IRInstr(IRInstr::modTblx, type, {varName, typedExprResult, pos});
         }
 
         if (findVariable(typedExprResult)->isConstant()) {
@@ -304,9 +313,7 @@ antlrcpp::Any CodeGenVisitor::visitAssignmentStatement(ifccParser::AssignmentSta
         }
         else if (op == "/=")
         {
-            string tempReg = (type == VarType::FLOAT) ? floatRegs[1] : tempRegs[2];
-            currentCfg->current_bb->add_IRInstr(IRInstr::copy, type, {tempReg, typedExprResult});
-            currentCfg->current_bb->add_IRInstr(IRInstr::div, type, {varName, varName, tempReg});
+            currentCfg->current_bb->add_IRInstr(IRInstr::div, type, {varName, varName, typedExprResult});
         }
         else if (op == "%=")
         {
@@ -315,8 +322,7 @@ antlrcpp::Any CodeGenVisitor::visitAssignmentStatement(ifccParser::AssignmentSta
                 exit(1);
             }
 
-            currentCfg->current_bb->add_IRInstr(IRInstr::copy, type, {tempRegs[2], typedExprResult});
-            currentCfg->current_bb->add_IRInstr(IRInstr::mod, type, {varName, varName, tempRegs[2]});
+            currentCfg->current_bb->add_IRInstr(IRInstr::mod, type, {varName, varName, typedExprResult});
         }
 
         if (findVariable(typedExprResult)->isConstant()) {
@@ -337,7 +343,7 @@ antlrcpp::Any CodeGenVisitor::visitReturn_stmt(ifccParser::Return_stmtContext *c
             FeedbackOutputFormat::showFeedbackOutput("error", "function " + currentCfg->ast->getName() + " must return a value.");
             exit(1);
         }
-        currentCfg->current_bb->add_IRInstr(IRInstr::jmp, VarType::INT, {currentCfg->get_epilogue_label()});
+        jumpToEpilogue();
         return 0;
     }
 
@@ -351,15 +357,14 @@ antlrcpp::Any CodeGenVisitor::visitReturn_stmt(ifccParser::Return_stmtContext *c
     std::string exprResult = any_cast<std::string>(this->visit(ctx->expr()));
     string typedExprResult = this->implicitConversion(exprResult, funcReturnType);
 
-    string funcReturnReg = (funcReturnType == VarType::FLOAT) ? floatReturnReg : returnReg;
-    currentCfg->current_bb->add_IRInstr(IRInstr::copy, funcReturnType, {funcReturnReg, typedExprResult});
+    currentCfg->current_bb->add_IRInstr(IRInstr::copy, funcReturnType, {currentCfg->return_var, typedExprResult});
 
     if (findVariable(typedExprResult)->isConstant()) {
         freeLastTempVariable(1);
     }
     
     // Ajoute un saut vers l'épilogue
-    currentCfg->current_bb->add_IRInstr(IRInstr::jmp, VarType::INT, {currentCfg->get_epilogue_label()});
+    jumpToEpilogue();
     return 0;
 }
 
@@ -367,23 +372,14 @@ antlrcpp::Any CodeGenVisitor::visitIf_stmt(ifccParser::If_stmtContext *ctx)
 {
     bool hasElseStmt = ctx->stmt().size() > 1;
 
-    // Évalue la condition
-    std::string cond = any_cast<std::string>(visit(ctx->expr()));
-    // TODO: Vérifier le type de la condition
-
     BasicBlock *tmp = currentCfg->current_bb->exit_true;
     // Crée un nouveau bloc pour la suite (join)
     std::string joinLabel = currentCfg->new_BB_name();
     BasicBlock *join_bb = new BasicBlock(currentCfg, joinLabel);
-    currentCfg->add_bb(join_bb);
-
-    BasicBlock *current = currentCfg->current_bb;
-    current->test_var_name = cond;
 
     // Création des blocs then et else
     std::string thenLabel = currentCfg->new_BB_name();
     BasicBlock *then_bb = new BasicBlock(currentCfg, thenLabel);
-    currentCfg->add_bb(then_bb);
 
     // Crée le bloc pour la branche "else"
     BasicBlock *else_bb = join_bb;
@@ -391,19 +387,22 @@ antlrcpp::Any CodeGenVisitor::visitIf_stmt(ifccParser::If_stmtContext *ctx)
     {
         std::string elseLabel = currentCfg->new_BB_name();
         else_bb = new BasicBlock(currentCfg, elseLabel);
-        currentCfg->add_bb(else_bb);
         else_bb->exit_true = join_bb;
     }
 
+    // Évalue la condition: le bloc courant (ou le dernier bloc d'un && / ||) saute vers then ou else
+    // TODO: Vérifier le type de la condition
+    branchOnCondition(ctx->expr(), then_bb, else_bb);
+
     // Connecter les blocs
+    currentCfg->add_bb(join_bb);
+    currentCfg->add_bb(then_bb);
+    if (hasElseStmt)
+    {
+        currentCfg->add_bb(else_bb);
+    }
     join_bb->exit_true = tmp;
     then_bb->exit_true = join_bb;
-    currentCfg->current_bb->exit_true = then_bb;
-    currentCfg->current_bb->exit_false = else_bb;
-
-    // Configure le bloc courant pour effectuer un saut conditionnel
-    currentCfg->current_bb->test_var_name = cond;
-    currentCfg->current_bb->test_var_register = currentCfg->IR_reg_to_asm(cond);
 
     // Génère la branche "then"
     currentCfg->current_bb = then_bb;
@@ -425,6 +424,9 @@ antlrcpp::Any CodeGenVisitor::visitIf_stmt(ifccParser::If_stmtContext *ctx)
 
 antlrcpp::Any CodeGenVisitor::visitWhile_stmt(ifccParser::While_stmtContext *ctx)
 {
+    // La suite de la boucle reprend la sortie du bloc courant
+    BasicBlock *tmp = currentCfg->current_bb->exit_true;
+
     // Crée un bloc pour évaluer la condition
     std::string condLabel = currentCfg->new_BB_name();
     BasicBlock *cond_bb = new BasicBlock(currentCfg, "cond" + condLabel);
@@ -433,27 +435,23 @@ antlrcpp::Any CodeGenVisitor::visitWhile_stmt(ifccParser::While_stmtContext *ctx
     // cfg->current_bb->add_IRInstr(IRInstr::jmp, VarType::INT, {condLabel}); // Ajoute un saut du bloc courant vers le
     // bloc de condition
 
-    // Génère le bloc de condition
-    currentCfg->current_bb = cond_bb;
-    std::string cond = any_cast<std::string>(this->visit(ctx->expr()));
-    // TODO: Vérifier le type de la condition
-    cond_bb->test_var_name = cond;
-    cond_bb->test_var_register = currentCfg->IR_reg_to_asm(cond);
-
     // Crée le bloc du corps de la boucle
     std::string bodyLabel = currentCfg->new_BB_name();
     BasicBlock *body_bb = new BasicBlock(currentCfg, "body" + bodyLabel);
-    currentCfg->add_bb(body_bb);
 
     // Crée le bloc de sortie (après la boucle)
     std::string joinLabel = currentCfg->new_BB_name();
     BasicBlock *join_bb = new BasicBlock(currentCfg, "join" + joinLabel);
-    currentCfg->add_bb(join_bb);
 
-    // La condition détermine le chemin
-    cond_bb->exit_true = body_bb;
-    cond_bb->exit_false = join_bb;
+    // Génère le bloc de condition, qui détermine le chemin
+    currentCfg->current_bb = cond_bb;
+    // TODO: Vérifier le type de la condition
+    branchOnCondition(ctx->expr(), body_bb, join_bb);
+
+    currentCfg->add_bb(body_bb);
+    currentCfg->add_bb(join_bb);
     body_bb->exit_true = cond_bb;
+    join_bb->exit_true = tmp;
 
     // Génère le corps de la boucle
     currentCfg->current_bb = body_bb;
@@ -464,6 +462,55 @@ antlrcpp::Any CodeGenVisitor::visitWhile_stmt(ifccParser::While_stmtContext *ctx
     return 0;
 }
 
+void CodeGenVisitor::branchOnCondition(ifccParser::ExprContext *expr, BasicBlock *ifTrue, BasicBlock *ifFalse, bool logicalOperand)
+{
+    if (auto parenthesis = dynamic_cast<ifccParser::ParenthesisExpressionContext *>(expr))
+    {
+        branchOnCondition(parenthesis->expr(), ifTrue, ifFalse, logicalOperand);
+        return;
+    }
+
+    // a && b: b n'est évalué que si a est vrai; a || b: que si a est faux
+    if (auto logical = dynamic_cast<ifccParser::LogiqueParesseuxExpressionContext *>(expr))
+    {
+        bool isAnd = logical->op->getText() == "&&";
+        BasicBlock *right_bb = new BasicBlock(currentCfg, currentCfg->new_BB_name());
+        branchOnCondition(logical->expr(0), isAnd ? right_bb : ifTrue, isAnd ? ifFalse : right_bb, true);
+        currentCfg->add_bb(right_bb);
+        currentCfg->current_bb = right_bb;
+        branchOnCondition(logical->expr(1), ifTrue, ifFalse, true);
+        return;
+    }
+
+    std::string cond = any_cast<std::string>(visit(expr));
+    if (logicalOperand)
+    {
+        checkLogicalOperand(cond);
+    }
+    BasicBlock *current = currentCfg->current_bb;
+    Symbol *condSymbol = findVariable(cond);
+    if (condSymbol->isConstant())
+    {
+        // Condition connue à la compilation: un seul chemin
+        current->exit_true = (stod(condSymbol->getCstValue()) != 0) ? ifTrue : ifFalse;
+        current->exit_false = nullptr;
+        return;
+    }
+    current->test_var_name = cond;
+    current->test_var = currentCfg->IR_operand(cond);
+    current->exit_true = ifTrue;
+    current->exit_false = ifFalse;
+}
+
+void CodeGenVisitor::checkLogicalOperand(std::string &operand)
+{
+    VarType type = findVariable(operand)->type;
+    if (type == VarType::FLOAT) {
+        FeedbackOutputFormat::showFeedbackOutput("error", "logical operator is not supported for " + Symbol::getTypeStr(type) + " type.");
+        exit(1);
+    }
+}
+
 antlrcpp::Any CodeGenVisitor::visitBlockStatement(ifccParser::BlockStatementContext *ctx)
 {
     enterNewScope();
@@ -543,14 +590,7 @@ antlrcpp::Any CodeGenVisitor::visitMulDivExpression(ifccParser::MulDivExpression
     }
     
     string tmp = currentCfg->currentScope->addTempVariable(type);
-    if (op == IRInstr::Operation::div || op == IRInstr::Operation::mod)
-    {
-        string tempReg = (type == VarType::FLOAT) ? floatRegs[1] : tempRegs[2];
-        currentCfg->current_bb->add_IRInstr(IRInstr::copy, type, {tempReg, rightTyped});
-        currentCfg->current_bb->add_IRInstr(op, type, {tmp, leftTyped, tempReg});
-    } else {
-        currentCfg->current_bb->add_IRInstr(op, type, {tmp, leftTyped, rightTyped});
-    }
+    currentCfg->current_bb->add_IRInstr(op, type, {tmp, leftTyped, rightTyped});
     return tmp;
 }
 
@@ -856,36 +896,53 @@ antlrcpp::Any CodeGenVisitor::visitFunctionCallExpression(ifccParser::FunctionCa
 antlrcpp::Any CodeGenVisitor::visitLogiqueParesseuxExpression(ifccParser::LogiqueParesseuxExpressionContext *ctx)
 {
     // expr op=('&&'|'||') expr
-    string left = any_cast<string>(this->visit(ctx->expr(0)));
-    string right = any_cast<string>(this->visit(ctx->expr(1)));
-    
-    VarType type = getTypeExpr(left, right);
-    if (type == VarType::FLOAT) {
-        FeedbackOutputFormat::showFeedbackOutput("error", "logical operator is not supported for " + Symbol::getTypeStr(type) + " type.");
-        exit(1);
+    string op = ctx->op->getText();
+    IRInstr::Operation logOp = (op == "&&") ? IRInstr::log_and : IRInstr::log_or;
+
+    // Contexte global: les deux opérandes sont des constantes
+    if (currentCfg == nullptr) {
+        string left = any_cast<string>(this->visit(ctx->expr(0)));
+        string right = any_cast<string>(this->visit(ctx->expr(1)));
+        checkLogicalOperand(left);
+        checkLogicalOperand(right);
+        return constantOptimizeBinaryOp(left, right, logOp);
     }
 
+    // Évaluation paresseuse: le résultat vaut 0 (&&) ou 1 (||) si l'opérande gauche décide, sinon la
+    // valeur de vérité de l'opérande droit, calculée dans son propre bloc
+    BasicBlock *tmp = currentCfg->current_bb->exit_true;
+    BasicBlock *right_bb = new BasicBlock(currentCfg, currentCfg->new_BB_name());
+    BasicBlock *join_bb = new BasicBlock(currentCfg, currentCfg->new_BB_name());
+    right_bb->exit_true = join_bb;
+    join_bb->exit_true = tmp;
 
-    string op = ctx->op->getText();
-    IRInstr::Operation logOp;
-    if (op == "&&")
+    string temp = currentCfg->currentScope->addTempVariable(VarType::INT);
+    string decided = addTempConstVariable(VarType::INT, logOp == IRInstr::log_and ? "0" : "1");
+    currentCfg->current_bb->add_IRInstr(IRInstr::copy, VarType::INT, {temp, decided});
+    if (logOp == IRInstr::log_and)
     {
-        logOp = IRInstr::log_and;
+        branchOnCondition(ctx->expr(0), right_bb, join_bb, true);
     }
-    else if (op == "||")
+    else
     {
-        logOp = IRInstr::log_or;
-    }
-    
-    // Verifie si les deux opérandes sont des constantes
-    std::string constOpt = constantOptimizeBinaryOp(left, right, logOp);
-    if ( constOpt != NOT_CONST_OPTI) {
-        return constOpt;
+        branchOnCondition(ctx->expr(0), join_bb, right_bb, true);
     }
 
-    string temp = currentCfg->currentScope->addTempVariable(type);
-    currentCfg->current_bb->add_IRInstr(logOp, type, {temp, left, right});
+    currentCfg->add_bb(right_bb);
+    currentCfg->current_bb = right_bb;
+    string right = any_cast<string>(this->visit(ctx->expr(1)));
+    checkLogicalOperand(right);
+    Symbol *rightSymbol = findVariable(right);
+    if (rightSymbol->isConstant()) {
+        string value = addTempConstVariable(VarType::INT, stoi(rightSymbol->getCstValue()) != 0 ? "1" : "0");
+        currentCfg->current_bb->add_IRInstr(IRInstr::copy, VarType::INT, {temp, value});
+    } else {
+        string zero = addTempConstVariable(rightSymbol->type, "0");
+        currentCfg->current_bb->add_IRInstr(IRInstr::cmp_ne, rightSymbol->type, {temp, right, zero});
+    }
 
+    currentCfg->add_bb(join_bb);
+    currentCfg->current_bb = join_bb;
     return temp;
 }
 
@@ -1164,6 +1221,18 @@ void CodeGenVisitor::exitCurrentScope()
     currentCfg->currentScope = currentCfg->currentScope->getParent();
 }
 
+void CodeGenVisitor::jumpToEpilogue()
+{
+    // Le bloc courant sort vers l'épilogue; le code qui suit le return (inaccessible)
+    // va dans un nouveau bloc qui reprend la sortie du bloc courant
+    BasicBlock *current = currentCfg->current_bb;
+    BasicBlock *bbAfter = new BasicBlock(currentCfg, currentCfg->new_BB_name());
+    currentCfg->add_bb(bbAfter);
+    bbAfter->exit_true = current->exit_true;
+    current->exit_true = currentCfg->epilogue_bb;
+    currentCfg->current_bb = bbAfter;
+}
+
 DefFonction* CodeGenVisitor::getAstFunction(std::string name)
 {
     for (auto &cfg : cfgs)
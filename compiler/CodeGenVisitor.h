@@ -38,9 +38,17 @@ private:
 
     //================================= Function Management ===============================
     DefFonction* getAstFunction(std::string name);
+    void jumpToEpilogue();
+
+    //================================= Control Flow ===============================
+    /** Ends the current block with a branch on expr; && and || become one block per operand, the right one
+     *  reached only when the left one does not decide */
+    void branchOnCondition(ifccParser::ExprContext *expr, BasicBlock *ifTrue, BasicBlock *ifFalse, bool logicalOperand = false);
+    void checkLogicalOperand(std::string &operand); /**< && and || are not supported on floats */
 
 public:
     void gen_asm(std::ostream& o);
+    std::vector<CFG*>& getCfgs() { return cfgs; }
 
     //================================ Program ===============================
     virtual antlrcpp::Any visitProg(ifccParser::ProgContext *ctx) override;
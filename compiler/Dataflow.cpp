@@ -0,0 +1,374 @@
+#include "Dataflow.h"
+#include "Dominators.h"
+#include <deque>
+using namespace std;
+
+/* ---------------------- BitSet ---------------------- */
+
+void BitSet::fill()
+{
+    for (size_t w = 0; w < words.size(); w++)
+    {
+        words[w] = ~(uint64_t)0;
+    }
+    // Les bits au-delà de l'univers restent à 0 pour que == et count() restent justes
+    if (n % 64 != 0)
+    {
+        words.back() = ((uint64_t)1 << (n % 64)) - 1;
+    }
+}
+
+void BitSet::clear()
+{
+    for (size_t w = 0; w < words.size(); w++)
+    {
+        words[w] = 0;
+    }
+}
+
+bool BitSet::unionWith(const BitSet &other)
+{
+    bool changed = false;
+    for (size_t w = 0; w < words.size(); w++)
+    {
+        uint64_t merged = words[w] | other.words[w];
+        changed |= merged != words[w];
+        words[w] = merged;
+    }
+    return changed;
+}
+
+bool BitSet::intersectWith(const BitSet &other)
+{
+    bool changed = false;
+    for (size_t w = 0; w < words.size(); w++)
+    {
+        uint64_t merged = words[w] & other.words[w];
+        changed |= merged != words[w];
+        words[w] = merged;
+    }
+    return changed;
+}
+
+void BitSet::subtract(const BitSet &other)
+{
+    for (size_t w = 0; w < words.size(); w++)
+    {
+        words[w] &= ~other.words[w];
+    }
+}
+
+int BitSet::count() const
+{
+    int total = 0;
+    for (uint64_t word : words)
+    {
+        total += __builtin_popcountll(word);
+    }
+    return total;
+}
+
+vector<int> BitSet::elements() const
+{
+    vector<int> result;
+    for (int i = 0; i < n; i++)
+    {
+        if (test(i))
+            result.push_back(i);
+    }
+    return result;
+}
+
+/* ---------------------- DataflowAnalysis ---------------------- */
+
+void DataflowAnalysis::solve()
+{
+    cfg->compute_predecessors();
+    const vector<BasicBlock *> &rpo = cfg->get_dominators()->rpo();
+    order = rpo;
+    if (direction == backward)
+    {
+        order.assign(rpo.rbegin(), rpo.rend());
+    }
+    index.clear();
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        index[order[i]] = i;
+    }
+
+    int size = universe();
+    ins.assign(order.size(), BitSet(size));
+    outs.assign(order.size(), BitSet(size));
+    gens.assign(order.size(), BitSet(size));
+    kills.assign(order.size(), BitSet(size));
+    for (size_t b = 0; b < order.size(); b++)
+    {
+        initBlock(order[b], gens[b], kills[b]);
+        // Valeur initiale du résultat: vide pour une union, plein pour une intersection
+        vector<BitSet> &result = (direction == forward) ? outs : ins;
+        if (meet == intersectionMeet)
+            result[b].fill();
+    }
+
+    deque<int> worklist;
+    vector<bool> queued(order.size(), true);
+    for (size_t b = 0; b < order.size(); b++)
+    {
+        worklist.push_back(b);
+    }
+
+    visits = 0;
+    while (!worklist.empty())
+    {
+        int b = worklist.front();
+        worklist.pop_front();
+        queued[b] = false;
+        visits++;
+
+        BasicBlock *bb = order[b];
+        vector<BasicBlock *> from = (direction == forward) ? bb->preds : bb->successors();
+        vector<BasicBlock *> to = (direction == forward) ? bb->successors() : bb->preds;
+
+        // Confluence des voisins atteignables
+        BitSet met(size);
+        bool first = true;
+        for (BasicBlock *neighbour : from)
+        {
+            auto it = index.find(neighbour);
+            if (it == index.end())
+                continue;
+            BitSet value = (direction == forward) ? outs[it->second] : ins[it->second];
+            alongEdge(bb, neighbour, value);
+            if (first)
+                met = value;
+            else if (meet == unionMeet)
+                met.unionWith(value);
+            else
+                met.intersectWith(value);
+            first = false;
+        }
+        if (first)
+        {
+            met = boundary();
+        }
+
+        BitSet result = met;
+        result.subtract(kills[b]);
+        result.unionWith(gens[b]);
+
+        BitSet &entering = (direction == forward) ? ins[b] : outs[b];
+        BitSet &leaving = (direction == forward) ? outs[b] : ins[b];
+        entering = met;
+        if (result == leaving)
+        {
+            continue;
+        }
+        leaving = result;
+        for (BasicBlock *next : to)
+        {
+            auto it = index.find(next);
+            if (it != index.end() && !queued[it->second])
+            {
+                queued[it->second] = true;
+                worklist.push_back(it->second);
+            }
+        }
+    }
+}
+
+/* ---------------------- Liveness ---------------------- */
+
+void Liveness::initBlock(BasicBlock *bb, BitSet &gen, BitSet &kill)
+{
+    // On remonte le bloc depuis sa fin, où le test de sortie est lu
+    if (bb->test_var.isVreg() && bb->exit_false != nullptr)
+    {
+        gen.set(bb->test_var.id);
+    }
+
+    for (auto it = bb->instrs.rbegin(); it != bb->instrs.rend(); ++it)
+    {
+        IRInstr *instr = *it;
+        int d = instr->def_index();
+        if (d >= 0 && instr->params[d].isVreg())
+        {
+            gen.reset(instr->params[d].id);
+            kill.set(instr->params[d].id);
+        }
+        if (instr->op == IRInstr::phi)
+        {
+            continue;
+        }
+        for (int u : instr->use_indices())
+        {
+            if (instr->params[u].isVreg())
+                gen.set(instr->params[u].id);
+        }
+    }
+}
+
+void Liveness::alongEdge(BasicBlock *bb, BasicBlock *succ, BitSet &value)
+{
+    // Les opérandes des phi de succ venant de bb sont lus en fin de bb
+    for (IRInstr *instr : succ->instrs)
+    {
+        if (instr->op != IRInstr::phi)
+            break;
+        for (size_t i = 0; i < instr->phi_preds.size(); i++)
+        {
+            if (instr->phi_preds[i] == bb && instr->params[i + 1].isVreg())
+                value.set(instr->params[i + 1].id);
+        }
+    }
+}
+
+/* ---------------------- ReachingDefinitions ---------------------- */
+
+ReachingDefinitions::ReachingDefinitions(CFG *cfg) : DataflowAnalysis(cfg, forward, unionMeet)
+{
+    defsOf.assign(cfg->get_vreg_count(), {});
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (d >= 0 && instr->params[d].isVreg())
+            {
+                numberOf[instr] = defs.size();
+                defsOf[instr->params[d].id].push_back(defs.size());
+                defs.push_back(instr);
+            }
+        }
+    }
+    solve();
+}
+
+void ReachingDefinitions::initBlock(BasicBlock *bb, BitSet &gen, BitSet &kill)
+{
+    for (IRInstr *instr : bb->instrs)
+    {
+        int d = instr->def_index();
+        if (d < 0 || !instr->params[d].isVreg())
+        {
+            continue;
+        }
+        for (int other : defsOf[instr->params[d].id])
+        {
+            gen.reset(other);
+            kill.set(other);
+        }
+        gen.set(numberOf[instr]);
+    }
+}
+
+vector<IRInstr *> ReachingDefinitions::reaching(BasicBlock *bb, int vreg)
+{
+    vector<IRInstr *> result;
+    for (int d : defsOf[vreg])
+    {
+        if (in(bb).test(d))
+            result.push_back(defs[d]);
+    }
+    return result;
+}
+
+/* ---------------------- AvailableExpressions ---------------------- */
+
+AvailableExpressions::AvailableExpressions(CFG *cfg) : DataflowAnalysis(cfg, forward, intersectionMeet)
+{
+    usersOf.assign(cfg->get_vreg_count(), {});
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            string k = key(instr);
+            if (k.empty() || numbers.count(k))
+                continue;
+            numbers[k] = exprs.size();
+            for (size_t i = 1; i < instr->params.size(); i++)
+            {
+                if (instr->params[i].isVreg())
+                    usersOf[instr->params[i].id].push_back(exprs.size());
+            }
+            exprs.push_back(instr);
+        }
+    }
+    solve();
+}
+
+string AvailableExpressions::key(IRInstr *instr)
+{
+    switch (instr->op)
+    {
+    case IRInstr::add:
+    case IRInstr::sub:
+    case IRInstr::mul:
+    case IRInstr::div:
+    case IRInstr::mod:
+    case IRInstr::cmp_eq:
+    case IRInstr::cmp_ne:
+    case IRInstr::cmp_lt:
+    case IRInstr::cmp_le:
+    case IRInstr::cmp_gt:
+    case IRInstr::cmp_ge:
+    case IRInstr::bit_and:
+    case IRInstr::bit_or:
+    case IRInstr::bit_xor:
+    case IRInstr::unary_minus:
+    case IRInstr::not_op:
+    case IRInstr::log_and:
+    case IRInstr::log_or:
+    case IRInstr::intToFloat:
+    case IRInstr::floatToInt:
+    case IRInstr::getTblx:
+        break;
+    default:
+        return "";
+    }
+
+    string text = instr->toString();
+    string k = text.substr(0, text.find(' ')) + ":" + to_string(instr->t);
+    for (size_t i = 1; i < instr->params.size(); i++)
+    {
+        // Les globales et les registres physiques peuvent changer sans définition visible
+        const IROperand &o = instr->params[i];
+        if (o.kind == IROperand::global || o.kind == IROperand::preg)
+            return "";
+        k += " " + o.toString();
+    }
+    return k;
+}
+
+int AvailableExpressions::expressionOf(IRInstr *instr)
+{
+    auto it = numbers.find(key(instr));
+    return it == numbers.end() ? -1 : it->second;
+}
+
+void AvailableExpressions::initBlock(BasicBlock *bb, BitSet &gen, BitSet &kill)
+{
+    for (IRInstr *instr : bb->instrs)
+    {
+        int e = expressionOf(instr);
+        if (e >= 0)
+        {
+            gen.set(e);
+        }
+
+        // Une écriture invalide les expressions qui lisent le registre (ou le tableau) écrit
+        int written = instr->def_index();
+        if (written < 0)
+        {
+            written = instr->array_param_index();
+        }
+        if (written < 0 || !instr->params[written].isVreg())
+        {
+            continue;
+        }
+        for (int user : usersOf[instr->params[written].id])
+        {
+            gen.reset(user);
+            kill.set(user);
+        }
+    }
+}
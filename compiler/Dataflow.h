@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+#include "IR.h"
+
+/** A dense set of small integers (virtual registers, definitions or expressions), one bit each */
+class BitSet {
+public:
+    BitSet(int size = 0) : n(size), words((size + 63) / 64, 0) {}
+
+    void set(int i) { words[i / 64] |= (uint64_t)1 << (i % 64); }
+    void reset(int i) { words[i / 64] &= ~((uint64_t)1 << (i % 64)); }
+    bool test(int i) const { return (words[i / 64] >> (i % 64)) & 1; }
+    void fill(); /**< puts every element of the universe in the set */
+    void clear();
+
+    bool unionWith(const BitSet &other); /**< returns true if the set changed */
+    bool intersectWith(const BitSet &other); /**< returns true if the set changed */
+    void subtract(const BitSet &other);
+
+    int size() const { return n; }
+    int count() const;
+    std::vector<int> elements() const;
+    bool operator==(const BitSet &other) const { return words == other.words; }
+    bool operator!=(const BitSet &other) const { return words != other.words; }
+
+private:
+    int n; /**< size of the universe */
+    std::vector<uint64_t> words;
+};
+
+/** A gen/kill dataflow problem over the blocks of a CFG: out = gen U (in - kill) in the direction of the analysis.
+ *  The solver visits the reachable blocks in reverse post-order (post-order for a backward problem) with a worklist.
+ *  in(bb) is always the value at the top of the block and out(bb) the value at its bottom. */
+class DataflowAnalysis {
+public:
+    typedef enum { forward, backward } Direction;
+    typedef enum { unionMeet, intersectionMeet } Meet;
+
+    DataflowAnalysis(CFG *cfg, Direction direction, Meet meet) : cfg(cfg), direction(direction), meet(meet) {}
+    virtual ~DataflowAnalysis() {}
+
+    void solve();
+    const BitSet &in(BasicBlock *bb) { return ins[index.at(bb)]; }
+    const BitSet &out(BasicBlock *bb) { return outs[index.at(bb)]; }
+    bool reachable(BasicBlock *bb) { return index.count(bb) != 0; }
+    int iterations() { return visits; } /**< number of block visits of the last solve() */
+
+protected:
+    virtual int universe() = 0; /**< number of elements of the sets */
+    virtual void initBlock(BasicBlock *bb, BitSet &gen, BitSet &kill) = 0;
+    virtual BitSet boundary() { return BitSet(universe()); } /**< value entering the entry block, or leaving the exit blocks */
+    virtual void alongEdge(BasicBlock *bb, BasicBlock *neighbour, BitSet &value) {} /**< adjusts the value of a neighbour before the meet in bb */
+
+    CFG *cfg;
+    Direction direction;
+    Meet meet;
+
+private:
+    std::vector<BasicBlock *> order;
+    std::unordered_map<BasicBlock *, int> index;
+    std::vector<BitSet> ins, outs, gens, kills;
+    int visits = 0;
+};
+
+/** Live virtual registers. Array operands count as uses and are never killed; in SSA form the operands
+ *  of a phi are live at the bottom of the corresponding predecessor. */
+class Liveness : public DataflowAnalysis {
+public:
+    Liveness(CFG *cfg) : DataflowAnalysis(cfg, backward, unionMeet) { solve(); }
+
+    bool isLiveIn(BasicBlock *bb, int vreg) { return in(bb).test(vreg); }
+    bool isLiveOut(BasicBlock *bb, int vreg) { return out(bb).test(vreg); }
+
+protected:
+    int universe() override { return cfg->get_vreg_count(); }
+    void initBlock(BasicBlock *bb, BitSet &gen, BitSet &kill) override;
+    void alongEdge(BasicBlock *bb, BasicBlock *succ, BitSet &value) override;
+};
+
+/** Definitions (instructions writing a virtual register) that may reach each point of the function */
+class ReachingDefinitions : public DataflowAnalysis {
+public:
+    ReachingDefinitions(CFG *cfg);
+
+    const std::vector<IRInstr *> &definitions() { return defs; } /**< the definitions, indexed like the bits of the sets */
+    const std::vector<int> &definitionsOf(int vreg) { return defsOf[vreg]; }
+    std::vector<IRInstr *> reaching(BasicBlock *bb, int vreg); /**< definitions of vreg reaching the top of bb */
+
+protected:
+    int universe() override { return defs.size(); }
+    void initBlock(BasicBlock *bb, BitSet &gen, BitSet &kill) override;
+
+private:
+    std::vector<IRInstr *> defs;
+    std::vector<std::vector<int>> defsOf; /**< numbers of the definitions of each virtual register */
+    std::unordered_map<IRInstr *, int> numberOf;
+};
+
+/** Expressions (op, type, operands) computed on every path to a point and not invalidated since.
+ *  getTblx counts as an expression of its array, invalidated by the stores to that array. */
+class AvailableExpressions : public DataflowAnalysis {
+public:
+    AvailableExpressions(CFG *cfg);
+
+    int expressionOf(IRInstr *instr); /**< number of the expression computed by instr, -1 if it computes none */
+    int expressionCount() { return exprs.size(); }
+    static std::string key(IRInstr *instr); /**< textual key of the expression of an instruction, empty if none */
+
+protected:
+    int universe() override { return exprs.size(); }
+    void initBlock(BasicBlock *bb, BitSet &gen, BitSet &kill) override;
+
+private:
+    std::unordered_map<std::string, int> numbers;
+    std::vector<IRInstr *> exprs; /**< one instruction computing each expression */
+    std::vector<std::vector<int>> usersOf; /**< expressions reading each virtual register */
+};
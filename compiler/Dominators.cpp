@@ -0,0 +1,191 @@
+#include "Dominators.h"
+using namespace std;
+
+DominatorTree::DominatorTree(CFG *cfg, bool post) : post(post)
+{
+    vector<BasicBlock *> &bbs = cfg->get_bbs();
+    if (bbs.empty())
+    {
+        return;
+    }
+    cfg->compute_predecessors();
+
+    // Graphe parcouru: les arcs du CFG, ou les arcs inversés depuis la sortie virtuelle (nullptr)
+    vector<BasicBlock *> exits;
+    for (BasicBlock *bb : bbs)
+    {
+        if (bb->successors().empty())
+            exits.push_back(bb);
+    }
+    auto forward = [&](BasicBlock *bb) -> vector<BasicBlock *> {
+        if (!post)
+            return bb->successors();
+        return bb == nullptr ? exits : bb->preds;
+    };
+    auto backward = [&](BasicBlock *bb) -> vector<BasicBlock *> {
+        if (!post)
+            return bb->preds;
+        if (bb == nullptr)
+            return {};
+        vector<BasicBlock *> succs = bb->successors();
+        if (succs.empty())
+            succs.push_back(nullptr);
+        return succs;
+    };
+    BasicBlock *root = post ? nullptr : bbs[0];
+
+    // Post-ordre itératif depuis la racine
+    vector<BasicBlock *> postorder;
+    unordered_map<BasicBlock *, bool> visited;
+    vector<pair<vector<BasicBlock *>, size_t>> stack = {{forward(root), 0}};
+    vector<BasicBlock *> path = {root};
+    visited[root] = true;
+    while (!stack.empty())
+    {
+        if (stack.back().second < stack.back().first.size())
+        {
+            BasicBlock *next = stack.back().first[stack.back().second++];
+            if (!visited[next])
+            {
+                visited[next] = true;
+                stack.push_back({forward(next), 0});
+                path.push_back(next);
+            }
+            continue;
+        }
+        postorder.push_back(path.back());
+        path.pop_back();
+        stack.pop_back();
+    }
+
+    order.assign(postorder.rbegin(), postorder.rend());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        number[order[i]] = i;
+    }
+
+    // Point fixe: idom(b) = intersection des dominateurs des prédécesseurs déjà traités
+    idoms.assign(order.size(), -1);
+    idoms[0] = 0;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t b = 1; b < order.size(); b++)
+        {
+            int newIdom = -1;
+            for (BasicBlock *pred : backward(order[b]))
+            {
+                auto it = number.find(pred);
+                if (it == number.end() || idoms[it->second] == -1)
+                {
+                    continue;
+                }
+                int p = it->second;
+                if (newIdom == -1)
+                {
+                    newIdom = p;
+                    continue;
+                }
+                while (p != newIdom)
+                {
+                    while (p > newIdom)
+                        p = idoms[p];
+                    while (newIdom > p)
+                        newIdom = idoms[newIdom];
+                }
+            }
+            if (idoms[b] != newIdom)
+            {
+                idoms[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    kids.assign(order.size(), {});
+    frontiers.assign(order.size(), {});
+    for (size_t b = 1; b < order.size(); b++)
+    {
+        kids[idoms[b]].push_back(order[b]);
+    }
+
+    // Frontières de dominance: on remonte depuis chaque prédécesseur d'un point de jonction
+    for (size_t b = 0; b < order.size(); b++)
+    {
+        vector<BasicBlock *> preds = backward(order[b]);
+        if (preds.size() < 2)
+        {
+            continue;
+        }
+        for (BasicBlock *pred : preds)
+        {
+            auto it = number.find(pred);
+            if (it == number.end())
+            {
+                continue;
+            }
+            int runner = it->second;
+            while (runner != idoms[b])
+            {
+                vector<BasicBlock *> &df = frontiers[runner];
+                if (df.empty() || df.back() != order[b])
+                {
+                    df.push_back(order[b]);
+                }
+                if (runner == 0)
+                {
+                    break;
+                }
+                runner = idoms[runner];
+            }
+        }
+    }
+
+    // Numérotation du parcours de l'arbre
+    pre.assign(order.size(), 0);
+    postNum.assign(order.size(), 0);
+    int counter = 0;
+    vector<pair<int, size_t>> walk = {{0, 0}};
+    pre[0] = counter++;
+    while (!walk.empty())
+    {
+        int b = walk.back().first;
+        if (walk.back().second < kids[b].size())
+        {
+            int kid = number[kids[b][walk.back().second++]];
+            pre[kid] = counter++;
+            walk.push_back({kid, 0});
+            continue;
+        }
+        postNum[b] = counter++;
+        walk.pop_back();
+    }
+}
+
+BasicBlock *DominatorTree::idom(BasicBlock *bb)
+{
+    int b = number.at(bb);
+    return b == 0 ? nullptr : order[idoms[b]];
+}
+
+bool DominatorTree::dominates(BasicBlock *a, BasicBlock *b)
+{
+    auto ia = number.find(a);
+    auto ib = number.find(b);
+    if (ia == number.end() || ib == number.end())
+    {
+        return false;
+    }
+    return pre[ia->second] <= pre[ib->second] && postNum[ib->second] <= postNum[ia->second];
+}
+
+const vector<BasicBlock *> &DominatorTree::children(BasicBlock *bb)
+{
+    return kids[number.at(bb)];
+}
+
+const vector<BasicBlock *> &DominatorTree::frontier(BasicBlock *bb)
+{
+    return frontiers[number.at(bb)];
+}
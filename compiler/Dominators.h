@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include "IR.h"
+
+/** The dominator tree of a CFG, or its post-dominator tree.
+ *  Computed with the iterative algorithm of Cooper, Harvey and Kennedy over the reverse
+ *  post-order of the blocks reachable from the root. The root is the entry block (bbs[0]),
+ *  or for post-dominators a virtual exit, represented by nullptr, that follows every block
+ *  without successor. */
+class DominatorTree {
+public:
+    DominatorTree(CFG* cfg, bool post = false);
+
+    BasicBlock* idom(BasicBlock* bb); /**< immediate (post-)dominator, nullptr for the root or the virtual exit */
+    bool dominates(BasicBlock* a, BasicBlock* b); /**< true if every path from the root to b goes through a */
+    const std::vector<BasicBlock*>& children(BasicBlock* bb); /**< blocks immediately dominated by bb */
+    const std::vector<BasicBlock*>& frontier(BasicBlock* bb); /**< dominance frontier of bb */
+    const std::vector<BasicBlock*>& rpo() { return order; } /**< reachable blocks in reverse post-order */
+    bool reachable(BasicBlock* bb) { return number.count(bb) != 0; }
+    bool isPost() { return post; }
+
+private:
+    bool post;
+    std::vector<BasicBlock*> order; /**< reachable blocks in reverse post-order, order[0] is the root */
+    std::unordered_map<BasicBlock*, int> number; /**< index of a block in order */
+    std::vector<int> idoms; /**< index of the immediate dominator, the root is its own */
+    std::vector<std::vector<BasicBlock*>> kids;
+    std::vector<std::vector<BasicBlock*>> frontiers;
+    std::vector<int> pre, postNum; /**< numbering of the tree walk, so that dominates() is O(1) */
+};
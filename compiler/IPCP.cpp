@@ -0,0 +1,370 @@
+#include "Passes.h"
+#include <map>
+#include <set>
+#include <algorithm>
+using namespace std;
+
+// Propagation interprocédurale des constantes, avant la mise en SSA. Les appels d'une fonction du
+// programme sont relevés dans toutes les fonctions: un paramètre qui reçoit la même constante à chaque
+// appel est initialisé par cette constante, à la place de la copie depuis son registre, et les appels ne
+// chargent plus l'argument. Quand les appels passent quelques constantes différentes à des paramètres qui
+// règlent des tests ou des calculs (bornes de boucle, diviseurs...), il y a une copie par combinaison.
+// SCCP, le déroulage et les autres passes voient ensuite des constantes dans le corps des fonctions.
+// Toutes les fonctions sont visibles hors du fichier, et leurs appelants extérieurs sont inconnus: la
+// fonction d'origine reste intacte, sous son nom, et seules ses copies (f.constprop.N), appelées par le
+// programme à sa place, sont liées aux constantes. main, appelée par l'extérieur, n'est jamais modifiée.
+
+namespace
+{
+
+const int maxSpecializations = 4;      /**< copies of a function specialized on its constant arguments */
+const int maxSpecializedSize = 200;    /**< instructions of a function that can be copied */
+
+/** A call to a function of the program, with the instructions moving its arguments to their registers */
+struct CallSite
+{
+    BasicBlock *bb;
+    IRInstr *call;
+    vector<IRInstr *> argCopies; /**< in the order of the parameters */
+};
+
+bool isConstantArgument(IRInstr *copy)
+{
+    return copy->params[1].isImm();
+}
+
+class InterproceduralConstants
+{
+public:
+    InterproceduralConstants(vector<CFG *> &cfgs) : cfgs(cfgs) {}
+    void run();
+
+private:
+    bool hasParameterCopies(CFG *f);
+    bool findCallSites(CFG *f, vector<CallSite> &sites);
+    bool findArgumentCopies(CallSite &site, CFG *f);
+    bool foldsInBody(CFG *f, size_t param); /**< the parameter is an operand of a comparison or of a multiplication, division... */
+    bool isPassThrough(CallSite &site, size_t param); /**< recursive call passing the parameter unchanged */
+    void bindParameter(CFG *f, size_t param, IROperand value);
+    void removeArgument(CallSite &site, size_t param);
+    CFG *cloneFunction(CFG *f, string name);
+    void propagate(CFG *f);
+
+    vector<CFG *> &cfgs;
+    CFG *function = nullptr;               /**< the function whose calls are examined */
+    map<CFG *, vector<IROperand>> clonesOf; /**< its specialized copies, with their constants */
+};
+
+// Le bloc d'entrée commence par la copie des paramètres depuis leurs registres
+bool InterproceduralConstants::hasParameterCopies(CFG *f)
+{
+    size_t nbParams = f->ast->getParameters().size();
+    BasicBlock *entry = f->get_bbs()[0];
+    if (entry->instrs.size() < nbParams)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < nbParams; i++)
+    {
+        IRInstr *instr = entry->instrs[i];
+        if (instr->op != IRInstr::copy || instr->params[1].kind != IROperand::preg || !instr->params[0].isVreg())
+            return false;
+    }
+    return true;
+}
+
+// Les copies des arguments dans leurs registres (copy ou ldconst), entre l'appel précédent et celui-ci
+bool InterproceduralConstants::findArgumentCopies(CallSite &site, CFG *f)
+{
+    size_t nbParams = f->ast->getParameters().size();
+    BasicBlock *entry = f->get_bbs()[0];
+    site.argCopies.assign(nbParams, nullptr);
+    size_t index = find(site.bb->instrs.begin(), site.bb->instrs.end(), site.call) - site.bb->instrs.begin();
+    for (size_t k = index; k-- > 0;)
+    {
+        IRInstr *instr = site.bb->instrs[k];
+        if (instr->op == IRInstr::call)
+            break;
+        bool toRegister = (instr->op == IRInstr::copy || instr->op == IRInstr::ldconst) && instr->params[0].kind == IROperand::preg;
+        for (size_t i = 0; i < nbParams && toRegister; i++)
+        {
+            if (site.argCopies[i] == nullptr && instr->params[0].name == entry->instrs[i]->params[1].name)
+                site.argCopies[i] = instr;
+        }
+    }
+    return find(site.argCopies.begin(), site.argCopies.end(), nullptr) == site.argCopies.end();
+}
+
+// Tous les appels de f, dans le programme entier: faux si l'un d'eux n'a pas la forme attendue
+bool InterproceduralConstants::findCallSites(CFG *f, vector<CallSite> &sites)
+{
+    string name = f->ast->getName();
+    for (CFG *cfg : cfgs)
+    {
+        for (BasicBlock *bb : cfg->get_bbs())
+        {
+            for (IRInstr *instr : bb->instrs)
+            {
+                if (instr->op != IRInstr::call || instr->params[0].name != name)
+                    continue;
+                CallSite site;
+                site.bb = bb;
+                site.call = instr;
+                if (!findArgumentCopies(site, f))
+                    return false;
+                sites.push_back(site);
+            }
+        }
+    }
+    return true;
+}
+
+bool InterproceduralConstants::foldsInBody(CFG *f, size_t param)
+{
+    IROperand p = f->get_bbs()[0]->instrs[param]->params[0];
+    for (BasicBlock *bb : f->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            switch (instr->op)
+            {
+            case IRInstr::cmp_eq:
+            case IRInstr::cmp_ne:
+            case IRInstr::cmp_lt:
+            case IRInstr::cmp_le:
+            case IRInstr::cmp_gt:
+            case IRInstr::cmp_ge:
+            case IRInstr::mul:
+            case IRInstr::div:
+            case IRInstr::mod:
+                break;
+            default:
+                continue;
+            }
+            for (int u : instr->use_indices())
+            {
+                if (instr->params[u] == p)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Un appel récursif qui repasse son paramètre, jamais modifié, lui donne la valeur qu'il a déjà: il ne
+// compte pas parmi les valeurs reçues
+bool InterproceduralConstants::isPassThrough(CallSite &site, size_t param)
+{
+    CFG *fn = site.bb->cfg;
+    if (fn != function && !clonesOf.count(fn))
+    {
+        return false;
+    }
+    IRInstr *entryCopy = fn->get_bbs()[0]->instrs[param];
+    IRInstr *copy = site.argCopies[param];
+    if (copy->op != IRInstr::copy || copy->params[1] != entryCopy->params[0])
+    {
+        return false;
+    }
+    for (BasicBlock *bb : fn->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (instr != entryCopy && d >= 0 && instr->params[d] == entryCopy->params[0])
+                return false;
+        }
+    }
+    return true;
+}
+
+// Le paramètre est initialisé par la constante au lieu d'être lu dans son registre
+void InterproceduralConstants::bindParameter(CFG *f, size_t param, IROperand value)
+{
+    IRInstr *copy = f->get_bbs()[0]->instrs[param];
+    if (!Symbol::isFloatingType(value.type))
+        copy->op = IRInstr::ldconst;
+    copy->params[1] = value;
+}
+
+void InterproceduralConstants::removeArgument(CallSite &site, size_t param)
+{
+    vector<IRInstr *> &instrs = site.bb->instrs;
+    instrs.erase(find(instrs.begin(), instrs.end(), site.argCopies[param]));
+    delete site.argCopies[param];
+    site.argCopies[param] = nullptr;
+}
+
+CFG *InterproceduralConstants::cloneFunction(CFG *f, string name)
+{
+    DefFonction *ast = new DefFonction(name, f->ast->getType());
+    ast->setParameters(f->ast->getParameters());
+    CFG *clone = new CFG(ast);
+    clone->currentScope = f->currentScope;
+    clone->rodm = f->rodm;
+    clone->return_var = f->return_var;
+    for (int id = 0; id < f->get_vreg_count(); id++)
+    {
+        VirtualRegister &v = f->get_vreg(id);
+        clone->new_vreg(v.type, v.size, v.name);
+        clone->get_vreg(id).offset = v.offset;
+    }
+
+    // Le bloc d'entrée porte le nom de la fonction, l'épilogue son étiquette
+    map<BasicBlock *, BasicBlock *> blocks;
+    for (BasicBlock *bb : f->get_bbs())
+    {
+        string label = bb == f->get_bbs()[0] ? name : bb == f->epilogue_bb ? clone->get_epilogue_label() : clone->new_BB_name();
+        blocks[bb] = new BasicBlock(clone, label);
+    }
+    blocks[nullptr] = nullptr;
+    for (BasicBlock *bb : f->get_bbs())
+    {
+        BasicBlock *copy = blocks[bb];
+        for (IRInstr *instr : bb->instrs)
+        {
+            IRInstr *cloned = new IRInstr(copy, instr->op, instr->t, instr->params);
+            cloned->tail_call = instr->tail_call;
+            copy->instrs.push_back(cloned);
+        }
+        copy->exit_true = blocks[bb->exit_true];
+        copy->exit_false = blocks[bb->exit_false];
+        copy->test_var = bb->test_var;
+        copy->test_var_name = bb->test_var_name;
+        clone->add_bb(copy);
+    }
+    clone->epilogue_bb = f->epilogue_bb == nullptr ? nullptr : blocks[f->epilogue_bb];
+    clone->compute_predecessors();
+    return clone;
+}
+
+void InterproceduralConstants::propagate(CFG *f)
+{
+    vector<CallSite> sites;
+    if (f->get_bbs().empty() || !hasParameterCopies(f) || !findCallSites(f, sites) || sites.empty())
+    {
+        return;
+    }
+    size_t nbParams = f->ast->getParameters().size();
+    BasicBlock *entry = f->get_bbs()[0];
+    function = f;
+    clonesOf.clear();
+
+    // Constantes passées à chaque paramètre, du type du paramètre
+    vector<set<IROperand>> values(nbParams);
+    vector<bool> constant(nbParams, true);
+    for (CallSite &site : sites)
+    {
+        for (size_t i = 0; i < nbParams; i++)
+        {
+            IRInstr *copy = site.argCopies[i];
+            if (isPassThrough(site, i))
+                continue;
+            if (isConstantArgument(copy) && copy->params[1].type == entry->instrs[i]->t)
+                values[i].insert(copy->params[1]);
+            else
+                constant[i] = false;
+        }
+    }
+
+    // Une seule constante remplace le paramètre; quelques constantes différentes, qui se replient dans le
+    // corps, donnent une copie de la fonction par combinaison
+    vector<size_t> bound;
+    vector<size_t> specialized;
+    for (size_t i = 0; i < nbParams; i++)
+    {
+        if (!constant[i] || values[i].empty())
+            continue;
+        if (values[i].size() == 1)
+            bound.push_back(i);
+        else if (foldsInBody(f, i))
+            specialized.push_back(i);
+    }
+    // Combinaison des constantes d'un appel; un argument repassé par un appel récursif a la valeur de la
+    // copie où il se trouve, inconnue (none) dans la fonction d'origine
+    auto combination = [&](CallSite &site) {
+        vector<IROperand> key;
+        for (size_t k = 0; k < specialized.size(); k++)
+        {
+            if (!isPassThrough(site, specialized[k]))
+                key.push_back(site.argCopies[specialized[k]]->params[1]);
+            else
+                key.push_back(clonesOf.count(site.bb->cfg) ? clonesOf[site.bb->cfg][k] : IROperand());
+        }
+        return key;
+    };
+    map<vector<IROperand>, CFG *> clones;
+    bool mixed = false;
+    for (CallSite &site : sites)
+    {
+        vector<IROperand> key = combination(site);
+        int unknown = count(key.begin(), key.end(), IROperand());
+        if (unknown == 0)
+            clones[key] = nullptr;
+        else if (unknown < (int)key.size())
+            mixed = true; // une partie seulement des constantes est repassée
+    }
+    int size = 0;
+    for (BasicBlock *bb : f->get_bbs())
+    {
+        size += bb->instrs.size();
+    }
+    if (specialized.empty() || mixed || (int)clones.size() > maxSpecializations)
+    {
+        clones.clear();
+        specialized.clear();
+    }
+    if ((bound.empty() && specialized.empty()) || size > maxSpecializedSize)
+    {
+        return;
+    }
+    if (clones.empty())
+    {
+        clones[{}] = nullptr; // une seule copie, pour les paramètres liés
+    }
+
+    int n = 0;
+    vector<CFG *>::iterator at = find(cfgs.begin(), cfgs.end(), f);
+    for (auto &[key, clone] : clones)
+    {
+        clone = cloneFunction(f, f->ast->getName() + ".constprop." + to_string(n++));
+        for (size_t k = 0; k < specialized.size(); k++)
+            bindParameter(clone, specialized[k], key[k]);
+        for (size_t i : bound)
+            bindParameter(clone, i, *values[i].begin());
+        clonesOf[clone] = key;
+        at = cfgs.insert(at, clone) + 1;
+    }
+    // Les appels des copies (récursion) sont relevés avec les autres; ceux de la fonction d'origine, qui
+    // garde ses paramètres pour les appelants extérieurs, restent vers elle
+    sites.clear();
+    findCallSites(f, sites);
+    sites.erase(remove_if(sites.begin(), sites.end(), [&](CallSite &site) { return site.bb->cfg == f; }), sites.end());
+    for (CallSite &site : sites)
+    {
+        site.call->params[0] = IROperand::makeLabel(clones[combination(site)]->ast->getName());
+        for (size_t i : specialized)
+            removeArgument(site, i);
+        for (size_t i : bound)
+            removeArgument(site, i);
+    }
+}
+
+void InterproceduralConstants::run()
+{
+    // Une fonction n'appelle que des fonctions définies avant elle, ou elle-même: en partant de la fin,
+    // tous les appels d'une fonction sont connus, y compris ceux des copies spécialisées de ses appelantes
+    vector<CFG *> functions(cfgs.rbegin(), cfgs.rend());
+    for (CFG *f : functions)
+    {
+        if (f->ast->getName() != "main" && !f->in_ssa)
+            propagate(f);
+    }
+}
+
+} // namespace
+
+void InterproceduralConstantsPass::run(vector<CFG *> &cfgs)
+{
+    InterproceduralConstants(cfgs).run();
+}
@@ -1,26 +1,204 @@
 #include "IR.h"
+#include "Dominators.h"
+#include "Loops.h"
+#include "Dataflow.h"
 #include "SymbolTable.h"
 #include "FeedbackStyleOutput.h"
 #include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <set>
 using namespace std;
 
+/* ---------------------- IROperand ---------------------- */
+
+bool IROperand::operator<(const IROperand &other) const
+{
+    if (kind != other.kind)
+        return kind < other.kind;
+    if (id != other.id)
+        return id < other.id;
+    return name < other.name;
+}
+
+std::string IROperand::toString() const
+{
+    switch (kind)
+    {
+    case vreg:
+        return "%v" + std::to_string(id);
+    case global:
+        return "@" + name;
+    case imm:
+        return "$" + name;
+    case preg:
+    case label:
+        return name;
+    default:
+        return "_";
+    }
+}
+
 /* ---------------------- IRInstr ---------------------- */
 
-IRInstr::IRInstr(BasicBlock *bb_, Operation op, VarType t, std::vector<std::string> params)
+IRInstr::IRInstr(BasicBlock *bb_, Operation op, VarType t, std::vector<IROperand> params)
     : bb(bb_), op(op), t(t), params(params)
 {
 }
 
+int IRInstr::array_param_index()
+{
+    switch (op)
+    {
+    case copyTblx:
+    case addTblx:
+    case subTblx:
+    case mulTblx:
+    case divTblx:
+    case modTblx:
+        return 0;
+    case getTblx:
+    case addrTblx:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+int IRInstr::def_index()
+{
+    switch (op)
+    {
+    case copyTblx:
+    case addTblx:
+    case subTblx:
+    case mulTblx:
+    case divTblx:
+    case modTblx:
+    case wmem:
+    case call: // the result is read from the return register by the next copy
+    case jmp:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+std::vector<int> IRInstr::use_indices()
+{
+    std::vector<int> uses;
+    if (op == call || op == jmp)
+    {
+        return uses;
+    }
+
+    int def = def_index();
+    for (int i = 0; i < (int)params.size(); i++)
+    {
+        // incr and decr read and write their operand
+        bool readsDef = (op == incr || op == decr);
+        if ((i != def || readsDef) && !params[i].isNone())
+        {
+            uses.push_back(i);
+        }
+    }
+    return uses;
+}
+
+std::string IRInstr::toString()
+{
+    static const char *names[] = {
+        "ldconst", "copy", "add", "sub", "mul", "div", "mod",
+        "copyTblx", "addTblx", "subTblx", "mulTblx", "divTblx", "modTblx", "getTblx", "addrTblx",
+        "incr", "decr", "rmem", "wmem",
+        "cmp_eq", "cmp_ne", "cmp_lt", "cmp_le", "cmp_gt", "cmp_ge",
+        "bit_and", "bit_or", "bit_xor", "unary_minus", "not_op", "log_and", "log_or",
+        "intToFloat", "floatToInt", "call", "jmp", "phi", "select"};
+
+    std::string s = names[op];
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        s += (i == 0 ? " " : ", ") + params[i].toString();
+        if (op == phi && i > 0)
+        {
+            s += " [" + phi_preds[i - 1]->label + "]";
+        }
+    }
+    return s;
+}
+
+std::vector<std::string> IRInstr::lower_params()
+{
+    std::vector<std::string> asmParams;
+    int arrayIndex = array_param_index();
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        if ((int)i == arrayIndex)
+        {
+            // The backends address the elements of an array from the offset of its base
+            asmParams.push_back(std::to_string(bb->cfg->get_vreg(params[i].id).offset));
+        }
+        else
+        {
+            asmParams.push_back(bb->cfg->IR_reg_to_asm(params[i]));
+        }
+    }
+
+    // The code generators may look at optional operands
+    while (asmParams.size() < 3)
+    {
+        asmParams.push_back("");
+    }
+    return asmParams;
+}
+
 
 /* ---------------------- BasicBlock ---------------------- */
 
 BasicBlock::BasicBlock(CFG *cfg, std::string entry_label)
-    : cfg(cfg), label(entry_label), exit_true(nullptr), exit_false(nullptr)
+    : exit_true(nullptr), exit_false(nullptr), label(entry_label), cfg(cfg)
 {
 }
 
+void BasicBlock::add_IRInstr(IRInstr::Operation op, VarType t, std::vector<std::string> params)
+{
+    std::vector<IROperand> operands;
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        // call and jmp refer to a code label, not to a variable
+        if (i == 0 && (op == IRInstr::Operation::call || op == IRInstr::Operation::jmp))
+        {
+            operands.push_back(IROperand::makeLabel(params[i]));
+        }
+        else
+        {
+            operands.push_back(cfg->IR_operand(params[i], t));
+        }
+    }
+
+    if (op == IRInstr::Operation::copy && operands[1].isImm() && !Symbol::isFloatingType(operands[1].type))
+    {
+        op = IRInstr::Operation::ldconst;
+    }
+
+    IRInstr *instr = new IRInstr(this, op, t, operands);
+    instrs.push_back(instr);
+}
+
+std::vector<BasicBlock *> BasicBlock::successors()
+{
+    std::vector<BasicBlock *> succs;
+    if (exit_true != nullptr)
+    {
+        succs.push_back(exit_true);
+    }
+    if (exit_false != nullptr && exit_false != exit_true)
+    {
+        succs.push_back(exit_false);
+    }
+    return succs;
+}
+
 /* ---------------------- CFG ---------------------- */
 
 int CFG::nextBBnumber = 0;
@@ -33,6 +211,238 @@ CFG::CFG(DefFonction *ast) : ast(ast), current_bb(nullptr)
 void CFG::add_bb(BasicBlock *bb)
 {
     bbs.push_back(bb);
+    invalidate_analyses();
+}
+
+DominatorTree *CFG::get_dominators()
+{
+    if (dominators == nullptr)
+    {
+        dominators = new DominatorTree(this);
+    }
+    return dominators;
+}
+
+DominatorTree *CFG::get_post_dominators()
+{
+    if (postDominators == nullptr)
+    {
+        postDominators = new DominatorTree(this, true);
+    }
+    return postDominators;
+}
+
+LoopNest *CFG::get_loops()
+{
+    if (loops == nullptr)
+    {
+        loops = new LoopNest(this, get_dominators());
+    }
+    return loops;
+}
+
+void CFG::invalidate_analyses()
+{
+    delete dominators;
+    delete postDominators;
+    delete loops;
+    dominators = nullptr;
+    postDominators = nullptr;
+    loops = nullptr;
+}
+
+void CFG::compute_predecessors()
+{
+    for (BasicBlock *bb : bbs)
+    {
+        bb->preds.clear();
+    }
+    for (BasicBlock *bb : bbs)
+    {
+        for (BasicBlock *succ : bb->successors())
+        {
+            succ->preds.push_back(bb);
+        }
+    }
+}
+
+void CFG::find_fused_tests()
+{
+    // Le résultat d'une comparaison qui ne sert qu'au branchement n'a pas besoin d'être rangé
+    Liveness live(this);
+    for (BasicBlock *bb : bbs)
+    {
+        bb->fused_test = nullptr;
+        if (bb->exit_false == nullptr || bb->exit_true == bb->exit_false || !bb->test_var.isVreg() || bb->instrs.empty() ||
+            !live.reachable(bb) || live.isLiveOut(bb, bb->test_var.id))
+            continue;
+        IRInstr *last = bb->instrs.back();
+        if (last->op >= IRInstr::cmp_eq && last->op <= IRInstr::cmp_ge && last->t != VarType::FLOAT && last->params[0] == bb->test_var)
+            bb->fused_test = last;
+    }
+
+    // De même pour une comparaison qui ne sert qu'au select placé juste après elle
+    for (BasicBlock *bb : bbs)
+    {
+        for (size_t i = 0; i < bb->instrs.size(); i++)
+        {
+            IRInstr *instr = bb->instrs[i];
+            instr->fused_cmp = nullptr;
+            if (i == 0 || instr->op != IRInstr::select || !instr->params[1].isVreg() || !live.reachable(bb))
+                continue;
+            IRInstr *cmp = bb->instrs[i - 1];
+            IROperand c = instr->params[1];
+            if (cmp->op < IRInstr::cmp_eq || cmp->op > IRInstr::cmp_ge || cmp->t == VarType::FLOAT || !(cmp->params[0] == c) ||
+                cmp == bb->fused_test || instr->params[2] == c || instr->params[3] == c || bb->test_var == c || live.isLiveOut(bb, c.id))
+                continue;
+            bool usedAfter = false;
+            for (size_t j = i + 1; j < bb->instrs.size() && !usedAfter; j++)
+            {
+                for (int u : bb->instrs[j]->use_indices())
+                    usedAfter |= bb->instrs[j]->params[u] == c;
+            }
+            if (!usedAfter)
+                instr->fused_cmp = cmp;
+        }
+    }
+}
+
+void CFG::remove_unreachable_bbs()
+{
+    if (bbs.empty())
+    {
+        return;
+    }
+
+    // Parcours depuis le bloc d'entrée
+    std::set<BasicBlock *> reached = {bbs[0]};
+    std::vector<BasicBlock *> worklist = {bbs[0]};
+    while (!worklist.empty())
+    {
+        BasicBlock *bb = worklist.back();
+        worklist.pop_back();
+        for (BasicBlock *succ : bb->successors())
+        {
+            if (reached.insert(succ).second)
+            {
+                worklist.push_back(succ);
+            }
+        }
+    }
+
+    std::vector<BasicBlock *> kept;
+    for (BasicBlock *bb : bbs)
+    {
+        if (reached.count(bb))
+        {
+            kept.push_back(bb);
+            continue;
+        }
+        if (bb == epilogue_bb)
+        {
+            epilogue_bb = nullptr;
+        }
+        for (IRInstr *instr : bb->instrs)
+        {
+            delete instr;
+        }
+        delete bb;
+    }
+    if (kept.size() != bbs.size())
+    {
+        // Les phi des blocs gardés perdent les opérandes venant des blocs supprimés
+        for (BasicBlock *bb : kept)
+        {
+            for (IRInstr *instr : bb->instrs)
+            {
+                if (instr->op != IRInstr::phi)
+                    break;
+                for (size_t i = instr->phi_preds.size(); i-- > 0;)
+                {
+                    if (reached.count(instr->phi_preds[i]) == 0)
+                    {
+                        instr->phi_preds.erase(instr->phi_preds.begin() + i);
+                        instr->params.erase(instr->params.begin() + i + 1);
+                    }
+                }
+            }
+        }
+        invalidate_analyses();
+    }
+    bbs = kept;
+    compute_predecessors();
+}
+
+BasicBlock *CFG::split_edge(BasicBlock *from, BasicBlock *to)
+{
+    BasicBlock *middle = new BasicBlock(this, new_BB_name());
+    middle->exit_true = to;
+    middle->preds = {from};
+    if (from->exit_true == to)
+    {
+        from->exit_true = middle;
+    }
+    if (from->exit_false == to)
+    {
+        from->exit_false = middle;
+    }
+
+    // Le nouveau bloc remplace 'from' parmi les prédécesseurs de 'to', y compris dans les phi
+    for (BasicBlock *&pred : to->preds)
+    {
+        if (pred == from)
+        {
+            pred = middle;
+        }
+    }
+    for (IRInstr *instr : to->instrs)
+    {
+        for (BasicBlock *&pred : instr->phi_preds)
+        {
+            if (pred == from)
+            {
+                pred = middle;
+            }
+        }
+    }
+
+    invalidate_analyses();
+
+    // Placé juste après 'from' pour garder l'ordre du code
+    for (size_t i = 0; i < bbs.size(); i++)
+    {
+        if (bbs[i] == from)
+        {
+            bbs.insert(bbs.begin() + i + 1, middle);
+            break;
+        }
+    }
+    return middle;
+}
+
+void CFG::dump(std::ostream &o)
+{
+    o << "function " << ast->getName() << "\n";
+    for (BasicBlock *bb : bbs)
+    {
+        o << bb->label << ":\n";
+        for (IRInstr *instr : bb->instrs)
+        {
+            o << "    " << instr->toString() << "\n";
+        }
+        if (bb->exit_false != nullptr)
+        {
+            o << "    br " << bb->test_var.toString() << ", " << bb->exit_true->label << ", " << bb->exit_false->label << "\n";
+        }
+        else if (bb->exit_true != nullptr)
+        {
+            o << "    br " << bb->exit_true->label << "\n";
+        }
+        else
+        {
+            o << "    ret\n";
+        }
+    }
 }
 
 int CFG::get_var_index(std::string name)
@@ -41,6 +451,49 @@ int CFG::get_var_index(std::string name)
     return s->offset;
 }
 
+IROperand CFG::IR_operand(std::string name, VarType t)
+{
+    if (name.empty())
+    {
+        return IROperand();
+    }
+
+    Symbol *p = currentScope->findVariable(name);
+    if (p == nullptr)
+    {
+        // Not a variable: either read-only data or a register of the calling convention
+        if (name[0] == '.')
+        {
+            return IROperand::makeGlobal(name, VarType::FLOAT);
+        }
+        return IROperand::makePreg(name, t);
+    }
+
+    if (p->isConstant())
+    {
+        return IROperand::makeImm(p->getCstValue(), p->getType());
+    }
+
+    if (p->scopeType == GLOBAL)
+    {
+        return IROperand::makeGlobal(name, p->getType());
+    }
+
+    if (p->vreg < 0)
+    {
+        p->vreg = new_vreg(p->getType(), p->size, name);
+        vregs[p->vreg].offset = p->offset;
+    }
+    return IROperand::makeVreg(p->vreg, p->getType());
+}
+
+int CFG::new_vreg(VarType type, int size, std::string name)
+{
+    int id = vregs.size();
+    vregs.push_back(VirtualRegister(name.empty() ? "v" + std::to_string(id) : name, type, size, -1));
+    return id;
+}
+
 std::string CFG::new_BB_name()
 {
     return ".BB" + std::to_string(nextBBnumber++);
@@ -51,9 +504,32 @@ std::string CFG::get_epilogue_label()
     return std::string(".Lepilogue") + "_" + ast->getName();
 }
 
+void CFG::allocate_stack_slots()
+{
+    int offset = frame_compacted ? 0 : currentScope->getCurrentDeclOffset();
+    for (VirtualRegister &vreg : vregs)
+    {
+        offset = std::max(offset, vreg.offset);
+    }
+
+    for (VirtualRegister &vreg : vregs)
+    {
+        if (vreg.offset < 0 && vreg.reg.empty())
+        {
+            offset += 4 * vreg.size;
+            vreg.offset = offset;
+        }
+    }
+}
+
 int CFG::getStackSize()
 {
-    return currentScope->getCurrentDeclOffset() / 16 * 16 + 16; // Round up to the next multiple of 16
+    int size = frame_compacted ? 0 : currentScope->getCurrentDeclOffset();
+    for (VirtualRegister &vreg : vregs)
+    {
+        size = std::max(size, vreg.offset);
+    }
+    return size / 16 * 16 + 16; // Round up to the next multiple of 16
 }
 
 /* ---------------------- GVM ---------------------- */
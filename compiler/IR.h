@@ -17,6 +17,62 @@
 class BasicBlock;
 class CFG;
 class RoDM;
+class DominatorTree;
+class LoopNest;
+
+/** An operand of an IR instruction.
+ *  Operands are resolved against the symbol table when the instruction is created,
+ *  but they are only lowered to an assembly operand (stack slot, register, immediate...)
+ *  by CFG::gen_asm, so that the passes can reason about the values they carry. */
+class IROperand {
+public:
+    typedef enum {
+        none,   /**< no operand (e.g. optional float data of unary_minus on an int) */
+        vreg,   /**< a virtual register: local variable, parameter, array or temporary of the function */
+        global, /**< a memory symbol accessed by name: global variable or read-only data */
+        imm,    /**< a typed immediate value, e.g. 3 or 1.500000 */
+        preg,   /**< a physical register imposed by the calling convention (arguments, return value) */
+        label   /**< a code label: called function or jump target */
+    } Kind;
+
+    IROperand() : kind(none), type(VarType::VOID), id(-1) {}
+    IROperand(Kind kind, VarType type, int id, std::string name) : kind(kind), type(type), id(id), name(name) {}
+
+    static IROperand makeVreg(int id, VarType type) { return IROperand(vreg, type, id, ""); }
+    static IROperand makeGlobal(std::string name, VarType type) { return IROperand(global, type, -1, name); }
+    static IROperand makeImm(std::string value, VarType type) { return IROperand(imm, type, -1, value); }
+    static IROperand makePreg(std::string name, VarType type) { return IROperand(preg, type, -1, name); }
+    static IROperand makeLabel(std::string name) { return IROperand(label, VarType::VOID, -1, name); }
+
+    bool isVreg() const { return kind == vreg; }
+    bool isImm() const { return kind == imm; }
+    bool isNone() const { return kind == none; }
+
+    bool operator==(const IROperand &other) const { return kind == other.kind && id == other.id && name == other.name; }
+    bool operator!=(const IROperand &other) const { return !(*this == other); }
+    bool operator<(const IROperand &other) const;
+
+    std::string toString() const; /**< textual form used in IR dumps, e.g. "%v3", "$3", "@g" */
+
+    Kind kind;
+    VarType type;
+    int id;           /**< number of the virtual register, -1 for the other kinds */
+    std::string name; /**< symbol, register or label name, or value of an immediate */
+};
+
+/** The properties of one virtual register of a CFG */
+class VirtualRegister {
+public:
+    VirtualRegister(std::string name, VarType type, int size, int offset) : name(name), type(type), size(size), offset(offset) {}
+
+    bool isArray() { return Symbol::isPointerType(type); }
+
+    std::string name; /**< source-level name, for dumps and diagnostics */
+    VarType type;
+    int size;         /**< number of elements for an array, 1 otherwise */
+    int offset;       /**< stack slot (offset below %rbp / fp), -1 until the frame is laid out, 0 if the value needs none */
+    std::string reg;  /**< physical register given by the register allocator, empty if the value lives in its stack slot */
+};
 
 //! The class for one 3-address instruction
 class IRInstr {
@@ -37,6 +93,7 @@ public:
         divTblx,
         modTblx,
         getTblx,
+        addrTblx,
         incr,
         decr,
         rmem,
@@ -57,20 +114,32 @@ public:
         intToFloat,
         floatToInt,
         call,
-        jmp
+        jmp,
+        phi,
+        select
     } Operation;
 
     /**  constructor */
-    IRInstr(BasicBlock* bb_, Operation op, VarType t, std::vector<std::string> params);
+    IRInstr(BasicBlock* bb_, Operation op, VarType t, std::vector<IROperand> params);
 
     /** Actual code generation */
     void gen_asm(std::ostream &o); /**< x86 assembly code generation for this IR instruction */
+    std::vector<std::string> lower_params(); /**< lowers the operands to assembly operands of the target */
+
+    int array_param_index(); /**< index of the operand holding the array base of a *Tblx instruction, -1 otherwise */
+    int def_index(); /**< index of the operand written by this instruction, -1 if it writes no operand */
+    std::vector<int> use_indices(); /**< indices of the operands read by this instruction */
+    std::string toString(); /**< textual form used in IR dumps */
 
-private:
     BasicBlock* bb; /**< The BB this instruction belongs to, which provides a pointer to the CFG this instruction belongs to */
     Operation op;
     VarType t;
-    std::vector<std::string> params; /**< For 3-op instrs: d, x, y; for ldconst: d, c;  For call: label, d, params;  for wmem and rmem: choose yourself */
+    std::vector<IROperand> params; /**< For 3-op instrs: d, x, y; for ldconst: d, c;  For call: label, d;  for *Tblx: array, value, index; for getTblx and addrTblx: d, array, index; for rmem: d, address, displacement; for wmem: address, value, displacement; for phi: d, x1, ..., xn; for select: d, c, x, y (d = c ? x : y) */
+    std::vector<BasicBlock*> phi_preds; /**< for phi: the predecessor params[i + 1] comes from */
+    bool tail_call = false;       /**< for call: last instruction of a block without successor, gen_asm tears the frame down
+                                       and jumps to the callee instead of returning (TailCalls.cpp) */
+    IRInstr* fused_cmp = nullptr; /**< for select: comparison computing the condition right before it, read by nothing else:
+                                       gen_asm emits it with the select (cmp + cmovcc, csel), see CFG::find_fused_tests */
 };
 
 
@@ -80,9 +149,10 @@ private:
 class BasicBlock {
 public:
     BasicBlock(CFG* cfg, std::string entry_label);
-    void gen_asm(std::ostream &o); /**< x86 assembly code generation for this basic block (very simple) */
+    void gen_asm(std::ostream &o, BasicBlock* next = nullptr); /**< x86 assembly code generation for this basic block; next is the block emitted right after it, reached by falling through */
 
-    void add_IRInstr(IRInstr::Operation op, VarType t, std::vector<std::string> params);
+    void add_IRInstr(IRInstr::Operation op, VarType t, std::vector<std::string> params); /**< resolves the names in the current scope */
+    std::vector<BasicBlock*> successors(); /**< exit_true then exit_false, without duplicates */
 
     BasicBlock* exit_true;  /**< pointer to the next basic block, true branch. If nullptr, return from procedure */ 
     BasicBlock* exit_false; /**< pointer to the next basic block, false branch. If nullptr, the basic block ends with an unconditional jump */
@@ -91,7 +161,11 @@ public:
     std::vector<IRInstr*> instrs; /** < the instructions themselves. */
     std::string test_var_name;  /**< when generating IR code for an if(expr) or while(expr) etc,
                                      store here the name of the variable that holds the value of expr */
-    std::string test_var_register;  /**< type of the variable that holds the value of expr */
+    IROperand test_var;  /**< the operand that holds the value of expr */
+    std::vector<BasicBlock*> preds; /**< the predecessors of the block, filled by CFG::compute_predecessors */
+    IRInstr* fused_test = nullptr;  /**< comparison computing test_var at the end of the block, read by nothing else:
+                                         gen_asm emits it with the branch (cmp + jcc), see CFG::find_fused_tests */
+    bool aligned = false;           /**< loop header: gen_asm aligns its label (.p2align), set by the layout pass */
 };
 
 
@@ -105,16 +179,41 @@ public:
     DefFonction* ast; /**< The AST this CFG comes from */
 
     void add_bb(BasicBlock* bb);
+    std::vector<BasicBlock*>& get_bbs() { return bbs; }
+    BasicBlock* split_edge(BasicBlock* from, BasicBlock* to); /**< inserts an empty block on the edge from -> to and returns it */
+    void compute_predecessors();
+    void remove_unreachable_bbs();
+    void dump(std::ostream& o); /**< prints the IR of the function, for debugging */
+
+    // analyses, computed on demand and cached until the blocks or their edges change
+    DominatorTree* get_dominators();
+    DominatorTree* get_post_dominators();
+    LoopNest* get_loops();
+    void invalidate_analyses(); /**< must be called by a pass that rewires exit_true/exit_false by hand */
+    BasicBlock* ensure_preheader(BasicBlock* header); /**< returns the preheader of the loop of header, inserted before it if there is none (Loops.cpp) */
+
+    // SSA form (SSA.cpp)
+    void to_ssa();   /**< places the phi nodes and renames the scalar local variables */
+    void from_ssa(); /**< replaces the phi nodes by copies in the predecessors */
+    bool in_ssa = false;
 
     // x86 code generation: could be encapsulated in a processor class in a retargetable compiler
     void gen_asm(std::ostream& o);
-    std::string IR_reg_to_asm(std::string& reg, bool ignoreCst = false); /**< helper method: inputs a IR reg or input variable, returns e.g. "-24(%rbp)" for the proper value of 24 */
+    std::string IR_reg_to_asm(const IROperand& reg); /**< helper method: inputs an IR operand, returns e.g. "-24(%rbp)" for the proper value of 24 */
     void gen_asm_prologue(std::ostream& o);
-    void gen_asm_epilogue(std::ostream& o);
+    void gen_asm_epilogue(std::ostream& o, std::string tailCallee = ""); /**< restores the frame and returns, or jumps to tailCallee */
+    void gen_asm_memo(std::ostream& o); /**< entry of a memoized function: looks the argument up in its table, runs the body on a miss */
     std::string get_epilogue_label();  /**< returns the label of the epilogue */
+    void find_fused_tests(); /**< sets fused_test on the blocks whose test is a comparison dead after the branch, and fused_cmp on the selects */
 
     // symbol table methods: désormais déléguées à SymbolTable
     int get_var_index(std::string name);
+    IROperand IR_operand(std::string name, VarType t = VarType::VOID); /**< resolves a name of the current scope to an IR operand */
+
+    // virtual registers
+    int new_vreg(VarType type, int size = 1, std::string name = ""); /**< returns the number of a fresh virtual register */
+    VirtualRegister& get_vreg(int id) { return vregs[id]; }
+    int get_vreg_count() { return vregs.size(); }
 
     // basic block management
     std::string new_BB_name();
@@ -123,8 +222,14 @@ public:
     // On remplace ces membres par notre instance de SymbolTable
     SymbolTable* currentScope = nullptr; /**< the symbol table of the current scope */
     int getStackSize();
+    void allocate_stack_slots(); /**< gives a stack slot to the virtual registers created by the passes */
+    bool frame_compacted = false; /**< set by the stack-coloring pass: the offsets of the vregs, no longer the symbol table, bound the frame */
+
+    std::vector<std::pair<std::string, int>> saved_regs; /**< callee-saved registers used by the register allocator, with the vreg of their save slot */
 
-    static bool isRegConstant(std::string& reg);
+    BasicBlock* epilogue_bb = nullptr; /**< the last block of the function: the return statements jump to it */
+    std::string return_var; /**< the variable holding the return value, empty for a void function */
+    int memo_size = 0; /**< -fmemoize: entries of the table of results checked before the body, 0 if not memoized (PureCalls.cpp) */
 
     // Read-Only Data Manager
     RoDM* rodm = nullptr; /**< the read-only data manager */
@@ -132,6 +237,11 @@ public:
 protected:
     static int nextBBnumber; /**< just for naming */
     std::vector<BasicBlock*> bbs; /**< all the basic blocks of this CFG*/
+    std::vector<VirtualRegister> vregs; /**< all the virtual registers of this CFG, indexed by number */
+
+    DominatorTree* dominators = nullptr;
+    DominatorTree* postDominators = nullptr;
+    LoopNest* loops = nullptr;
 };
 
 
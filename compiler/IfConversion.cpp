@@ -0,0 +1,264 @@
+#include "Passes.h"
+#include <algorithm>
+using namespace std;
+
+// Conversion des petits if en select (cmov sur x86-64, csel/fcsel sur ARM64), sur la forme SSA.
+// Un branchement dont les deux côtés se rejoignent aussitôt, en losange (if/else) ou en triangle (if sans
+// else), est remplacé par le calcul des deux côtés dans le bloc du test, suivi d'un select par phi de la
+// jonction. Les deux côtés sont alors toujours exécutés: seules les instructions sans effet de bord et qui
+// ne peuvent pas faire planter le programme (pas de division, d'accès mémoire ni d'appel) sont acceptées,
+// et la conversion n'est faite que si le coût des deux côtés et des select reste sous un seuil.
+
+namespace
+{
+
+const int maxConvertedCost = 8; /**< speculated instructions plus selects of a converted if */
+
+bool isSpeculatable(IRInstr *instr)
+{
+    for (const IROperand &o : instr->params)
+    {
+        if (o.kind == IROperand::preg)
+            return false; // arguments et valeur de retour d'un appel
+    }
+    // Seules les valeurs SSA sont calculées d'avance: une globale n'est pas renommée, l'écrire est un accès mémoire
+    int d = instr->def_index();
+    if (d < 0 || !instr->params[d].isVreg())
+    {
+        return false;
+    }
+    switch (instr->op)
+    {
+    case IRInstr::ldconst:
+    case IRInstr::copy:
+    case IRInstr::add:
+    case IRInstr::sub:
+    case IRInstr::mul:
+    case IRInstr::cmp_eq:
+    case IRInstr::cmp_ne:
+    case IRInstr::cmp_lt:
+    case IRInstr::cmp_le:
+    case IRInstr::cmp_gt:
+    case IRInstr::cmp_ge:
+    case IRInstr::bit_and:
+    case IRInstr::bit_or:
+    case IRInstr::bit_xor:
+    case IRInstr::unary_minus:
+    case IRInstr::not_op:
+    case IRInstr::log_and:
+    case IRInstr::log_or:
+    case IRInstr::intToFloat:
+    case IRInstr::floatToInt:
+    case IRInstr::select:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Le test déplacé après les côtés est tenu aux mêmes règles qu'eux: une comparaison de valeurs SSA, jamais
+// un phi ni la lecture d'un registre physique que les côtés pourraient écraser
+bool isMovableTest(IRInstr *instr)
+{
+    return instr->op >= IRInstr::cmp_eq && instr->op <= IRInstr::cmp_ge && isSpeculatable(instr);
+}
+
+bool isSelectable(VarType t)
+{
+    return t == VarType::INT || t == VarType::CHAR || t == VarType::FLOAT || t == VarType::ADDRESS;
+}
+
+class IfConversion
+{
+public:
+    IfConversion(CFG *cfg, BasicBlock *bb) : cfg(cfg), bb(bb) {}
+    bool run();
+
+private:
+    bool findShape();
+    bool canSpeculate(BasicBlock *side);
+
+    CFG *cfg;
+    BasicBlock *bb;                 /**< block ending with the branch */
+    BasicBlock *join = nullptr;
+    BasicBlock *fromTrue = nullptr; /**< predecessor of join on the true path: the then block, or bb */
+    vector<BasicBlock *> sides;     /**< blocks executed only on one path, run unconditionally after the conversion */
+};
+
+// Côté d'un branchement: un bloc atteint seulement depuis bb, qui saute sans condition vers la jonction
+bool IfConversion::canSpeculate(BasicBlock *side)
+{
+    if (side == bb || side->preds.size() != 1 || side->exit_false != nullptr || side->exit_true == nullptr)
+    {
+        return false;
+    }
+    return all_of(side->instrs.begin(), side->instrs.end(), isSpeculatable);
+}
+
+bool IfConversion::findShape()
+{
+    BasicBlock *ifTrue = bb->exit_true;
+    BasicBlock *ifFalse = bb->exit_false;
+    if (canSpeculate(ifTrue) && canSpeculate(ifFalse) && ifTrue->exit_true == ifFalse->exit_true)
+    {
+        // Losange: if (c) { ... } else { ... }
+        join = ifTrue->exit_true;
+        fromTrue = ifTrue;
+        sides = {ifTrue, ifFalse};
+    }
+    else if (canSpeculate(ifTrue) && ifTrue->exit_true == ifFalse)
+    {
+        // Triangle: if (c) { ... }
+        join = ifFalse;
+        fromTrue = ifTrue;
+        sides = {ifTrue};
+    }
+    else if (canSpeculate(ifFalse) && ifFalse->exit_true == ifTrue)
+    {
+        join = ifTrue;
+        fromTrue = bb;
+        sides = {ifFalse};
+    }
+    else
+    {
+        return false;
+    }
+    // La jonction ne doit être atteinte que par les deux chemins: ses phi deviennent des select
+    return join != bb && join->preds.size() == 2;
+}
+
+bool IfConversion::run()
+{
+    if (bb->exit_false == nullptr || bb->exit_true == bb->exit_false || !bb->test_var.isVreg() || !findShape())
+    {
+        return false;
+    }
+    int cost = 0;
+    for (BasicBlock *side : sides)
+    {
+        cost += side->instrs.size();
+    }
+    for (IRInstr *instr : join->instrs)
+    {
+        if (instr->op != IRInstr::phi)
+            break;
+        if (!isSelectable(instr->t))
+            return false;
+        cost++;
+    }
+    if (cost > maxConvertedCost)
+    {
+        return false;
+    }
+
+    // Le calcul de la condition passe après celui des côtés, juste avant les select: la génération de
+    // code les fusionne alors (cmp + cmov)
+    IRInstr *test = bb->instrs.empty() ? nullptr : bb->instrs.back();
+    if (test != nullptr && (!isMovableTest(test) || !(test->params[0] == bb->test_var)))
+        test = nullptr;
+    for (BasicBlock *side : sides)
+    {
+        for (IRInstr *instr : side->instrs)
+        {
+            for (int u : instr->use_indices())
+            {
+                if (instr->params[u] == bb->test_var)
+                    test = nullptr;
+            }
+        }
+    }
+    if (test != nullptr)
+        bb->instrs.pop_back();
+    for (BasicBlock *side : sides)
+    {
+        for (IRInstr *instr : side->instrs)
+        {
+            instr->bb = bb;
+            bb->instrs.push_back(instr);
+        }
+        side->instrs.clear();
+    }
+    if (test != nullptr)
+        bb->instrs.push_back(test);
+    vector<IRInstr *> rest;
+    for (IRInstr *instr : join->instrs)
+    {
+        if (instr->op != IRInstr::phi)
+        {
+            rest.push_back(instr);
+            continue;
+        }
+        IROperand x, y;
+        for (size_t k = 0; k < instr->phi_preds.size(); k++)
+        {
+            (instr->phi_preds[k] == fromTrue ? x : y) = instr->params[k + 1];
+        }
+        bb->instrs.push_back(new IRInstr(bb, IRInstr::select, instr->t, {instr->params[0], bb->test_var, x, y}));
+        delete instr;
+    }
+    join->instrs = rest;
+
+    // bb est maintenant le seul prédécesseur de la jonction, qu'il absorbe (sauf l'épilogue, qui reste le dernier bloc)
+    bb->test_var = IROperand();
+    bb->test_var_name.clear();
+    if (join == cfg->epilogue_bb)
+    {
+        bb->exit_true = join;
+        bb->exit_false = nullptr;
+    }
+    else
+    {
+        for (IRInstr *instr : join->instrs)
+        {
+            instr->bb = bb;
+            bb->instrs.push_back(instr);
+        }
+        join->instrs.clear();
+        bb->exit_true = join->exit_true;
+        bb->exit_false = join->exit_false;
+        bb->test_var = join->test_var;
+        bb->test_var_name = join->test_var_name;
+        for (BasicBlock *succ : join->successors())
+        {
+            for (IRInstr *instr : succ->instrs)
+            {
+                if (instr->op != IRInstr::phi)
+                    break;
+                replace(instr->phi_preds.begin(), instr->phi_preds.end(), join, bb);
+            }
+        }
+        join->exit_true = nullptr;
+        join->exit_false = nullptr;
+    }
+    cfg->invalidate_analyses();
+    cfg->remove_unreachable_bbs();
+    cfg->compute_predecessors();
+    return true;
+}
+
+} // namespace
+
+void IfConversionPass::runOnFunction(CFG *cfg)
+{
+    if (!cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // les valeurs des deux côtés sont lues dans les phi de la jonction
+    }
+
+    // Un if converti, fusionné avec sa jonction, peut faire d'un if englobant un losange à son tour
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        cfg->compute_predecessors();
+        vector<BasicBlock *> bbs = cfg->get_bbs();
+        for (BasicBlock *bb : bbs)
+        {
+            if (IfConversion(cfg, bb).run())
+            {
+                changed = true;
+                break;
+            }
+        }
+    }
+}
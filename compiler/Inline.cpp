@@ -0,0 +1,296 @@
+#include "Passes.h"
+#include <map>
+#include <set>
+#include <functional>
+#include <algorithm>
+using namespace std;
+
+// Intégration des fonctions (inlining), avant la mise en SSA: un appel est remplacé par une copie des
+// blocs de la fonction appelée. Les arguments sont copiés directement dans les copies des paramètres,
+// au lieu de passer par les registres de la convention d'appel, et la valeur de retour dans le
+// temporaire qui recevait le registre de retour. Le corps intégré est ensuite optimisé avec l'appelant.
+// Les fonctions sont traitées des appelées vers les appelantes, pour intégrer des fonctions déjà
+// simplifiées; une fonction récursive (directement ou non) n'est jamais intégrée.
+
+namespace
+{
+
+const int maxInlinedSize = 30;      /**< instructions of a function inlined at every call site */
+const int maxCalledOnceSize = 150;  /**< instructions of a function inlined at its only call site */
+const int maxCallerSize = 2000;     /**< instructions a caller can reach by inlining */
+
+int sizeOf(CFG *cfg)
+{
+    int size = 0;
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        size += bb->instrs.size();
+    }
+    return size;
+}
+
+class Inliner
+{
+public:
+    Inliner(vector<CFG *> &cfgs);
+    void run();
+
+private:
+    void analyzeCallGraph();
+    bool isInlinable(CFG *callee);
+    BasicBlock *inlineCall(CFG *caller, BasicBlock *bb, IRInstr *call); /**< returns the block of the code after the call, nullptr if the call is kept */
+
+    map<string, CFG *> functions;
+    map<CFG *, set<CFG *>> callees; /**< the call graph */
+    map<CFG *, int> callSites;      /**< number of calls to each function in the program */
+    set<CFG *> recursive;
+    vector<CFG *> bottomUp;         /**< callees before their callers */
+};
+
+Inliner::Inliner(vector<CFG *> &cfgs)
+{
+    for (CFG *cfg : cfgs)
+    {
+        functions[cfg->ast->getName()] = cfg;
+    }
+    for (CFG *cfg : cfgs)
+    {
+        for (BasicBlock *bb : cfg->get_bbs())
+        {
+            for (IRInstr *instr : bb->instrs)
+            {
+                if (instr->op != IRInstr::call || !functions.count(instr->params[0].name))
+                    continue;
+                CFG *callee = functions[instr->params[0].name];
+                callees[cfg].insert(callee);
+                callSites[callee]++;
+            }
+        }
+    }
+    analyzeCallGraph();
+}
+
+// Ordre des appelées vers les appelantes (parcours en profondeur du graphe d'appel), et fonctions récursives:
+// celles atteintes depuis elles-mêmes
+void Inliner::analyzeCallGraph()
+{
+    set<CFG *> visited;
+    function<void(CFG *)> visit = [&](CFG *cfg) {
+        visited.insert(cfg);
+        for (CFG *callee : callees[cfg])
+        {
+            if (!visited.count(callee))
+                visit(callee);
+        }
+        bottomUp.push_back(cfg);
+    };
+    for (auto &[name, cfg] : functions)
+    {
+        if (!visited.count(cfg))
+            visit(cfg);
+    }
+
+    for (auto &[name, cfg] : functions)
+    {
+        set<CFG *> reached;
+        vector<CFG *> worklist(callees[cfg].begin(), callees[cfg].end());
+        while (!worklist.empty())
+        {
+            CFG *f = worklist.back();
+            worklist.pop_back();
+            if (!reached.insert(f).second)
+                continue;
+            for (CFG *callee : callees[f])
+                worklist.push_back(callee);
+        }
+        if (reached.count(cfg))
+            recursive.insert(cfg);
+    }
+}
+
+bool Inliner::isInlinable(CFG *callee)
+{
+    if (recursive.count(callee) || callee->get_bbs().empty() || callee->epilogue_bb == nullptr)
+    {
+        return false;
+    }
+    int size = sizeOf(callee);
+    return size <= maxInlinedSize || (callSites[callee] == 1 && size <= maxCalledOnceSize);
+}
+
+BasicBlock *Inliner::inlineCall(CFG *caller, BasicBlock *bb, IRInstr *call)
+{
+    CFG *callee = functions[call->params[0].name];
+    size_t nbParams = callee->ast->getParameters().size();
+    BasicBlock *entry = callee->get_bbs()[0];
+
+    // Le bloc d'entrée de la fonction appelée commence par la copie des paramètres depuis leurs registres
+    if (entry->instrs.size() < nbParams)
+    {
+        return nullptr;
+    }
+    for (size_t i = 0; i < nbParams; i++)
+    {
+        IRInstr *instr = entry->instrs[i];
+        if (instr->op != IRInstr::copy || instr->params[1].kind != IROperand::preg || !instr->params[0].isVreg())
+            return nullptr;
+    }
+    auto at = find(bb->instrs.begin(), bb->instrs.end(), call);
+    size_t index = at - bb->instrs.begin();
+
+    // Les copies des arguments dans leurs registres (copy ou ldconst), entre l'appel précédent et celui-ci
+    vector<IRInstr *> argCopies(nbParams, nullptr);
+    for (size_t k = index; k-- > 0;)
+    {
+        IRInstr *instr = bb->instrs[k];
+        if (instr->op == IRInstr::call)
+            break;
+        bool toRegister = (instr->op == IRInstr::copy || instr->op == IRInstr::ldconst) && instr->params[0].kind == IROperand::preg;
+        if (!toRegister)
+            continue;
+        for (size_t i = 0; i < nbParams; i++)
+        {
+            if (argCopies[i] == nullptr && instr->params[0].name == entry->instrs[i]->params[1].name)
+                argCopies[i] = instr;
+        }
+    }
+    for (IRInstr *copy : argCopies)
+    {
+        if (copy == nullptr)
+            return nullptr; // appel avec moins d'arguments que de paramètres
+    }
+
+    // Copie des registres virtuels utilisés et des blocs de la fonction appelée
+    map<int, int> values;
+    auto mapped = [&](IROperand o) {
+        if (!o.isVreg())
+            return o;
+        if (!values.count(o.id))
+        {
+            VirtualRegister &v = callee->get_vreg(o.id);
+            values[o.id] = caller->new_vreg(v.type, v.size, v.name);
+        }
+        return IROperand::makeVreg(values[o.id], o.type);
+    };
+    map<BasicBlock *, BasicBlock *> blocks;
+    for (BasicBlock *block : callee->get_bbs())
+    {
+        blocks[block] = new BasicBlock(caller, caller->new_BB_name());
+    }
+
+    // La suite de l'appel part dans un nouveau bloc, qui reprend les sorties de bb
+    BasicBlock *after = new BasicBlock(caller, caller->new_BB_name());
+    IROperand result;
+    size_t next = index + 1;
+    if (next < bb->instrs.size() && bb->instrs[next]->op == IRInstr::copy && bb->instrs[next]->params[1].kind == IROperand::preg)
+    {
+        result = bb->instrs[next]->params[0];
+        delete bb->instrs[next];
+        next++;
+    }
+    for (size_t k = next; k < bb->instrs.size(); k++)
+    {
+        bb->instrs[k]->bb = after;
+        after->instrs.push_back(bb->instrs[k]);
+    }
+    bb->instrs.resize(index);
+    delete call;
+    after->exit_true = bb->exit_true;
+    after->exit_false = bb->exit_false;
+    after->test_var = bb->test_var;
+    after->test_var_name = bb->test_var_name;
+
+    for (size_t i = 0; i < nbParams; i++)
+    {
+        argCopies[i]->params[0] = mapped(entry->instrs[i]->params[0]);
+    }
+    for (BasicBlock *block : callee->get_bbs())
+    {
+        BasicBlock *copy = blocks[block];
+        for (size_t k = (block == entry ? nbParams : 0); k < block->instrs.size(); k++)
+        {
+            IRInstr *instr = block->instrs[k];
+            bool returns = block == callee->epilogue_bb && instr->op == IRInstr::copy && instr->params[0].kind == IROperand::preg;
+            if (returns && result.isNone())
+                continue; // valeur de retour ignorée
+            vector<IROperand> params;
+            for (const IROperand &o : instr->params)
+                params.push_back(mapped(o));
+            if (returns)
+                params[0] = result;
+            copy->instrs.push_back(new IRInstr(copy, instr->op, instr->t, params));
+        }
+        copy->exit_true = block->exit_true == nullptr ? after : blocks[block->exit_true];
+        copy->exit_false = block->exit_false == nullptr ? nullptr : blocks[block->exit_false];
+        copy->test_var = mapped(block->test_var);
+        copy->test_var_name = block->test_var_name;
+    }
+    bb->exit_true = blocks[entry];
+    bb->exit_false = nullptr;
+    bb->test_var = IROperand();
+    bb->test_var_name.clear();
+
+    vector<BasicBlock *> &bbs = caller->get_bbs();
+    vector<BasicBlock *> inserted;
+    for (BasicBlock *block : callee->get_bbs())
+    {
+        inserted.push_back(blocks[block]);
+    }
+    inserted.push_back(after);
+    bbs.insert(find(bbs.begin(), bbs.end(), bb) + 1, inserted.begin(), inserted.end());
+    return after;
+}
+
+void Inliner::run()
+{
+    for (CFG *caller : bottomUp)
+    {
+        // Les appels présents avant l'intégration: ceux des corps intégrés ont déjà été refusés
+        vector<pair<BasicBlock *, IRInstr *>> calls;
+        for (BasicBlock *bb : caller->get_bbs())
+        {
+            for (IRInstr *instr : bb->instrs)
+            {
+                if (instr->op == IRInstr::call && functions.count(instr->params[0].name))
+                    calls.push_back({bb, instr});
+            }
+        }
+
+        // Une suite d'appels dans un même bloc se retrouve dans les blocs créés par la découpe
+        map<IRInstr *, BasicBlock *> blockOf;
+        for (auto &[bb, call] : calls)
+        {
+            blockOf[call] = bb;
+        }
+        bool changed = false;
+        for (auto &[bb, call] : calls)
+        {
+            CFG *callee = functions[call->params[0].name];
+            if (callee == caller || !isInlinable(callee) || sizeOf(caller) + sizeOf(callee) > maxCallerSize)
+                continue;
+            BasicBlock *after = inlineCall(caller, blockOf[call], call);
+            if (after == nullptr)
+                continue;
+            changed = true;
+            // Les appels suivants du bloc découpé sont maintenant dans son dernier morceau
+            for (IRInstr *instr : after->instrs)
+            {
+                if (blockOf.count(instr))
+                    blockOf[instr] = after;
+            }
+        }
+        if (changed)
+        {
+            caller->invalidate_analyses();
+            caller->remove_unreachable_bbs();
+            caller->compute_predecessors();
+        }
+    }
+}
+
+} // namespace
+
+void InliningPass::run(vector<CFG *> &cfgs)
+{
+    Inliner(cfgs).run();
+}
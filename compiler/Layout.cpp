@@ -0,0 +1,112 @@
+#include "Passes.h"
+#include "Loops.h"
+#include <set>
+#include <algorithm>
+using namespace std;
+
+// Placement des blocs avant la génération de code: chaque bloc est suivi, quand c'est possible, de son
+// successeur le plus probable, atteint sans saut (gen_asm omet le saut vers le bloc qui suit). Un branchement
+// préfère le successeur qui reste dans la boucle, ou qui y entre, à celui qui en sort, et sinon sa branche
+// vraie (le then d'un if, le corps d'un while). L'épilogue est placé en dernier: les blocs qui y sautent
+// sans le précéder en reçoivent une copie s'il est petit, et finissent par leur propre ret.
+// Les en-têtes de boucle sont marqués pour que leur étiquette soit alignée.
+
+namespace
+{
+
+const size_t maxDuplicatedEpilogueSize = 2; /**< IR instructions of an epilogue copied into the blocks returning to it */
+
+class BlockLayout
+{
+public:
+    BlockLayout(CFG *cfg) : cfg(cfg) {}
+    void run();
+
+private:
+    BasicBlock *likelySuccessor(BasicBlock *bb); /**< the successor bb should fall through to, nullptr if none is free */
+    void chainBlocks();
+    void duplicateEpilogue();
+
+    CFG *cfg;
+    set<BasicBlock *> placed;
+};
+
+BasicBlock *BlockLayout::likelySuccessor(BasicBlock *bb)
+{
+    LoopNest *loops = cfg->get_loops();
+    BasicBlock *best = nullptr;
+    for (BasicBlock *succ : bb->successors())
+    {
+        if (placed.count(succ) || succ == cfg->epilogue_bb)
+            continue;
+        // exit_true vient en premier: il n'est remplacé que par un successeur plus profond dans les boucles
+        if (best == nullptr || loops->depth(succ) > loops->depth(best))
+            best = succ;
+    }
+    return best;
+}
+
+void BlockLayout::chainBlocks()
+{
+    vector<BasicBlock *> &bbs = cfg->get_bbs();
+    vector<BasicBlock *> order;
+    // Une chaîne commence au premier bloc libre dans l'ordre de création, le bloc d'entrée d'abord
+    for (BasicBlock *start : bbs)
+    {
+        for (BasicBlock *bb = start; bb != nullptr && !placed.count(bb) && bb != cfg->epilogue_bb;
+             bb = likelySuccessor(bb))
+        {
+            placed.insert(bb);
+            order.push_back(bb);
+        }
+    }
+    if (cfg->epilogue_bb != nullptr)
+    {
+        order.push_back(cfg->epilogue_bb);
+    }
+    bbs = order;
+}
+
+void BlockLayout::duplicateEpilogue()
+{
+    BasicBlock *epilogue = cfg->epilogue_bb;
+    if (epilogue == nullptr || epilogue->exit_true != nullptr || epilogue->instrs.size() > maxDuplicatedEpilogueSize)
+    {
+        return;
+    }
+    vector<BasicBlock *> &bbs = cfg->get_bbs();
+    for (size_t i = 0; i + 1 < bbs.size(); i++)
+    {
+        BasicBlock *bb = bbs[i];
+        // Le bloc placé juste avant l'épilogue y arrive sans saut
+        if (bb->exit_true != epilogue || bb->exit_false != nullptr || bbs[i + 1] == epilogue)
+            continue;
+        for (IRInstr *instr : epilogue->instrs)
+            bb->instrs.push_back(new IRInstr(bb, instr->op, instr->t, instr->params));
+        bb->exit_true = nullptr;
+    }
+    cfg->invalidate_analyses();
+    cfg->remove_unreachable_bbs();
+}
+
+void BlockLayout::run()
+{
+    chainBlocks();
+    duplicateEpilogue();
+    cfg->compute_predecessors();
+    for (Loop *loop : cfg->get_loops()->loops())
+    {
+        loop->header->aligned = true;
+    }
+}
+
+} // namespace
+
+void BlockLayoutPass::runOnFunction(CFG *cfg)
+{
+    if (cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // les copies de l'épilogue ne sont pas des phi
+    }
+    BlockLayout(cfg).run();
+}
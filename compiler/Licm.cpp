@@ -0,0 +1,208 @@
+#include "Passes.h"
+#include "Loops.h"
+#include <set>
+#include <map>
+using namespace std;
+
+// Déplacement des calculs invariants hors des boucles, vers le bloc d'entrée (preheader) de la boucle.
+// Le preheader s'exécute même si la boucle ne fait aucun tour: on n'y déplace que des instructions sans
+// effet de bord qui ne peuvent pas faire échouer le programme (pas de division par une valeur inconnue,
+// pas de lecture de tableau hors de ses bornes).
+
+namespace
+{
+
+/** What the blocks of a loop write: the vregs they define, the arrays and globals they store to */
+struct LoopEffects
+{
+    set<int> defined;
+    set<int> writtenArrays;
+    set<string> writtenGlobals;
+    bool hasCall = false;
+
+    LoopEffects(Loop *loop)
+    {
+        for (BasicBlock *bb : loop->blocks)
+        {
+            for (IRInstr *instr : bb->instrs)
+            {
+                hasCall |= instr->op == IRInstr::call;
+                int d = instr->def_index();
+                if (d < 0)
+                    d = instr->array_param_index();
+                if (d < 0)
+                    continue;
+                const IROperand &written = instr->params[d];
+                if (written.kind == IROperand::global)
+                    writtenGlobals.insert(written.name);
+                else if (written.isVreg() && instr->def_index() < 0)
+                    writtenArrays.insert(written.id);
+                else if (written.isVreg())
+                    defined.insert(written.id);
+            }
+        }
+    }
+};
+
+bool isHoistable(IRInstr::Operation op)
+{
+    switch (op)
+    {
+    case IRInstr::copy:
+    case IRInstr::add:
+    case IRInstr::sub:
+    case IRInstr::mul:
+    case IRInstr::div:
+    case IRInstr::mod:
+    case IRInstr::cmp_eq:
+    case IRInstr::cmp_ne:
+    case IRInstr::cmp_lt:
+    case IRInstr::cmp_le:
+    case IRInstr::cmp_gt:
+    case IRInstr::cmp_ge:
+    case IRInstr::bit_and:
+    case IRInstr::bit_or:
+    case IRInstr::bit_xor:
+    case IRInstr::unary_minus:
+    case IRInstr::not_op:
+    case IRInstr::log_and:
+    case IRInstr::log_or:
+    case IRInstr::intToFloat:
+    case IRInstr::floatToInt:
+    case IRInstr::getTblx:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool isInvariant(CFG *cfg, IRInstr *instr, LoopEffects &effects)
+{
+    if (!isHoistable(instr->op) || !instr->params[0].isVreg())
+    {
+        return false;
+    }
+    int array = instr->array_param_index();
+    for (size_t i = 1; i < instr->params.size(); i++)
+    {
+        const IROperand &o = instr->params[i];
+        if ((int)i == array)
+        {
+            if (!o.isVreg() || effects.writtenArrays.count(o.id))
+                return false;
+        }
+        else if (o.isVreg())
+        {
+            if (effects.defined.count(o.id))
+                return false;
+        }
+        else if (o.kind == IROperand::global)
+        {
+            // Données en lecture seule, ou globale que ni la boucle ni une fonction appelée n'écrit
+            if (o.name[0] != '.' && (effects.hasCall || effects.writtenGlobals.count(o.name)))
+                return false;
+        }
+        else if (!o.isImm() && !o.isNone())
+        {
+            return false; // registre physique
+        }
+    }
+
+    if ((instr->op == IRInstr::div || instr->op == IRInstr::mod) && !Symbol::isFloatingType(instr->t))
+    {
+        const IROperand &divisor = instr->params[2];
+        return divisor.isImm() && divisor.name != "0" && divisor.name != "-1";
+    }
+    if (instr->op == IRInstr::getTblx)
+    {
+        const IROperand &index = instr->params[2];
+        if (!index.isImm())
+            return false;
+        int i = stoi(index.name);
+        return i >= 0 && i < cfg->get_vreg(instr->params[1].id).size;
+    }
+    return true;
+}
+
+// Une globale lue dans la boucle sans y être écrite est chargée une fois dans le preheader
+void loadGlobals(CFG *cfg, Loop *loop, BasicBlock *preheader, LoopEffects &effects)
+{
+    if (effects.hasCall)
+    {
+        return; // la fonction appelée peut écrire n'importe quelle globale
+    }
+    map<string, IROperand> loaded;
+    for (BasicBlock *bb : loop->blocks)
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            int array = instr->array_param_index();
+            for (int u : instr->use_indices())
+            {
+                IROperand &o = instr->params[u];
+                if (u == d || u == array || o.kind != IROperand::global || o.name[0] == '.' || effects.writtenGlobals.count(o.name))
+                    continue;
+                if (loaded.count(o.name) == 0)
+                {
+                    IROperand temp = IROperand::makeVreg(cfg->new_vreg(o.type, 1, o.name), o.type);
+                    preheader->instrs.push_back(new IRInstr(preheader, IRInstr::copy, o.type, {temp, o}));
+                    loaded[o.name] = temp;
+                }
+                o = loaded[o.name];
+            }
+        }
+    }
+}
+
+void hoist(CFG *cfg, Loop *loop, BasicBlock *preheader)
+{
+    LoopEffects effects(loop);
+    loadGlobals(cfg, loop, preheader, effects);
+
+    // Jusqu'au point fixe: une instruction devient invariante quand ses opérandes ont été sortis
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (BasicBlock *bb : loop->blocks)
+        {
+            vector<IRInstr *> kept;
+            for (IRInstr *instr : bb->instrs)
+            {
+                if (!isInvariant(cfg, instr, effects))
+                {
+                    kept.push_back(instr);
+                    continue;
+                }
+                instr->bb = preheader;
+                preheader->instrs.push_back(instr);
+                effects.defined.erase(instr->params[0].id);
+                changed = true;
+            }
+            bb->instrs = kept;
+        }
+    }
+}
+
+} // namespace
+
+void LICMPass::runOnFunction(CFG *cfg)
+{
+    if (!cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // hors SSA, une variable peut être redéfinie dans la boucle après sa lecture
+    }
+
+    // Les boucles internes d'abord: ce qui en sort peut encore sortir de la boucle englobante
+    vector<BasicBlock *> headers;
+    for (Loop *loop : cfg->get_loops()->loops())
+    {
+        headers.push_back(loop->header);
+    }
+    for (BasicBlock *header : headers)
+    {
+        BasicBlock *preheader = cfg->ensure_preheader(header);
+        hoist(cfg, cfg->get_loops()->loopFor(header), preheader);
+    }
+}
@@ -0,0 +1,79 @@
+#include "LiveIntervals.h"
+#include "Dataflow.h"
+#include "Loops.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// Positions: une instruction lit en 2k et écrit en 2k+1, le test de fin de bloc est lu après la dernière instruction
+vector<LiveInterval> buildLiveIntervals(CFG *cfg, vector<int> &calls)
+{
+    Liveness live(cfg);
+    LoopNest *loops = cfg->get_loops();
+
+    vector<LiveInterval> intervals(cfg->get_vreg_count());
+    for (size_t v = 0; v < intervals.size(); v++)
+    {
+        intervals[v].vreg = v;
+    }
+    auto extend = [&](int v, int pos) {
+        intervals[v].start = min(intervals[v].start, pos);
+        intervals[v].end = max(intervals[v].end, pos);
+    };
+
+    int pos = 0;
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        bool reachable = live.reachable(bb);
+        double weight = pow(10, reachable ? min(loops->depth(bb), 4) : 0);
+        if (reachable)
+        {
+            for (int v : live.in(bb).elements())
+                extend(v, pos);
+        }
+
+        for (IRInstr *instr : bb->instrs)
+        {
+            for (int u : instr->use_indices())
+            {
+                if (!instr->params[u].isVreg())
+                    continue;
+                extend(instr->params[u].id, pos);
+                intervals[instr->params[u].id].cost += weight;
+            }
+            if (instr->op == IRInstr::call)
+            {
+                calls.push_back(pos);
+            }
+            int d = instr->def_index();
+            if (d >= 0 && instr->params[d].isVreg())
+            {
+                int v = instr->params[d].id;
+                extend(v, pos + 1);
+                intervals[v].cost += weight;
+                if (instr->op == IRInstr::copy && instr->params[1].isVreg())
+                    intervals[v].hint = instr->params[1].id;
+            }
+            pos += 2;
+        }
+
+        if (bb->exit_false != nullptr && bb->test_var.isVreg())
+        {
+            extend(bb->test_var.id, pos);
+            intervals[bb->test_var.id].cost += weight;
+        }
+        if (reachable)
+        {
+            for (int v : live.out(bb).elements())
+                extend(v, pos);
+        }
+        pos += 2;
+    }
+
+    for (LiveInterval &interval : intervals)
+    {
+        auto call = upper_bound(calls.begin(), calls.end(), interval.start);
+        interval.crossesCall = (call != calls.end() && *call < interval.end);
+    }
+    return intervals;
+}
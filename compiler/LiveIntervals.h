@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <climits>
+#include "IR.h"
+
+/** The live interval of a virtual register: the hull [start, end] of the positions where its value is live,
+ *  once the blocks are laid out in the order of bbs. An instruction reads at 2k and writes at 2k+1, so a
+ *  value read for the last time by an instruction never overlaps the value this instruction writes. */
+struct LiveInterval
+{
+    int vreg;
+    int start = INT_MAX;
+    int end = -1;             /**< -1 if the virtual register appears in no instruction */
+    double cost = 0;          /**< accesses to memory if spilled, weighted by 10^(loop depth) */
+    bool crossesCall = false; /**< the value must survive a call: only callee-saved registers keep it */
+    int hint = -1;            /**< vreg copied into this one: sharing its register removes the copy */
+    std::string reg;
+
+    double weight() { return cost; } /**< a spilled interval costs all its accesses, however long it is */
+};
+
+/** Computes the live interval of every virtual register of the function (LiveIntervals.cpp).
+ *  calls receives the positions of the call instructions, in increasing order. */
+std::vector<LiveInterval> buildLiveIntervals(CFG *cfg, std::vector<int> &calls);
@@ -0,0 +1,265 @@
+#include "Loops.h"
+#include "Dominators.h"
+#include <algorithm>
+#include <map>
+using namespace std;
+
+/* ---------------------- Loop ---------------------- */
+
+BasicBlock *Loop::preheader()
+{
+    BasicBlock *outside = nullptr;
+    for (BasicBlock *pred : header->preds)
+    {
+        if (contains(pred))
+            continue;
+        if (outside != nullptr)
+            return nullptr;
+        outside = pred;
+    }
+    if (outside == nullptr || outside->successors().size() != 1)
+    {
+        return nullptr;
+    }
+    return outside;
+}
+
+/* ---------------------- LoopNest ---------------------- */
+
+LoopNest::LoopNest(CFG *cfg, DominatorTree *dom)
+{
+    // Un arc dont la cible domine la source est un arc retour; les boucles de même en-tête sont fusionnées
+    map<BasicBlock *, Loop *> byHeader;
+    for (BasicBlock *bb : dom->rpo())
+    {
+        for (BasicBlock *succ : bb->successors())
+        {
+            if (!dom->dominates(succ, bb))
+                continue;
+            if (byHeader.count(succ) == 0)
+            {
+                byHeader[succ] = new Loop(succ);
+                all.push_back(byHeader[succ]);
+            }
+            byHeader[succ]->latches.push_back(bb);
+        }
+    }
+
+    for (Loop *loop : all)
+    {
+        // Blocs qui atteignent un arc retour sans passer par l'en-tête
+        loop->members.insert(loop->header);
+        vector<BasicBlock *> worklist = loop->latches;
+        while (!worklist.empty())
+        {
+            BasicBlock *bb = worklist.back();
+            worklist.pop_back();
+            if (!loop->members.insert(bb).second)
+                continue;
+            for (BasicBlock *pred : bb->preds)
+            {
+                if (dom->reachable(pred))
+                    worklist.push_back(pred);
+            }
+        }
+
+        for (BasicBlock *bb : dom->rpo())
+        {
+            if (!loop->contains(bb))
+                continue;
+            loop->blocks.push_back(bb);
+            for (BasicBlock *succ : bb->successors())
+            {
+                if (!loop->contains(succ) && find(loop->exits.begin(), loop->exits.end(), succ) == loop->exits.end())
+                    loop->exits.push_back(succ);
+            }
+        }
+    }
+
+    // Imbrication: le parent est la plus petite autre boucle qui contient l'en-tête
+    stable_sort(all.begin(), all.end(), [](Loop *a, Loop *b) { return a->blocks.size() < b->blocks.size(); });
+    for (size_t i = 0; i < all.size(); i++)
+    {
+        for (size_t j = i + 1; j < all.size(); j++)
+        {
+            if (all[j]->contains(all[i]->header))
+            {
+                all[i]->parent = all[j];
+                all[j]->children.push_back(all[i]);
+                break;
+            }
+        }
+        for (BasicBlock *bb : all[i]->blocks)
+        {
+            if (innermost.count(bb) == 0)
+                innermost[bb] = all[i];
+        }
+    }
+    for (auto it = all.rbegin(); it != all.rend(); ++it)
+    {
+        Loop *loop = *it;
+        if (loop->parent == nullptr)
+        {
+            roots.insert(roots.begin(), loop);
+            continue;
+        }
+        loop->depth = loop->parent->depth + 1;
+    }
+}
+
+LoopNest::~LoopNest()
+{
+    for (Loop *loop : all)
+    {
+        delete loop;
+    }
+}
+
+Loop *LoopNest::loopFor(BasicBlock *bb)
+{
+    auto it = innermost.find(bb);
+    return it == innermost.end() ? nullptr : it->second;
+}
+
+int LoopNest::depth(BasicBlock *bb)
+{
+    Loop *loop = loopFor(bb);
+    return loop == nullptr ? 0 : loop->depth;
+}
+
+/* ---------------------- InductionVariable ---------------------- */
+
+vector<InductionVariable> findInductionVariables(Loop *loop, BasicBlock *preheader)
+{
+    map<int, IRInstr *> defs;
+    for (BasicBlock *bb : loop->blocks)
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (d >= 0 && instr->params[d].isVreg())
+                defs[instr->params[d].id] = instr;
+        }
+    }
+
+    vector<InductionVariable> ivs;
+    for (IRInstr *phi : loop->header->instrs)
+    {
+        if (phi->op != IRInstr::phi)
+            break;
+        if (phi->t != VarType::INT || phi->phi_preds.size() != 2)
+            continue;
+        int entry = (phi->phi_preds[0] == preheader) ? 0 : 1;
+        if (phi->phi_preds[entry] != preheader || !loop->contains(phi->phi_preds[1 - entry]))
+            continue;
+
+        // On remonte de next jusqu'à i par les copies et les additions d'une constante
+        InductionVariable iv = {phi, nullptr, {}, phi->params[1 + entry], 0};
+        IROperand value = phi->params[2 - entry];
+        bool valid = true;
+        while (valid && value != phi->params[0])
+        {
+            auto it = value.isVreg() ? defs.find(value.id) : defs.end();
+            if (it == defs.end())
+            {
+                valid = false;
+                break;
+            }
+            IRInstr *instr = it->second;
+            const IROperand &x = instr->params[1], &y = instr->params[2];
+            if (instr->op == IRInstr::copy && x.isVreg())
+            {
+                iv.chain.push_back(instr);
+                value = x;
+                continue;
+            }
+            if (instr->t != VarType::INT || (instr->op != IRInstr::add && instr->op != IRInstr::sub))
+            {
+                valid = false;
+            }
+            else if (x.isVreg() && y.isImm())
+            {
+                iv.stride += (instr->op == IRInstr::sub ? -1 : 1) * stoi(y.name);
+                value = x;
+            }
+            else if (instr->op == IRInstr::add && y.isVreg() && x.isImm())
+            {
+                iv.stride += stoi(x.name);
+                value = y;
+            }
+            else
+            {
+                valid = false;
+            }
+            if (valid && iv.step == nullptr)
+                iv.step = instr;
+            else if (valid)
+                iv.chain.push_back(instr);
+        }
+        if (valid && iv.step != nullptr)
+            ivs.push_back(iv);
+    }
+    return ivs;
+}
+
+/* ---------------------- CFG ---------------------- */
+
+BasicBlock *CFG::ensure_preheader(BasicBlock *header)
+{
+    Loop *loop = get_loops()->loopFor(header);
+    compute_predecessors();
+    BasicBlock *existing = loop->preheader();
+    if (existing != nullptr)
+    {
+        return existing;
+    }
+
+    vector<BasicBlock *> outside;
+    for (BasicBlock *pred : header->preds)
+    {
+        if (!loop->contains(pred))
+            outside.push_back(pred);
+    }
+    if (outside.size() == 1)
+    {
+        return split_edge(outside[0], header);
+    }
+
+    // Plusieurs entrées: elles passent toutes par le nouveau bloc, qui fusionne leurs valeurs des phi de l'en-tête
+    BasicBlock *preheader = new BasicBlock(this, new_BB_name());
+    preheader->exit_true = header;
+    preheader->preds = outside;
+    for (BasicBlock *pred : outside)
+    {
+        if (pred->exit_true == header)
+            pred->exit_true = preheader;
+        if (pred->exit_false == header)
+            pred->exit_false = preheader;
+    }
+    for (IRInstr *instr : header->instrs)
+    {
+        if (instr->op != IRInstr::phi)
+            break;
+        IROperand dest = instr->params[0];
+        int merged = new_vreg(dest.type, 1, get_vreg(dest.id).name + "." + to_string(get_vreg_count()));
+        IRInstr *merge = new IRInstr(preheader, IRInstr::phi, instr->t, {IROperand::makeVreg(merged, dest.type)});
+        for (size_t i = instr->phi_preds.size(); i-- > 0;)
+        {
+            if (loop->contains(instr->phi_preds[i]))
+                continue;
+            merge->params.insert(merge->params.begin() + 1, instr->params[i + 1]);
+            merge->phi_preds.insert(merge->phi_preds.begin(), instr->phi_preds[i]);
+            instr->params.erase(instr->params.begin() + i + 1);
+            instr->phi_preds.erase(instr->phi_preds.begin() + i);
+        }
+        instr->params.push_back(IROperand::makeVreg(merged, dest.type));
+        instr->phi_preds.push_back(preheader);
+        preheader->instrs.push_back(merge);
+    }
+
+    header->preds.erase(remove_if(header->preds.begin(), header->preds.end(), [&](BasicBlock *p) { return !loop->contains(p); }), header->preds.end());
+    header->preds.push_back(preheader);
+    bbs.insert(find(bbs.begin(), bbs.end(), header), preheader);
+    invalidate_analyses();
+    return preheader;
+}
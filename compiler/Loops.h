@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include "IR.h"
+
+class DominatorTree;
+
+/** A natural loop: its header and the blocks that reach a latch without going through the header.
+ *  The while statements give a loop whose header is the 'cond' block and whose latch is the end of the body. */
+class Loop {
+public:
+    Loop(BasicBlock* header) : header(header) {}
+
+    bool contains(BasicBlock* bb) { return members.count(bb) != 0; }
+    BasicBlock* preheader(); /**< the only predecessor of the header outside the loop, if it has the header as only successor */
+
+    BasicBlock* header;
+    std::vector<BasicBlock*> latches; /**< blocks with a back edge to the header */
+    std::vector<BasicBlock*> blocks;  /**< blocks of the loop in reverse post-order (header first), inner loops included */
+    std::vector<BasicBlock*> exits;   /**< blocks outside the loop that are targets of an edge leaving it */
+    Loop* parent = nullptr;           /**< the innermost loop containing this one */
+    std::vector<Loop*> children;
+    int depth = 1;                    /**< 1 for an outermost loop */
+    std::set<BasicBlock*> members;    /**< same blocks as 'blocks', for contains() */
+};
+
+/** A basic induction variable of a loop in SSA form: i = phi(init, next) in the header, next being
+ *  i + stride computed in the loop by additions of constants and copies (i = i + 1 goes through a temporary,
+ *  an unrolled loop adds 1 several times) */
+struct InductionVariable {
+    IRInstr* phi;
+    IRInstr* step;               /**< the last addition before next: its result is i + stride */
+    std::vector<IRInstr*> chain; /**< the other additions and copies between i and next */
+    IROperand init;              /**< value on entry, from the preheader */
+    int stride;
+};
+
+/** The basic induction variables of loop, whose header has preheader as only predecessor outside it (Loops.cpp) */
+std::vector<InductionVariable> findInductionVariables(Loop* loop, BasicBlock* preheader);
+
+/** The loop nest of a CFG, found from the back edges (edges whose target dominates their source) */
+class LoopNest {
+public:
+    LoopNest(CFG* cfg, DominatorTree* dom);
+    ~LoopNest();
+
+    const std::vector<Loop*>& loops() { return all; } /**< every loop, inner loops before the loops containing them */
+    const std::vector<Loop*>& topLevel() { return roots; }
+    Loop* loopFor(BasicBlock* bb); /**< innermost loop containing bb, nullptr if bb is in no loop */
+    int depth(BasicBlock* bb);     /**< loop depth of bb, 0 outside loops */
+
+private:
+    std::vector<Loop*> all;
+    std::vector<Loop*> roots;
+    std::unordered_map<BasicBlock*, Loop*> innermost;
+};
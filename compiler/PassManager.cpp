@@ -0,0 +1,175 @@
+#include "PassManager.h"
+#include "Passes.h"
+#include "FeedbackStyleOutput.h"
+#include <chrono>
+#include <iomanip>
+using namespace std;
+
+/* ---------------------- FunctionPass ---------------------- */
+
+void FunctionPass::run(vector<CFG *> &cfgs)
+{
+    for (CFG *cfg : cfgs)
+    {
+        runOnFunction(cfg);
+    }
+}
+
+/* ---------------------- OptimizationOptions ---------------------- */
+
+bool OptimizationOptions::parse(string arg)
+{
+    if (arg == "-O" || arg == "-O1")
+    {
+        level = 1;
+    }
+    else if (arg == "-O0")
+    {
+        level = 0;
+    }
+    else if (arg.rfind("-O", 0) == 0 && arg.size() == 3 && isdigit(arg[2]))
+    {
+        level = 2; // -O2 et au-delà
+    }
+    else if (arg == "-ftime-report")
+    {
+        timeReport = true;
+    }
+    else if (arg.rfind("-funroll-factor=", 0) == 0)
+    {
+        string value = arg.substr(16);
+        if (value.empty() || value.find_first_not_of("0123456789") != string::npos || value.size() > 4 || stoi(value) < 1)
+        {
+            FeedbackOutputFormat::showFeedbackOutput("error", "invalid unroll factor '" + value + "' in " + arg);
+            exit(1);
+        }
+        unrollFactor = stoi(value);
+    }
+    else if (arg == "-fmemoize")
+    {
+        memoize = true;
+    }
+    else if (arg.rfind("-fno-", 0) == 0 && arg.size() > 5)
+    {
+        disabled.insert(arg.substr(5));
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+/* ---------------------- PassManager ---------------------- */
+
+PassManager::PassManager(OptimizationOptions options) : options(options)
+{
+}
+
+PassManager::~PassManager()
+{
+    for (auto &[pass, level] : passes)
+    {
+        delete pass;
+    }
+}
+
+void PassManager::add(Pass *pass, int minLevel)
+{
+    passes.push_back({pass, minLevel});
+}
+
+bool PassManager::knows(string name)
+{
+    for (auto &[pass, level] : passes)
+    {
+        if (pass->name() == name)
+            return true;
+    }
+    return false;
+}
+
+static int countInstructions(vector<CFG *> &cfgs)
+{
+    int count = 0;
+    for (CFG *cfg : cfgs)
+    {
+        for (BasicBlock *bb : cfg->get_bbs())
+            count += bb->instrs.size();
+    }
+    return count;
+}
+
+void PassManager::run(vector<CFG *> &cfgs, ostream &report)
+{
+    for (const string &name : options.disabled)
+    {
+        if (!knows(name))
+            FeedbackOutputFormat::showFeedbackOutput("warning", "unknown optimization pass '" + name + "' in -fno-" + name);
+    }
+
+    if (options.timeReport)
+    {
+        report << left << setw(24) << "pass" << right << setw(12) << "time (ms)" << setw(10) << "instrs" << setw(10) << "delta" << "\n";
+        report << left << setw(24) << "(IR)" << right << setw(12) << "" << setw(10) << countInstructions(cfgs) << "\n";
+    }
+
+    double total = 0;
+    for (auto &[pass, minLevel] : passes)
+    {
+        bool enabled = pass->required() || (options.level >= minLevel && !options.disabled.count(pass->name()));
+        if (!enabled)
+        {
+            continue;
+        }
+
+        int before = countInstructions(cfgs);
+        auto start = chrono::steady_clock::now();
+        pass->run(cfgs);
+        double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        total += elapsed;
+
+        if (options.timeReport)
+        {
+            int after = countInstructions(cfgs);
+            report << left << setw(24) << pass->name() << right << setw(12) << fixed << setprecision(3) << elapsed
+                   << setw(10) << after << setw(10) << showpos << after - before << noshowpos << "\n";
+        }
+    }
+
+    if (options.timeReport)
+    {
+        report << left << setw(24) << "total" << right << setw(12) << fixed << setprecision(3) << total
+               << setw(10) << countInstructions(cfgs) << "\n";
+    }
+}
+
+PassManager *PassManager::standardPipeline(OptimizationOptions options)
+{
+    PassManager *pm = new PassManager(options);
+    pm->add(new InliningPass(), 2);
+    pm->add(new TailCallPass(), 2);
+    pm->add(new InterproceduralConstantsPass(), 2);
+    pm->add(new SSAConstructionPass(), 1);
+    pm->add(new SCCPPass(), 1);
+    pm->add(new LocalValueNumberingPass(), 1);
+    pm->add(new GlobalValueNumberingPass(), 2);
+    pm->add(new PureCallsPass(), 2);
+    pm->add(new LICMPass(), 2);
+    pm->add(new LoopUnswitchingPass(), 2);
+    pm->add(new LoopUnrollPass(options.unrollFactor), 2);
+    pm->add(new SCCPPass(), 2); // les copies d'une boucle déroulée reçoivent des constantes
+    pm->add(new StrengthReductionPass(), 2);
+    pm->add(new LoopRotationPass(), 2);
+    pm->add(new IfConversionPass(), 1);
+    pm->add(new SSADestructionPass(), 0);
+    pm->add(new SimplifyCFGPass(), 1);
+    pm->add(new BlockLayoutPass(), 1);
+    pm->add(new LinearScanPass(), 1);
+    pm->add(new StackColoringPass(), 1);
+    if (options.memoize)
+    {
+        pm->add(new MemoizationPass(), 0); // sur demande, à tous les niveaux
+    }
+    return pm;
+}
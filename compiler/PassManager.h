@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <set>
+#include <ostream>
+#include "IR.h"
+
+/** A transformation of the IR of the whole program, run between the construction of the CFGs and gen_asm */
+class Pass {
+public:
+    virtual ~Pass() {}
+    virtual std::string name() = 0; /**< name used by -fno-<name> and -ftime-report */
+    virtual void run(std::vector<CFG*>& cfgs) = 0;
+    virtual bool required() { return false; } /**< a required pass runs at every level and can not be disabled */
+};
+
+/** A pass that transforms each function on its own */
+class FunctionPass : public Pass {
+public:
+    void run(std::vector<CFG*>& cfgs) override;
+    virtual void runOnFunction(CFG* cfg) = 0;
+};
+
+/** The options of the optimizer, read from the command line */
+class OptimizationOptions {
+public:
+    bool parse(std::string arg); /**< returns false if arg is not an option of the optimizer */
+
+    int level = 0;                  /**< -O0, -O1 or -O2 */
+    std::set<std::string> disabled; /**< passes disabled with -fno-<pass> */
+    bool timeReport = false;        /**< -ftime-report */
+    int unrollFactor = 4;           /**< -funroll-factor=N: iterations per turn of an unrolled loop */
+    bool memoize = false;           /**< -fmemoize: pure recursive functions keep their results in a table */
+};
+
+/** Runs the passes enabled at the optimization level, in order */
+class PassManager {
+public:
+    PassManager(OptimizationOptions options);
+    ~PassManager();
+
+    void add(Pass* pass, int minLevel); /**< the pass runs from -O<minLevel> on */
+    void run(std::vector<CFG*>& cfgs, std::ostream& report);
+    bool knows(std::string name); /**< true if a pass of the pipeline has this name */
+
+    static PassManager* standardPipeline(OptimizationOptions options);
+
+private:
+    OptimizationOptions options;
+    std::vector<std::pair<Pass*, int>> passes;
+};
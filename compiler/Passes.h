@@ -0,0 +1,174 @@
+#pragma once
+
+#include "PassManager.h"
+
+// The passes of the optimizer, in the order of the standard pipeline (see PassManager::standardPipeline)
+
+/** Inlining: the calls to small functions, or to a function called only once, are replaced by a copy of
+ *  its blocks, the callees being processed before their callers; recursive functions are kept (Inline.cpp) */
+class InliningPass : public Pass {
+public:
+    std::string name() override { return "inline"; }
+    void run(std::vector<CFG*>& cfgs) override;
+};
+
+/** Tail calls, before SSA: a self-recursive call in tail position becomes a loop, with an accumulator for a
+ *  result combined by an integer addition or multiplication, and the other tail calls jump to their callee
+ *  once the frame is torn down (TailCalls.cpp) */
+class TailCallPass : public FunctionPass {
+public:
+    std::string name() override { return "tail-calls"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Interprocedural constant propagation: a parameter receiving the same constant at every call is bound to
+ *  it in the callee, and a function called with a few combinations of constants folded by its body is
+ *  specialized into one copy per combination (IPCP.cpp) */
+class InterproceduralConstantsPass : public Pass {
+public:
+    std::string name() override { return "ipcp"; }
+    void run(std::vector<CFG*>& cfgs) override;
+};
+
+/** Puts the functions in SSA form (SSA.cpp) */
+class SSAConstructionPass : public FunctionPass {
+public:
+    std::string name() override { return "ssa"; }
+    void runOnFunction(CFG* cfg) override { cfg->to_ssa(); }
+};
+
+/** Sparse conditional constant propagation: folds the constants through the variables and removes
+ *  the branches they decide, with the blocks left unreachable; needs the SSA form (SCCP.cpp) */
+class SCCPPass : public FunctionPass {
+public:
+    std::string name() override { return "sccp"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Local value numbering: a computation already done earlier in the same block reuses its result (ValueNumbering.cpp) */
+class LocalValueNumberingPass : public FunctionPass {
+public:
+    std::string name() override { return "lvn"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Global value numbering over the dominator tree: a computation already done in a dominating block
+ *  reuses its result; needs the SSA form (ValueNumbering.cpp) */
+class GlobalValueNumberingPass : public FunctionPass {
+public:
+    std::string name() override { return "gvn"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Calls to pure functions, on the SSA form: the functions writing no global and performing no input/output
+ *  are found by an interprocedural analysis, their calls repeated with the same arguments reuse the first
+ *  result, and those with loop-invariant arguments are hoisted when the callee can neither fail nor loop
+ *  (PureCalls.cpp) */
+class PureCallsPass : public Pass {
+public:
+    std::string name() override { return "pure-calls"; }
+    void run(std::vector<CFG*>& cfgs) override;
+};
+
+/** Loop-invariant code motion: hoists the invariant computations of each loop into its preheader,
+ *  inserted before the header if needed; needs the SSA form (Licm.cpp) */
+class LICMPass : public FunctionPass {
+public:
+    std::string name() override { return "licm"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Loop unswitching: a branch of a loop on an invariant condition is taken out of it, the preheader choosing
+ *  between two copies of the loop specialized for each side; bounded by a code-size budget; needs the SSA
+ *  form (Unswitch.cpp) */
+class LoopUnswitchingPass : public FunctionPass {
+public:
+    std::string name() override { return "unswitch"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Loop unrolling: a loop while (i < N) whose trip count is known, or computable on entry, runs several
+ *  iterations per turn, followed by the original loop for the remaining ones; a small constant trip count
+ *  is unrolled completely; needs the SSA form (Unroll.cpp) */
+class LoopUnrollPass : public FunctionPass {
+public:
+    LoopUnrollPass(int factor) : factor(factor) {}
+    std::string name() override { return "unroll"; }
+    void runOnFunction(CFG* cfg) override;
+
+private:
+    int factor;
+};
+
+/** Induction-variable strength reduction: the array accesses indexed by an induction variable go through
+ *  a pointer advanced with it, and the exit test compares that pointer once the counter is dead; needs the
+ *  SSA form (StrengthReduction.cpp) */
+class StrengthReductionPass : public FunctionPass {
+public:
+    std::string name() override { return "strength-reduce"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Loop rotation: a while loop becomes a do-while guarded by a copy of its test in the preheader, the test
+ *  being evaluated again after the latch, so that a turn takes a single conditional branch back to the
+ *  header; needs the SSA form (Rotate.cpp) */
+class LoopRotationPass : public FunctionPass {
+public:
+    std::string name() override { return "rotate"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** If-conversion: a small if whose sides have no side effect and meet right away becomes a select of the
+ *  values of its join (cmov, csel), both sides being computed; needs the SSA form (IfConversion.cpp) */
+class IfConversionPass : public FunctionPass {
+public:
+    std::string name() override { return "if-convert"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Replaces the phi nodes by copies before gen_asm; does nothing if the function is not in SSA form */
+class SSADestructionPass : public FunctionPass {
+public:
+    std::string name() override { return "out-of-ssa"; }
+    bool required() override { return true; }
+    void runOnFunction(CFG* cfg) override { cfg->from_ssa(); }
+};
+
+/** Control-flow simplification after out-of-SSA: jumps to empty blocks go straight to their target, a block
+ *  is merged into its single predecessor when it is that block's only successor, and unreachable blocks are
+ *  deleted (SimplifyCFG.cpp) */
+class SimplifyCFGPass : public FunctionPass {
+public:
+    std::string name() override { return "simplify-cfg"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Block layout: each block is followed by its likely successor, reached without a jump, the small epilogue
+ *  is copied into the blocks returning to it and the loop headers are aligned (Layout.cpp) */
+class BlockLayoutPass : public FunctionPass {
+public:
+    std::string name() override { return "layout"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Linear-scan register allocation of the scalar virtual registers, after out-of-SSA (RegisterAllocator.cpp) */
+class LinearScanPass : public FunctionPass {
+public:
+    std::string name() override { return "regalloc"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** Gives the values left in memory by the register allocator stack slots shared by disjoint lifetimes (StackColoring.cpp) */
+class StackColoringPass : public FunctionPass {
+public:
+    std::string name() override { return "stack-coloring"; }
+    void runOnFunction(CFG* cfg) override;
+};
+
+/** -fmemoize: a pure recursive function of one int, whose result depends only on its argument, keeps its
+ *  results in a table checked on entry, for the arguments from 0 to the size of the table (PureCalls.cpp) */
+class MemoizationPass : public Pass {
+public:
+    std::string name() override { return "memoize"; }
+    void run(std::vector<CFG*>& cfgs) override;
+};
@@ -0,0 +1,393 @@
+#include "Passes.h"
+#include "Loops.h"
+#include "Dominators.h"
+#include <map>
+#include <set>
+#include <algorithm>
+using namespace std;
+
+// Appels de fonctions pures, sur la forme SSA. Une fonction du programme est pure quand elle n'écrit aucune
+// globale et n'appelle que des fonctions pures: pas putchar ni getchar (predefinedFunctions), dont l'effet
+// est une entrée/sortie. Deux appels d'une fonction pure avec les mêmes arguments rendent la même valeur:
+//  - un appel dominé par un appel identique reprend son résultat, et un appel dont le résultat est ignoré
+//    est supprimé. Si la fonction lit des globales, seulement dans un même bloc, sans écriture de globale
+//    ni appel d'une fonction impure entre les deux;
+//  - un appel dont les arguments sont invariants dans une boucle est sorti dans son preheader, qui
+//    s'exécute même si la boucle ne fait aucun tour: comme pour LICM, la fonction appelée ne doit pas
+//    pouvoir faire échouer le programme ni boucler (pas de boucle, de récursion, de division par une
+//    valeur inconnue ni d'accès à un tableau par un indice inconnu).
+// Avec -fmemoize, une fonction pure récursive d'un seul int, qui ne lit aucune globale, garde ses résultats
+// dans une table en .bss: son point d'entrée y cherche l'argument avant d'exécuter le corps, ce qui rend
+// linéaire une récursion exponentielle comme celle de Fibonacci.
+
+namespace
+{
+
+const int memoTableSize = 4096; /**< arguments 0 to 4095 of a memoized function have their result kept */
+
+/** What a function does, beyond computing its result */
+struct FunctionEffects
+{
+    bool pure = true;          /**< writes no global, performs no input/output */
+    bool readsGlobals = false; /**< its result may change when a global is written */
+    bool speculatable = true;  /**< always returns, without failing: can be called where the source does not */
+};
+
+/** A call to a pure function of the program: the copies of its arguments, the call and the copy of its
+ *  result, next to each other in a block */
+struct Call
+{
+    CFG *callee;
+    vector<IRInstr *> group;    /**< argument copies, call, result copy */
+    IRInstr *result = nullptr;  /**< copy of the return register, nullptr if the result is ignored */
+    string key;                 /**< callee and values of the arguments */
+};
+
+bool mayFail(IRInstr *instr, CFG *cfg)
+{
+    if ((instr->op == IRInstr::div || instr->op == IRInstr::mod) && !Symbol::isFloatingType(instr->t))
+    {
+        const IROperand &divisor = instr->params[2];
+        return !divisor.isImm() || divisor.name == "0" || divisor.name == "-1";
+    }
+    int array = instr->array_param_index();
+    if (array >= 0)
+    {
+        const IROperand &index = instr->params[2];
+        if (!index.isImm())
+            return true;
+        int i = stoi(index.name);
+        return i < 0 || i >= cfg->get_vreg(instr->params[array].id).size;
+    }
+    return instr->op == IRInstr::rmem || instr->op == IRInstr::wmem;
+}
+
+class PureCalls
+{
+public:
+    PureCalls(vector<CFG *> &cfgs);
+    void analyze();
+    void removeRedundant(CFG *cfg);
+    void hoistInvariant(CFG *cfg);
+    bool isMemoizable(CFG *cfg);
+
+private:
+    bool findCall(BasicBlock *bb, size_t index, Call &call); /**< index of the call instruction in bb */
+    void removeGroup(BasicBlock *bb, Call &call, size_t &index);
+    bool isClobber(IRInstr *instr); /**< writes a global, or calls a function that may */
+
+    vector<CFG *> &cfgs;
+    map<string, CFG *> functions;
+    map<CFG *, FunctionEffects> effects;
+};
+
+PureCalls::PureCalls(vector<CFG *> &cfgs) : cfgs(cfgs)
+{
+    for (CFG *cfg : cfgs)
+    {
+        functions[cfg->ast->getName()] = cfg;
+    }
+}
+
+// Point fixe optimiste: toutes les fonctions sont supposées pures, jusqu'à preuve du contraire, pour que
+// la récursion n'empêche pas une fonction d'être pure
+void PureCalls::analyze()
+{
+    for (CFG *cfg : cfgs)
+    {
+        effects[cfg].speculatable = !cfg->get_bbs().empty() && cfg->get_loops()->loops().empty();
+    }
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (CFG *cfg : cfgs)
+        {
+            FunctionEffects e = effects[cfg];
+            for (BasicBlock *bb : cfg->get_bbs())
+            {
+                for (IRInstr *instr : bb->instrs)
+                {
+                    if (instr->op == IRInstr::call)
+                    {
+                        auto it = functions.find(instr->params[0].name);
+                        if (it == functions.end())
+                        {
+                            e.pure = false; // putchar, getchar
+                            continue;
+                        }
+                        FunctionEffects &callee = effects[it->second];
+                        e.pure &= callee.pure;
+                        e.readsGlobals |= callee.readsGlobals;
+                        e.speculatable &= callee.speculatable && it->second != cfg;
+                        continue;
+                    }
+                    int d = instr->def_index();
+                    if (d >= 0 && instr->params[d].kind == IROperand::global)
+                        e.pure = false;
+                    for (int u : instr->use_indices())
+                    {
+                        // les étiquettes commençant par '.' sont des constantes en lecture seule
+                        if (instr->params[u].kind == IROperand::global && instr->params[u].name[0] != '.')
+                            e.readsGlobals = true;
+                    }
+                    e.pure &= instr->op != IRInstr::wmem;
+                    e.speculatable &= !mayFail(instr, cfg);
+                }
+            }
+            FunctionEffects &old = effects[cfg];
+            if (e.pure != old.pure || e.readsGlobals != old.readsGlobals || e.speculatable != old.speculatable)
+            {
+                old = e;
+                changed = true;
+            }
+        }
+    }
+}
+
+bool PureCalls::isClobber(IRInstr *instr)
+{
+    if (instr->op == IRInstr::call)
+    {
+        auto it = functions.find(instr->params[0].name);
+        return it == functions.end() || !effects[it->second].pure;
+    }
+    int d = instr->def_index();
+    return (d >= 0 && instr->params[d].kind == IROperand::global) || instr->op == IRInstr::wmem;
+}
+
+// Le résultat ne dépend que de l'unique argument entier, que la fonction lit dans son registre, et elle
+// s'appelle elle-même: les appels récursifs passent par la table
+bool PureCalls::isMemoizable(CFG *cfg)
+{
+    FunctionEffects &e = effects[cfg];
+    vector<VarType> params = cfg->ast->getParameters();
+    VarType t = cfg->ast->getType();
+    if (!e.pure || e.readsGlobals || cfg->ast->getName() == "main" || params.size() != 1 || params[0] != VarType::INT ||
+        (t != VarType::INT && t != VarType::CHAR) || cfg->get_bbs().empty())
+    {
+        return false;
+    }
+    BasicBlock *entry = cfg->get_bbs()[0];
+    if (entry->instrs.empty() || entry->instrs[0]->op != IRInstr::copy || entry->instrs[0]->params[1].kind != IROperand::preg)
+    {
+        return false; // paramètre remplacé par une constante (ipcp)
+    }
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (instr->op == IRInstr::call && instr->params[0].name == cfg->ast->getName())
+                return true;
+        }
+    }
+    return false;
+}
+
+// Les copies des arguments dans leurs registres, qui précèdent l'appel, et la copie du registre de retour
+// qui le suit
+bool PureCalls::findCall(BasicBlock *bb, size_t index, Call &call)
+{
+    IRInstr *instr = bb->instrs[index];
+    auto it = functions.find(instr->params[0].name);
+    if (it == functions.end() || !effects[it->second].pure || instr->tail_call)
+    {
+        return false;
+    }
+    call.callee = it->second;
+    size_t first = index;
+    vector<string> args;
+    while (first > 0)
+    {
+        IRInstr *copy = bb->instrs[first - 1];
+        if ((copy->op != IRInstr::copy && copy->op != IRInstr::ldconst) || copy->params[0].kind != IROperand::preg)
+            break;
+        if (!copy->params[1].isVreg() && !copy->params[1].isImm())
+            return false; // une globale passée en argument peut changer entre deux appels
+        args.push_back(copy->params[0].name + "=" + copy->params[1].toString());
+        first--;
+    }
+    sort(args.begin(), args.end());
+    call.key = instr->params[0].name;
+    for (string &arg : args)
+    {
+        call.key += "," + arg;
+    }
+    call.group.assign(bb->instrs.begin() + first, bb->instrs.begin() + index + 1);
+    IRInstr *next = index + 1 < bb->instrs.size() ? bb->instrs[index + 1] : nullptr;
+    if (next != nullptr && next->op == IRInstr::copy && next->params[1].kind == IROperand::preg && next->params[0].isVreg())
+    {
+        call.result = next;
+        call.group.push_back(next);
+    }
+    return true;
+}
+
+// Supprime les instructions de l'appel, sauf la copie du résultat; index repasse sur la dernière restante
+void PureCalls::removeGroup(BasicBlock *bb, Call &call, size_t &index)
+{
+    size_t first = find(bb->instrs.begin(), bb->instrs.end(), call.group[0]) - bb->instrs.begin();
+    size_t count = call.group.size() - (call.result != nullptr ? 1 : 0);
+    for (size_t k = first; k < first + count; k++)
+    {
+        delete bb->instrs[k];
+    }
+    bb->instrs.erase(bb->instrs.begin() + first, bb->instrs.begin() + first + count);
+    index = first;
+}
+
+void PureCalls::removeRedundant(CFG *cfg)
+{
+    // Parcours en profondeur de l'arbre des dominateurs: un bloc voit les appels de ses dominateurs
+    DominatorTree *dom = cfg->get_dominators();
+    map<string, IROperand> available;
+    vector<string> recorded;
+    auto visit = [&](BasicBlock *bb) {
+        int clobbers = 0;
+        for (size_t i = 0; i < bb->instrs.size(); i++)
+        {
+            IRInstr *instr = bb->instrs[i];
+            Call call;
+            if (instr->op != IRInstr::call || !findCall(bb, i, call))
+            {
+                clobbers += isClobber(instr);
+                continue;
+            }
+            FunctionEffects &e = effects[call.callee];
+            // Une fonction qui lit des globales ne rend la même valeur que jusqu'à la prochaine écriture
+            if (e.readsGlobals)
+                call.key += "@" + bb->label + "#" + to_string(clobbers);
+            if (call.result == nullptr)
+            {
+                if (e.speculatable)
+                    removeGroup(bb, call, i), i--;
+                continue;
+            }
+            auto it = available.find(call.key);
+            if (it != available.end())
+            {
+                removeGroup(bb, call, i);
+                call.result->params[1] = it->second;
+                continue;
+            }
+            available[call.key] = call.result->params[0];
+            recorded.push_back(call.key);
+        }
+    };
+
+    BasicBlock *entry = dom->rpo()[0];
+    vector<pair<BasicBlock *, size_t>> stack = {{entry, 0}};
+    vector<size_t> scopes = {recorded.size()};
+    visit(entry);
+    while (!stack.empty())
+    {
+        BasicBlock *bb = stack.back().first;
+        const vector<BasicBlock *> &kids = dom->children(bb);
+        if (stack.back().second < kids.size())
+        {
+            BasicBlock *kid = kids[stack.back().second++];
+            scopes.push_back(recorded.size());
+            visit(kid);
+            stack.push_back({kid, 0});
+            continue;
+        }
+        while (recorded.size() > scopes.back())
+        {
+            available.erase(recorded.back());
+            recorded.pop_back();
+        }
+        scopes.pop_back();
+        stack.pop_back();
+    }
+}
+
+void PureCalls::hoistInvariant(CFG *cfg)
+{
+    // Les boucles internes d'abord: ce qui en sort peut encore sortir de la boucle englobante
+    vector<BasicBlock *> headers;
+    for (Loop *loop : cfg->get_loops()->loops())
+    {
+        headers.push_back(loop->header);
+    }
+    for (BasicBlock *header : headers)
+    {
+        BasicBlock *preheader = cfg->ensure_preheader(header);
+        Loop *loop = cfg->get_loops()->loopFor(header);
+        set<int> defined;
+        bool clobbered = false;
+        for (BasicBlock *bb : loop->blocks)
+        {
+            for (IRInstr *instr : bb->instrs)
+            {
+                int d = instr->def_index();
+                if (d >= 0 && instr->params[d].isVreg())
+                    defined.insert(instr->params[d].id);
+                clobbered |= isClobber(instr);
+            }
+        }
+
+        // Jusqu'au point fixe: un appel devient invariant quand ses arguments ont été sortis
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (BasicBlock *bb : loop->blocks)
+            {
+                for (size_t i = 0; i < bb->instrs.size(); i++)
+                {
+                    Call call;
+                    if (bb->instrs[i]->op != IRInstr::call || !findCall(bb, i, call) || call.result == nullptr)
+                        continue;
+                    FunctionEffects &e = effects[call.callee];
+                    bool invariant = e.speculatable && (!e.readsGlobals || !clobbered);
+                    for (IRInstr *instr : call.group)
+                    {
+                        for (int u : instr->use_indices())
+                            invariant &= !instr->params[u].isVreg() || !defined.count(instr->params[u].id);
+                    }
+                    if (!invariant)
+                        continue;
+                    size_t first = i + 1 - (call.group.size() - 1);
+                    for (IRInstr *instr : call.group)
+                    {
+                        instr->bb = preheader;
+                        preheader->instrs.push_back(instr);
+                    }
+                    bb->instrs.erase(bb->instrs.begin() + first, bb->instrs.begin() + first + call.group.size());
+                    defined.erase(call.result->params[0].id);
+                    i = first - 1;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+void PureCallsPass::run(vector<CFG *> &cfgs)
+{
+    PureCalls calls(cfgs);
+    calls.analyze();
+    for (CFG *cfg : cfgs)
+    {
+        if (!cfg->in_ssa || cfg->get_bbs().empty())
+            continue; // hors SSA, les arguments de deux appels identiques peuvent avoir changé entre eux
+        calls.removeRedundant(cfg);
+        calls.hoistInvariant(cfg);
+    }
+}
+
+void MemoizationPass::run(vector<CFG *> &cfgs)
+{
+    PureCalls calls(cfgs);
+    calls.analyze();
+    for (CFG *cfg : cfgs)
+    {
+        if (!calls.isMemoizable(cfg))
+            continue;
+        // Le nom de la fonction passe à l'entrée qui consulte la table (gen_asm_memo), le corps est appelé en cas d'absence
+        cfg->memo_size = memoTableSize;
+        cfg->get_bbs()[0]->label = cfg->ast->getName() + ".compute";
+    }
+}
@@ -0,0 +1,116 @@
+#include "Passes.h"
+#include "LiveIntervals.h"
+#include <algorithm>
+using namespace std;
+
+// Allocation de registres par balayage linéaire (Poletto et Sarkar) sur les intervalles de vie
+// des registres virtuels scalaires. Chaque intervalle est l'enveloppe [début, fin] des positions
+// où la valeur est vivante; un intervalle qui ne reçoit pas de registre garde son emplacement de pile.
+
+extern vector<string> allocatableCalleeSaved;
+extern vector<string> allocatableCallerSaved;
+extern vector<string> allocatableFloatRegs;
+
+static bool isAllocatable(VirtualRegister &vreg)
+{
+    return !vreg.isArray() && (Symbol::isIntegerType(vreg.type) || Symbol::isFloatingType(vreg.type) || vreg.type == VarType::ADDRESS);
+}
+
+static vector<string> registersFor(CFG *cfg, LiveInterval &interval)
+{
+    if (Symbol::isFloatingType(cfg->get_vreg(interval.vreg).type))
+    {
+        return interval.crossesCall ? vector<string>() : allocatableFloatRegs;
+    }
+    if (interval.crossesCall)
+    {
+        return allocatableCalleeSaved;
+    }
+    // Les registres sauvegardés par l'appelant d'abord: ils ne coûtent pas de sauvegarde au prologue
+    vector<string> regs = allocatableCallerSaved;
+    regs.insert(regs.end(), allocatableCalleeSaved.begin(), allocatableCalleeSaved.end());
+    return regs;
+}
+
+void LinearScanPass::runOnFunction(CFG *cfg)
+{
+    if (allocatableCalleeSaved.empty() && allocatableCallerSaved.empty() && allocatableFloatRegs.empty())
+    {
+        return; // pas de registre à donner sur cette cible
+    }
+
+    vector<int> calls;
+    vector<LiveInterval> intervals = buildLiveIntervals(cfg, calls);
+
+    vector<LiveInterval *> sorted;
+    for (LiveInterval &interval : intervals)
+    {
+        if (interval.end >= 0 && isAllocatable(cfg->get_vreg(interval.vreg)))
+            sorted.push_back(&interval);
+    }
+    stable_sort(sorted.begin(), sorted.end(), [](LiveInterval *a, LiveInterval *b) { return a->start < b->start; });
+
+    vector<LiveInterval *> active;
+    for (LiveInterval *current : sorted)
+    {
+        // Les intervalles terminés rendent leur registre
+        active.erase(remove_if(active.begin(), active.end(), [&](LiveInterval *a) { return a->end < current->start; }), active.end());
+
+        vector<string> candidates = registersFor(cfg, *current);
+        auto isFree = [&](const string &reg) {
+            return none_of(active.begin(), active.end(), [&](LiveInterval *a) { return a->reg == reg; });
+        };
+
+        // Le registre de la source d'une copie d'abord, puis le premier registre libre
+        string chosen;
+        if (current->hint >= 0)
+        {
+            string hinted = intervals[current->hint].reg;
+            if (!hinted.empty() && isFree(hinted) && find(candidates.begin(), candidates.end(), hinted) != candidates.end())
+                chosen = hinted;
+        }
+        for (size_t i = 0; i < candidates.size() && chosen.empty(); i++)
+        {
+            if (isFree(candidates[i]))
+                chosen = candidates[i];
+        }
+
+        if (chosen.empty())
+        {
+            // Plus de registre: on garde en mémoire la valeur dont les accès pondérés coûtent le moins
+            LiveInterval *victim = nullptr;
+            for (LiveInterval *a : active)
+            {
+                if (find(candidates.begin(), candidates.end(), a->reg) == candidates.end())
+                    continue;
+                if (victim == nullptr || a->weight() < victim->weight())
+                    victim = a;
+            }
+            if (victim == nullptr || victim->weight() >= current->weight())
+            {
+                continue; // current reste dans son emplacement de pile
+            }
+            chosen = victim->reg;
+            victim->reg = "";
+            active.erase(find(active.begin(), active.end(), victim));
+        }
+
+        current->reg = chosen;
+        active.push_back(current);
+    }
+
+    // Les registres sauvegardés par l'appelé utilisés sont sauvegardés au prologue
+    for (LiveInterval &interval : intervals)
+    {
+        cfg->get_vreg(interval.vreg).reg = interval.reg;
+    }
+    for (const string &reg : allocatableCalleeSaved)
+    {
+        bool used = any_of(intervals.begin(), intervals.end(), [&](LiveInterval &i) { return i.reg == reg; });
+        if (used)
+        {
+            int slot = cfg->new_vreg(VarType::INT, 2, "save" + reg);
+            cfg->saved_regs.push_back({reg, slot});
+        }
+    }
+}
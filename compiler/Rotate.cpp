@@ -0,0 +1,252 @@
+#include "Passes.h"
+#include "Loops.h"
+#include <map>
+#include <set>
+#include <algorithm>
+using namespace std;
+
+// Rotation des boucles while en do-while gardé: le test de l'en-tête est calculé une fois dans le
+// preheader, qui saute par-dessus la boucle si elle ne fait aucun tour, puis à la fin de chaque tour
+// dans un nouveau bloc de test placé après le latch, qui revient à l'en-tête ou sort.
+// Les instructions de l'en-tête sont déplacées, pas dupliquées à l'exécution: chaque évaluation du test
+// se fait soit dans le preheader, soit dans le bloc de test, et l'en-tête ne garde que des phi qui
+// fusionnent les deux versions de ses valeurs. La sortie reçoit de même une phi par valeur de l'en-tête
+// lue après la boucle.
+
+namespace
+{
+
+const int maxRotatedHeaderSize = 32; /**< instructions of a header copied in the preheader and the test block */
+
+class LoopRotation
+{
+public:
+    LoopRotation(CFG *cfg, Loop *loop, BasicBlock *preheader) : cfg(cfg), loop(loop), preheader(preheader) {}
+    void run();
+
+private:
+    bool canRotate();
+    /** copies the instructions of the header at the end of bb, the phis taking their value from pred */
+    map<int, IROperand> copyHeader(BasicBlock *bb, BasicBlock *pred);
+
+    CFG *cfg;
+    Loop *loop;
+    BasicBlock *preheader;
+    BasicBlock *latch = nullptr;
+    BasicBlock *exit = nullptr;
+};
+
+bool LoopRotation::canRotate()
+{
+    BasicBlock *header = loop->header;
+    // Une seule sortie (pas de return dans la boucle): tout ce qui suit la boucle passe par elle
+    if (loop->latches.size() != 1 || loop->exits.size() != 1 || header->exit_false == nullptr || header->test_var.isNone())
+    {
+        return false;
+    }
+    latch = loop->latches[0];
+    // Un en-tête qui est aussi le latch teste déjà en bas de la boucle
+    if (latch == header || latch->exit_false != nullptr)
+    {
+        return false;
+    }
+    bool trueInLoop = loop->contains(header->exit_true);
+    bool falseInLoop = loop->contains(header->exit_false);
+    if (trueInLoop == falseInLoop)
+    {
+        return false;
+    }
+    exit = trueInLoop ? header->exit_false : header->exit_true;
+    // La sortie ne doit venir que de l'en-tête: elle fusionnera les versions du preheader et du bloc de test
+    if (exit->preds.size() != 1)
+    {
+        return false;
+    }
+    int size = 0;
+    for (IRInstr *instr : header->instrs)
+    {
+        size += instr->op != IRInstr::phi;
+    }
+    return size <= maxRotatedHeaderSize;
+}
+
+map<int, IROperand> LoopRotation::copyHeader(BasicBlock *bb, BasicBlock *pred)
+{
+    map<int, IROperand> values;
+    for (IRInstr *instr : loop->header->instrs)
+    {
+        if (instr->op == IRInstr::phi)
+        {
+            for (size_t k = 0; k < instr->phi_preds.size(); k++)
+            {
+                if (instr->phi_preds[k] == pred)
+                    values[instr->params[0].id] = instr->params[k + 1];
+            }
+            continue;
+        }
+        vector<IROperand> params;
+        for (const IROperand &o : instr->params)
+            params.push_back(o.isVreg() && values.count(o.id) ? values[o.id] : o);
+        int d = instr->def_index();
+        if (d >= 0 && instr->params[d].isVreg())
+        {
+            VirtualRegister &v = cfg->get_vreg(instr->params[d].id);
+            params[d] = IROperand::makeVreg(cfg->new_vreg(v.type, v.size, v.name), instr->params[d].type);
+            values[instr->params[d].id] = params[d];
+        }
+        bb->instrs.push_back(new IRInstr(bb, instr->op, instr->t, params));
+    }
+    return values;
+}
+
+void LoopRotation::run()
+{
+    if (!canRotate())
+    {
+        return;
+    }
+    BasicBlock *header = loop->header;
+    bool trueInLoop = loop->contains(header->exit_true);
+    BasicBlock *body = trueInLoop ? header->exit_true : header->exit_false;
+    IROperand test = header->test_var;
+
+    // Garde: le premier test, dans le preheader
+    map<int, IROperand> before = copyHeader(preheader, preheader);
+    preheader->test_var = before.count(test.id) ? before[test.id] : test;
+    preheader->test_var_name = header->test_var_name;
+    preheader->exit_true = trueInLoop ? header : exit;
+    preheader->exit_false = trueInLoop ? exit : header;
+
+    // Les tests suivants, en bas de la boucle
+    BasicBlock *bottom = new BasicBlock(cfg, cfg->new_BB_name());
+    map<int, IROperand> after = copyHeader(bottom, latch);
+    bottom->test_var = after.count(test.id) ? after[test.id] : test;
+    bottom->test_var_name = header->test_var_name;
+    bottom->exit_true = trueInLoop ? header : exit;
+    bottom->exit_false = trueInLoop ? exit : header;
+    latch->exit_true = bottom;
+    vector<BasicBlock *> &bbs = cfg->get_bbs();
+    bbs.insert(find(bbs.begin(), bbs.end(), latch) + 1, bottom);
+
+    // Les valeurs lues hors de l'en-tête: phi dans l'en-tête pour la boucle, dans la sortie pour la suite
+    set<int> usedInLoop, usedOutside;
+    for (BasicBlock *bb : bbs)
+    {
+        if (bb == preheader || bb == bottom)
+            continue;
+        set<int> &uses = loop->contains(bb) ? usedInLoop : usedOutside;
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (bb == header && instr->op != IRInstr::phi)
+                continue;
+            for (int u : instr->use_indices())
+            {
+                if (instr->params[u].isVreg())
+                    uses.insert(instr->params[u].id);
+            }
+        }
+        if (bb != header && bb->test_var.isVreg())
+            uses.insert(bb->test_var.id);
+    }
+
+    vector<IRInstr *> merged;
+    map<int, IROperand> renamed; // valeur de l'en-tête -> phi de la sortie
+    vector<IRInstr *> exitPhis;
+    for (IRInstr *instr : header->instrs)
+    {
+        int d = instr->def_index();
+        bool defines = d >= 0 && instr->params[d].isVreg();
+        IROperand value = defines ? instr->params[d] : IROperand();
+        if (instr->op == IRInstr::phi)
+        {
+            for (BasicBlock *&pred : instr->phi_preds)
+                pred = (pred == latch) ? bottom : pred;
+            merged.push_back(instr);
+        }
+        else
+        {
+            if (defines && usedInLoop.count(value.id))
+            {
+                IRInstr *phi = new IRInstr(header, IRInstr::phi, instr->t, {value, before[value.id], after[value.id]});
+                phi->phi_preds = {preheader, bottom};
+                merged.push_back(phi);
+            }
+            delete instr;
+        }
+        if (defines && usedOutside.count(value.id))
+        {
+            VirtualRegister &v = cfg->get_vreg(value.id);
+            IROperand out = IROperand::makeVreg(cfg->new_vreg(v.type, v.size, v.name), value.type);
+            IRInstr *phi = new IRInstr(exit, IRInstr::phi, value.type, {out, before[value.id], after[value.id]});
+            phi->phi_preds = {preheader, bottom};
+            exitPhis.push_back(phi);
+            renamed[value.id] = out;
+        }
+    }
+    header->instrs = merged;
+    header->exit_true = body;
+    header->exit_false = nullptr;
+    header->test_var = IROperand();
+    header->test_var_name.clear();
+
+    // Les phi déjà dans la sortie reçoivent une valeur de chacun des deux tests
+    auto version = [](map<int, IROperand> &values, const IROperand &o) { return o.isVreg() && values.count(o.id) ? values[o.id] : o; };
+    for (IRInstr *instr : exit->instrs)
+    {
+        if (instr->op != IRInstr::phi)
+            break;
+        for (size_t k = 0; k < instr->phi_preds.size(); k++)
+        {
+            if (instr->phi_preds[k] != header)
+                continue;
+            IROperand o = instr->params[k + 1];
+            instr->phi_preds[k] = preheader;
+            instr->params[k + 1] = version(before, o);
+            instr->phi_preds.push_back(bottom);
+            instr->params.push_back(version(after, o));
+            break;
+        }
+    }
+
+    for (BasicBlock *bb : bbs)
+    {
+        if (loop->contains(bb) || bb == preheader || bb == bottom)
+            continue;
+        for (IRInstr *instr : bb->instrs)
+        {
+            bool exitPhi = bb == exit && instr->op == IRInstr::phi;
+            for (int u : instr->use_indices())
+            {
+                IROperand &o = instr->params[u];
+                if (!exitPhi && o.isVreg() && renamed.count(o.id))
+                    o = renamed[o.id];
+            }
+        }
+        if (bb->test_var.isVreg() && renamed.count(bb->test_var.id))
+            bb->test_var = renamed[bb->test_var.id];
+    }
+    exit->instrs.insert(exit->instrs.begin(), exitPhis.begin(), exitPhis.end());
+    cfg->invalidate_analyses();
+    cfg->compute_predecessors();
+}
+
+} // namespace
+
+void LoopRotationPass::runOnFunction(CFG *cfg)
+{
+    if (!cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // les valeurs de l'en-tête sont fusionnées par des phi
+    }
+
+    vector<BasicBlock *> headers;
+    for (Loop *loop : cfg->get_loops()->loops())
+    {
+        headers.push_back(loop->header);
+    }
+    for (BasicBlock *header : headers)
+    {
+        BasicBlock *preheader = cfg->ensure_preheader(header);
+        LoopRotation(cfg, cfg->get_loops()->loopFor(header), preheader).run();
+    }
+}
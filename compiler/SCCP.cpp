@@ -0,0 +1,455 @@
+#include "Passes.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <set>
+using namespace std;
+
+// Propagation de constantes conditionnelle creuse (Wegman et Zadeck) sur la forme SSA.
+// Chaque registre virtuel porte une valeur du treillis indéfini > constante > variable; seuls les
+// arcs dont la condition n'est pas prouvée fausse sont suivis, si bien qu'une constante qui décide
+// d'un branchement supprime aussi les valeurs qui n'arrivent que par la branche morte.
+// Les constantes sont calculées comme à l'exécution: entiers 32 bits modulo 2^32, flottants simple précision.
+
+namespace
+{
+
+struct LatticeValue
+{
+    typedef enum { undefined, constant, overdefined } Kind;
+    Kind kind = undefined;
+    string value; /**< text of the immediate when kind == constant */
+
+    static LatticeValue makeConstant(string value)
+    {
+        LatticeValue v;
+        v.kind = constant;
+        v.value = value;
+        return v;
+    }
+    static LatticeValue makeOverdefined()
+    {
+        LatticeValue v;
+        v.kind = overdefined;
+        return v;
+    }
+    bool operator==(const LatticeValue &other) const { return kind == other.kind && value == other.value; }
+};
+
+LatticeValue meet(const LatticeValue &a, const LatticeValue &b)
+{
+    if (a.kind == LatticeValue::undefined)
+        return b;
+    if (b.kind == LatticeValue::undefined)
+        return a;
+    if (a == b)
+        return a;
+    return LatticeValue::makeOverdefined();
+}
+
+bool parseInt(const string &text, int &value)
+{
+    char *end;
+    long v = strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || v < INT_MIN || v > INT_MAX)
+        return false;
+    value = v;
+    return true;
+}
+
+bool parseFloat(const string &text, float &value)
+{
+    char *end;
+    value = strtof(text.c_str(), &end);
+    return !text.empty() && *end == '\0';
+}
+
+// Assez de chiffres pour que stof relise exactement la même valeur
+string formatFloat(float value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+bool foldInt(IRInstr::Operation op, int a, int b, int &result)
+{
+    uint32_t ua = a, ub = b;
+    switch (op)
+    {
+    case IRInstr::add: result = (int)(ua + ub); return true;
+    case IRInstr::sub: result = (int)(ua - ub); return true;
+    case IRInstr::mul: result = (int)(ua * ub); return true;
+    case IRInstr::div:
+    case IRInstr::mod:
+        if (b == 0 || (a == INT_MIN && b == -1))
+            return false; // l'exécution lève une exception: on la laisse se produire
+        result = (op == IRInstr::div) ? a / b : a % b;
+        return true;
+    case IRInstr::cmp_eq: result = a == b; return true;
+    case IRInstr::cmp_ne: result = a != b; return true;
+    case IRInstr::cmp_lt: result = a < b; return true;
+    case IRInstr::cmp_le: result = a <= b; return true;
+    case IRInstr::cmp_gt: result = a > b; return true;
+    case IRInstr::cmp_ge: result = a >= b; return true;
+    case IRInstr::bit_and: result = a & b; return true;
+    case IRInstr::bit_or: result = a | b; return true;
+    case IRInstr::bit_xor: result = a ^ b; return true;
+    case IRInstr::log_and: result = a && b; return true;
+    case IRInstr::log_or: result = a || b; return true;
+    default: return false;
+    }
+}
+
+// Résultat d'une opération binaire sur des flottants: un flottant, ou 0/1 pour une comparaison
+bool foldFloat(IRInstr::Operation op, float a, float b, string &result)
+{
+    switch (op)
+    {
+    case IRInstr::add: result = formatFloat(a + b); return true;
+    case IRInstr::sub: result = formatFloat(a - b); return true;
+    case IRInstr::mul: result = formatFloat(a * b); return true;
+    case IRInstr::div: result = formatFloat(a / b); return true;
+    case IRInstr::cmp_eq: result = to_string(a == b); return true;
+    case IRInstr::cmp_ne: result = to_string(a != b); return true;
+    case IRInstr::cmp_lt: result = to_string(a < b); return true;
+    case IRInstr::cmp_le: result = to_string(a <= b); return true;
+    case IRInstr::cmp_gt: result = to_string(a > b); return true;
+    case IRInstr::cmp_ge: result = to_string(a >= b); return true;
+    default: return false;
+    }
+}
+
+class SCCPSolver
+{
+public:
+    SCCPSolver(CFG *cfg) : cfg(cfg), values(cfg->get_vreg_count()), users(cfg->get_vreg_count()), testers(cfg->get_vreg_count()) {}
+
+    void solve();
+    void rewrite();
+
+private:
+    LatticeValue valueOf(const IROperand &o);
+    LatticeValue evaluate(IRInstr *instr);
+    void update(IRInstr *instr);
+    void visitBlock(BasicBlock *bb);
+    void visitExits(BasicBlock *bb);
+    void markEdge(BasicBlock *from, BasicBlock *to);
+
+    CFG *cfg;
+    vector<LatticeValue> values;
+    vector<vector<IRInstr *>> users;      /**< instructions reading each vreg */
+    vector<vector<BasicBlock *>> testers; /**< blocks testing each vreg at their end */
+    set<BasicBlock *> executable;
+    set<pair<BasicBlock *, BasicBlock *>> executableEdges;
+    vector<pair<BasicBlock *, BasicBlock *>> flowWorklist;
+    vector<int> ssaWorklist;
+};
+
+LatticeValue SCCPSolver::valueOf(const IROperand &o)
+{
+    if (o.isImm())
+        return LatticeValue::makeConstant(o.name);
+    if (o.isVreg())
+        return values[o.id];
+    return LatticeValue::makeOverdefined(); // globale ou registre physique: inconnu
+}
+
+LatticeValue SCCPSolver::evaluate(IRInstr *instr)
+{
+    if (instr->op == IRInstr::phi)
+    {
+        LatticeValue result;
+        for (size_t i = 0; i < instr->phi_preds.size(); i++)
+        {
+            if (executableEdges.count({instr->phi_preds[i], instr->bb}))
+                result = meet(result, valueOf(instr->params[i + 1]));
+        }
+        return result;
+    }
+
+    vector<LatticeValue> operands;
+    switch (instr->op)
+    {
+    case IRInstr::copy:
+    case IRInstr::ldconst:
+        return valueOf(instr->params[1]);
+    case IRInstr::add: case IRInstr::sub: case IRInstr::mul: case IRInstr::div: case IRInstr::mod:
+    case IRInstr::cmp_eq: case IRInstr::cmp_ne: case IRInstr::cmp_lt:
+    case IRInstr::cmp_le: case IRInstr::cmp_gt: case IRInstr::cmp_ge:
+    case IRInstr::bit_and: case IRInstr::bit_or: case IRInstr::bit_xor:
+    case IRInstr::log_and: case IRInstr::log_or:
+        operands = {valueOf(instr->params[1]), valueOf(instr->params[2])};
+        break;
+    case IRInstr::unary_minus:
+    case IRInstr::not_op:
+    case IRInstr::intToFloat:
+    case IRInstr::floatToInt:
+        operands = {valueOf(instr->params[1])};
+        break;
+    default:
+        return LatticeValue::makeOverdefined(); // lecture d'un tableau ou de la mémoire
+    }
+
+    for (LatticeValue &v : operands)
+    {
+        if (v.kind == LatticeValue::overdefined)
+            return v;
+    }
+    for (LatticeValue &v : operands)
+    {
+        if (v.kind == LatticeValue::undefined)
+            return v;
+    }
+
+    bool isFloat = Symbol::isFloatingType(instr->t);
+    int a = 0, b = 0, r = 0;
+    float fa = 0, fb = 0;
+    string folded;
+    bool ok = false;
+    switch (instr->op)
+    {
+    case IRInstr::unary_minus:
+        if (isFloat)
+        {
+            ok = parseFloat(operands[0].value, fa);
+            folded = formatFloat(-fa);
+        }
+        else if ((ok = parseInt(operands[0].value, a)))
+        {
+            folded = to_string((int)(0u - (uint32_t)a));
+        }
+        break;
+    case IRInstr::not_op:
+        if ((ok = parseInt(operands[0].value, a)))
+            folded = to_string(!a);
+        break;
+    case IRInstr::intToFloat:
+        if ((ok = parseInt(operands[0].value, a)))
+            folded = formatFloat((float)a);
+        break;
+    case IRInstr::floatToInt:
+        // cvttss2si rend 0x80000000 hors de l'intervalle: on ne plie que les conversions définies
+        ok = parseFloat(operands[0].value, fa) && fa > -2147483904.0f && fa < 2147483648.0f;
+        if (ok)
+            folded = to_string((int)fa);
+        break;
+    default:
+        if (isFloat)
+        {
+            ok = parseFloat(operands[0].value, fa) && parseFloat(operands[1].value, fb) && foldFloat(instr->op, fa, fb, folded);
+        }
+        else if (parseInt(operands[0].value, a) && parseInt(operands[1].value, b) && foldInt(instr->op, a, b, r))
+        {
+            ok = true;
+            folded = to_string(r);
+        }
+        break;
+    }
+    return ok ? LatticeValue::makeConstant(folded) : LatticeValue::makeOverdefined();
+}
+
+void SCCPSolver::update(IRInstr *instr)
+{
+    int d = instr->def_index();
+    if (d < 0 || !instr->params[d].isVreg())
+        return;
+    int v = instr->params[d].id;
+    LatticeValue result = meet(values[v], evaluate(instr));
+    if (!(result == values[v]))
+    {
+        values[v] = result;
+        ssaWorklist.push_back(v);
+    }
+}
+
+void SCCPSolver::visitExits(BasicBlock *bb)
+{
+    if (bb->exit_false == nullptr)
+    {
+        if (bb->exit_true != nullptr)
+            markEdge(bb, bb->exit_true);
+        return;
+    }
+
+    LatticeValue test = valueOf(bb->test_var);
+    int value;
+    if (test.kind == LatticeValue::constant && parseInt(test.value, value))
+    {
+        markEdge(bb, value != 0 ? bb->exit_true : bb->exit_false);
+    }
+    else if (test.kind != LatticeValue::undefined)
+    {
+        markEdge(bb, bb->exit_true);
+        markEdge(bb, bb->exit_false);
+    }
+}
+
+void SCCPSolver::visitBlock(BasicBlock *bb)
+{
+    for (IRInstr *instr : bb->instrs)
+    {
+        update(instr);
+    }
+    visitExits(bb);
+}
+
+void SCCPSolver::markEdge(BasicBlock *from, BasicBlock *to)
+{
+    if (executableEdges.insert({from, to}).second)
+        flowWorklist.push_back({from, to});
+}
+
+void SCCPSolver::solve()
+{
+    // Un registre lu sans définition unique (variable non initialisée, tableau) est inconnu
+    vector<int> defs(cfg->get_vreg_count(), 0);
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (d >= 0 && instr->params[d].isVreg())
+                defs[instr->params[d].id]++;
+            for (size_t i = 0; i < instr->params.size(); i++)
+            {
+                if ((int)i != d && instr->params[i].isVreg())
+                    users[instr->params[i].id].push_back(instr);
+            }
+        }
+        if (bb->exit_false != nullptr && bb->test_var.isVreg())
+            testers[bb->test_var.id].push_back(bb);
+    }
+    for (size_t v = 0; v < values.size(); v++)
+    {
+        if (defs[v] != 1)
+            values[v] = LatticeValue::makeOverdefined();
+    }
+
+    BasicBlock *entry = cfg->get_bbs()[0];
+    executable.insert(entry);
+    visitBlock(entry);
+    while (!flowWorklist.empty() || !ssaWorklist.empty())
+    {
+        while (!flowWorklist.empty())
+        {
+            pair<BasicBlock *, BasicBlock *> edge = flowWorklist.back();
+            flowWorklist.pop_back();
+            BasicBlock *bb = edge.second;
+            if (executable.insert(bb).second)
+            {
+                visitBlock(bb);
+                continue;
+            }
+            // Bloc déjà visité: seul un nouvel arc entrant change ses phi
+            for (IRInstr *instr : bb->instrs)
+            {
+                if (instr->op != IRInstr::phi)
+                    break;
+                update(instr);
+            }
+        }
+        while (!ssaWorklist.empty())
+        {
+            int v = ssaWorklist.back();
+            ssaWorklist.pop_back();
+            for (IRInstr *instr : users[v])
+            {
+                if (executable.count(instr->bb))
+                    update(instr);
+            }
+            for (BasicBlock *bb : testers[v])
+            {
+                if (executable.count(bb))
+                    visitExits(bb);
+            }
+        }
+    }
+}
+
+void SCCPSolver::rewrite()
+{
+    auto constantOf = [&](const IROperand &o) -> bool { return o.isVreg() && values[o.id].kind == LatticeValue::constant; };
+    auto immediate = [&](const IROperand &o) { return IROperand::makeImm(values[o.id].value, cfg->get_vreg(o.id).type); };
+
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        // Les définitions de constantes disparaissent, leurs lectures deviennent des immédiats
+        vector<IRInstr *> kept;
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (d >= 0 && constantOf(instr->params[d]))
+            {
+                delete instr;
+                continue;
+            }
+            for (size_t i = 0; i < instr->params.size(); i++)
+            {
+                if ((int)i != d && constantOf(instr->params[i]))
+                    instr->params[i] = immediate(instr->params[i]);
+            }
+            kept.push_back(instr);
+        }
+        bb->instrs = kept;
+        if (constantOf(bb->test_var))
+            bb->test_var = immediate(bb->test_var);
+
+        // Branchement dont la condition est connue: on ne garde que l'arc suivi
+        int test;
+        if (bb->exit_false != nullptr && bb->test_var.isImm() && parseInt(bb->test_var.name, test))
+        {
+            bool taken = test != 0;
+            BasicBlock *target = taken ? bb->exit_true : bb->exit_false;
+            BasicBlock *dropped = taken ? bb->exit_false : bb->exit_true;
+            if (dropped != target)
+            {
+                for (IRInstr *instr : dropped->instrs)
+                {
+                    if (instr->op != IRInstr::phi)
+                        break;
+                    for (size_t i = instr->phi_preds.size(); i-- > 0;)
+                    {
+                        if (instr->phi_preds[i] == bb)
+                        {
+                            instr->phi_preds.erase(instr->phi_preds.begin() + i);
+                            instr->params.erase(instr->params.begin() + i + 1);
+                        }
+                    }
+                }
+            }
+            bb->exit_true = target;
+            bb->exit_false = nullptr;
+            bb->test_var = IROperand();
+            cfg->invalidate_analyses();
+        }
+    }
+    cfg->remove_unreachable_bbs();
+
+    // Un phi qui n'a plus qu'un arc entrant est une copie
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (instr->op == IRInstr::phi && instr->phi_preds.size() == 1)
+            {
+                instr->op = IRInstr::copy;
+                instr->phi_preds.clear();
+            }
+        }
+    }
+}
+
+} // namespace
+
+void SCCPPass::runOnFunction(CFG *cfg)
+{
+    if (!cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // les valeurs ne sont suivies que sur la forme SSA
+    }
+    SCCPSolver solver(cfg);
+    solver.solve();
+    solver.rewrite();
+}
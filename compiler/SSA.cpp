@@ -0,0 +1,360 @@
+#include "IR.h"
+#include "Dominators.h"
+#include <map>
+#include <set>
+using namespace std;
+
+// Construction et destruction de la forme SSA d'un CFG.
+// Seuls les scalaires locaux (variables, paramètres, temporaires) sont renommés: les tableaux
+// sont adressés par leur offset et les globales restent en mémoire.
+
+static bool isRenamed(CFG *cfg, const IROperand &o, int nbVars)
+{
+    return o.isVreg() && o.id < nbVars && !cfg->get_vreg(o.id).isArray();
+}
+
+static bool isPhi(IRInstr *instr)
+{
+    return instr->op == IRInstr::phi;
+}
+
+// incr et decr lisent et écrivent leur opérande: en SSA on les réécrit en add/sub
+static void expandIncrDecr(BasicBlock *bb)
+{
+    for (IRInstr *instr : bb->instrs)
+    {
+        if (instr->op != IRInstr::incr && instr->op != IRInstr::decr)
+        {
+            continue;
+        }
+        IROperand var = instr->params[0];
+        IROperand one = Symbol::isFloatingType(instr->t) ? IROperand::makeImm("1.0", instr->t)
+                                                         : IROperand::makeImm("1", VarType::INT);
+        instr->op = (instr->op == IRInstr::incr) ? IRInstr::add : IRInstr::sub;
+        instr->params = {var, var, one};
+    }
+}
+
+static IROperand top(vector<vector<int>> &stacks, CFG *cfg, int var)
+{
+    int id = stacks[var].empty() ? var : stacks[var].back();
+    return IROperand::makeVreg(id, cfg->get_vreg(id).type);
+}
+
+static void rename(CFG *cfg, BasicBlock *bb, DominatorTree *dom, vector<vector<int>> &stacks, int nbVars)
+{
+    vector<int> pushed;
+    for (IRInstr *instr : bb->instrs)
+    {
+        if (!isPhi(instr))
+        {
+            for (int u : instr->use_indices())
+            {
+                if (isRenamed(cfg, instr->params[u], nbVars))
+                {
+                    instr->params[u] = top(stacks, cfg, instr->params[u].id);
+                }
+            }
+        }
+
+        int d = instr->def_index();
+        if (d >= 0 && isRenamed(cfg, instr->params[d], nbVars))
+        {
+            int var = instr->params[d].id;
+            VirtualRegister origin = cfg->get_vreg(var);
+            int version = cfg->new_vreg(origin.type, 1, origin.name + "." + to_string(cfg->get_vreg_count()));
+            stacks[var].push_back(version);
+            pushed.push_back(var);
+            instr->params[d] = IROperand::makeVreg(version, origin.type);
+        }
+    }
+
+    if (isRenamed(cfg, bb->test_var, nbVars))
+    {
+        bb->test_var = top(stacks, cfg, bb->test_var.id);
+    }
+
+    // Les phi des successeurs reçoivent la version courante venant de ce bloc
+    for (BasicBlock *succ : bb->successors())
+    {
+        for (IRInstr *instr : succ->instrs)
+        {
+            if (!isPhi(instr))
+            {
+                break;
+            }
+            for (size_t i = 0; i < instr->phi_preds.size(); i++)
+            {
+                if (instr->phi_preds[i] == bb && isRenamed(cfg, instr->params[i + 1], nbVars))
+                {
+                    instr->params[i + 1] = top(stacks, cfg, instr->params[i + 1].id);
+                }
+            }
+        }
+    }
+
+    for (BasicBlock *child : dom->children(bb))
+    {
+        rename(cfg, child, dom, stacks, nbVars);
+    }
+
+    for (int var : pushed)
+    {
+        stacks[var].pop_back();
+    }
+}
+
+// Supprime les phi dont le résultat n'est lu par aucune instruction utile
+static void removeDeadPhis(vector<BasicBlock *> &bbs)
+{
+    map<int, IRInstr *> phiOf;
+    vector<int> worklist;
+    for (BasicBlock *bb : bbs)
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (isPhi(instr))
+            {
+                phiOf[instr->params[0].id] = instr;
+                continue;
+            }
+            for (int u : instr->use_indices())
+            {
+                if (instr->params[u].isVreg())
+                    worklist.push_back(instr->params[u].id);
+            }
+        }
+        if (bb->test_var.isVreg())
+        {
+            worklist.push_back(bb->test_var.id);
+        }
+    }
+
+    set<IRInstr *> live;
+    while (!worklist.empty())
+    {
+        int id = worklist.back();
+        worklist.pop_back();
+        auto it = phiOf.find(id);
+        if (it == phiOf.end() || !live.insert(it->second).second)
+        {
+            continue;
+        }
+        for (size_t i = 1; i < it->second->params.size(); i++)
+        {
+            worklist.push_back(it->second->params[i].id);
+        }
+    }
+
+    for (BasicBlock *bb : bbs)
+    {
+        vector<IRInstr *> kept;
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (isPhi(instr) && !live.count(instr))
+            {
+                delete instr;
+                continue;
+            }
+            kept.push_back(instr);
+        }
+        bb->instrs = kept;
+    }
+}
+
+void CFG::to_ssa()
+{
+    if (in_ssa || bbs.empty())
+    {
+        return;
+    }
+    remove_unreachable_bbs();
+    DominatorTree *dom = get_dominators();
+
+    // Les versions créées par le renommage ne sont pas elles-mêmes renommées
+    int nbVars = vregs.size();
+
+    // Blocs de définition de chaque variable, et variables lues avant d'être écrites dans un bloc:
+    // seules ces dernières peuvent avoir besoin d'un phi (SSA semi-élagué)
+    vector<vector<BasicBlock *>> defBlocks(nbVars);
+    vector<bool> crossesBlocks(nbVars, false);
+    for (BasicBlock *bb : bbs)
+    {
+        expandIncrDecr(bb);
+        set<int> defined;
+        for (IRInstr *instr : bb->instrs)
+        {
+            for (int u : instr->use_indices())
+            {
+                const IROperand &o = instr->params[u];
+                if (isRenamed(this, o, nbVars) && !defined.count(o.id))
+                    crossesBlocks[o.id] = true;
+            }
+            int d = instr->def_index();
+            if (d >= 0 && isRenamed(this, instr->params[d], nbVars))
+            {
+                int var = instr->params[d].id;
+                defined.insert(var);
+                if (defBlocks[var].empty() || defBlocks[var].back() != bb)
+                    defBlocks[var].push_back(bb);
+            }
+        }
+        if (isRenamed(this, bb->test_var, nbVars) && !defined.count(bb->test_var.id))
+        {
+            crossesBlocks[bb->test_var.id] = true;
+        }
+    }
+
+    // Placement des phi sur la frontière de dominance itérée des définitions
+    map<BasicBlock *, vector<IRInstr *>> phis;
+    for (int var = 0; var < nbVars; var++)
+    {
+        if (!crossesBlocks[var] || defBlocks[var].empty())
+        {
+            continue;
+        }
+        VarType type = vregs[var].type;
+        set<BasicBlock *> hasPhi;
+        set<BasicBlock *> queued(defBlocks[var].begin(), defBlocks[var].end());
+        vector<BasicBlock *> worklist = defBlocks[var];
+        while (!worklist.empty())
+        {
+            BasicBlock *bb = worklist.back();
+            worklist.pop_back();
+            for (BasicBlock *join : dom->frontier(bb))
+            {
+                if (!hasPhi.insert(join).second)
+                {
+                    continue;
+                }
+                vector<IROperand> params(join->preds.size() + 1, IROperand::makeVreg(var, type));
+                IRInstr *phi = new IRInstr(join, IRInstr::phi, type, params);
+                phi->phi_preds = join->preds;
+                phis[join].push_back(phi);
+                if (queued.insert(join).second)
+                {
+                    worklist.push_back(join);
+                }
+            }
+        }
+    }
+    for (BasicBlock *bb : bbs)
+    {
+        vector<IRInstr *> &list = phis[bb];
+        bb->instrs.insert(bb->instrs.begin(), list.begin(), list.end());
+    }
+
+    vector<vector<int>> stacks(nbVars);
+    rename(this, bbs[0], dom, stacks, nbVars);
+    removeDeadPhis(bbs);
+    in_ssa = true;
+}
+
+static void emitCopy(BasicBlock *bb, const IROperand &dest, const IROperand &src)
+{
+    IRInstr::Operation op = (src.isImm() && !Symbol::isFloatingType(src.type)) ? IRInstr::ldconst : IRInstr::copy;
+    bb->instrs.push_back(new IRInstr(bb, op, dest.type, {dest, src}));
+}
+
+// Séquentialise les copies parallèles dest <- src en fin de bloc, avec un temporaire pour casser les cycles
+static void emitParallelCopies(CFG *cfg, BasicBlock *bb, vector<pair<IROperand, IROperand>> copies)
+{
+    vector<pair<IROperand, IROperand>> pending;
+    for (auto &copy : copies)
+    {
+        if (copy.first != copy.second)
+            pending.push_back(copy);
+    }
+
+    while (!pending.empty())
+    {
+        bool progress = false;
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            // Une destination qui n'est plus lue par une autre copie peut être écrasée
+            bool isSource = false;
+            for (auto &other : pending)
+            {
+                if (other.second == pending[i].first)
+                    isSource = true;
+            }
+            if (!isSource)
+            {
+                emitCopy(bb, pending[i].first, pending[i].second);
+                pending.erase(pending.begin() + i);
+                progress = true;
+                break;
+            }
+        }
+        if (progress)
+        {
+            continue;
+        }
+
+        // Il ne reste que des cycles: on sauvegarde une destination avant de l'écraser
+        IROperand dest = pending[0].first;
+        IROperand saved = IROperand::makeVreg(cfg->new_vreg(dest.type, cfg->get_vreg(dest.id).size, "swap"), dest.type);
+        emitCopy(bb, saved, dest);
+        for (auto &other : pending)
+        {
+            if (other.second == dest)
+                other.second = saved;
+        }
+    }
+}
+
+void CFG::from_ssa()
+{
+    if (!in_ssa)
+    {
+        return;
+    }
+    compute_predecessors();
+
+    vector<BasicBlock *> joins;
+    for (BasicBlock *bb : bbs)
+    {
+        if (!bb->instrs.empty() && isPhi(bb->instrs[0]))
+            joins.push_back(bb);
+    }
+
+    for (BasicBlock *join : joins)
+    {
+        // Les copies d'un arc critique ne peuvent aller ni dans le prédécesseur ni dans le successeur
+        vector<BasicBlock *> preds = join->preds;
+        for (BasicBlock *pred : preds)
+        {
+            if (pred->successors().size() > 1)
+                split_edge(pred, join);
+        }
+
+        for (BasicBlock *pred : join->preds)
+        {
+            vector<pair<IROperand, IROperand>> copies;
+            for (IRInstr *instr : join->instrs)
+            {
+                if (!isPhi(instr))
+                    break;
+                for (size_t i = 0; i < instr->phi_preds.size(); i++)
+                {
+                    if (instr->phi_preds[i] == pred)
+                        copies.push_back({instr->params[0], instr->params[i + 1]});
+                }
+            }
+            emitParallelCopies(this, pred, copies);
+        }
+
+        vector<IRInstr *> kept;
+        for (IRInstr *instr : join->instrs)
+        {
+            if (isPhi(instr))
+            {
+                delete instr;
+                continue;
+            }
+            kept.push_back(instr);
+        }
+        join->instrs = kept;
+    }
+    in_ssa = false;
+}
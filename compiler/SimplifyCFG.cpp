@@ -0,0 +1,146 @@
+#include "Passes.h"
+#include <set>
+#include <algorithm>
+using namespace std;
+
+// Simplification du graphe de flot, hors SSA: les blocs vides qui ne font que sauter sont court-circuités,
+// un bloc qui n'a qu'un prédécesseur, dont il est l'unique successeur, est fusionné avec lui, et les blocs
+// devenus inaccessibles (code après un return...) sont supprimés. Le bloc d'entrée, qui porte le
+// prologue, et l'épilogue restent en place.
+
+namespace
+{
+
+class CFGSimplifier
+{
+public:
+    CFGSimplifier(CFG *cfg) : cfg(cfg) {}
+    void run();
+
+private:
+    bool isForwarder(BasicBlock *bb); /**< empty block ending with an unconditional jump */
+    BasicBlock *finalTarget(BasicBlock *bb); /**< the block reached from bb through forwarders */
+    bool threadJumps();
+    bool mergeBlocks();
+
+    CFG *cfg;
+};
+
+bool CFGSimplifier::isForwarder(BasicBlock *bb)
+{
+    return bb != cfg->get_bbs()[0] && bb != cfg->epilogue_bb && bb->instrs.empty() && bb->exit_true != nullptr &&
+           bb->exit_false == nullptr;
+}
+
+BasicBlock *CFGSimplifier::finalTarget(BasicBlock *bb)
+{
+    set<BasicBlock *> seen;
+    while (isForwarder(bb) && seen.insert(bb).second)
+    {
+        bb = bb->exit_true;
+    }
+    return bb; // une boucle de blocs vides (while (1) {}) s'arrête sur l'un d'eux
+}
+
+bool CFGSimplifier::threadJumps()
+{
+    bool changed = false;
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (BasicBlock **exit : {&bb->exit_true, &bb->exit_false})
+        {
+            if (*exit == nullptr)
+                continue;
+            BasicBlock *target = finalTarget(*exit);
+            if (target != *exit && target != bb)
+            {
+                *exit = target;
+                changed = true;
+            }
+        }
+        // Les deux branches mènent au même bloc: le test ne sert plus
+        if (bb->exit_false != nullptr && bb->exit_false == bb->exit_true)
+        {
+            bb->exit_false = nullptr;
+            bb->test_var = IROperand();
+            bb->test_var_name.clear();
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool CFGSimplifier::mergeBlocks()
+{
+    cfg->compute_predecessors();
+    vector<BasicBlock *> &bbs = cfg->get_bbs();
+    set<BasicBlock *> merged;
+    for (BasicBlock *bb : bbs)
+    {
+        if (merged.count(bb))
+            continue;
+        // bb absorbe ses successeurs uniques tant qu'ils n'ont pas d'autre prédécesseur
+        while (bb->exit_false == nullptr && bb->exit_true != nullptr)
+        {
+            BasicBlock *next = bb->exit_true;
+            if (next == bb || next == bbs[0] || next == cfg->epilogue_bb || next->preds.size() != 1)
+                break;
+            for (IRInstr *instr : next->instrs)
+            {
+                instr->bb = bb;
+                bb->instrs.push_back(instr);
+            }
+            next->instrs.clear();
+            bb->exit_true = next->exit_true;
+            bb->exit_false = next->exit_false;
+            bb->test_var = next->test_var;
+            bb->test_var_name = next->test_var_name;
+            // Les successeurs de next ont maintenant bb pour prédécesseur
+            for (BasicBlock *succ : bb->successors())
+                replace(succ->preds.begin(), succ->preds.end(), next, bb);
+            next->exit_true = nullptr;
+            next->exit_false = nullptr;
+            merged.insert(next);
+        }
+    }
+    if (merged.empty())
+    {
+        return false;
+    }
+    vector<BasicBlock *> kept;
+    for (BasicBlock *bb : bbs)
+    {
+        if (merged.count(bb))
+            delete bb;
+        else
+            kept.push_back(bb);
+    }
+    bbs = kept;
+    return true;
+}
+
+void CFGSimplifier::run()
+{
+    cfg->remove_unreachable_bbs();
+    bool changed = true;
+    while (changed)
+    {
+        changed = threadJumps();
+        cfg->invalidate_analyses();
+        cfg->remove_unreachable_bbs();
+        changed |= mergeBlocks();
+        cfg->invalidate_analyses();
+    }
+    cfg->compute_predecessors();
+}
+
+} // namespace
+
+void SimplifyCFGPass::runOnFunction(CFG *cfg)
+{
+    if (cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // les phi nomment leurs prédécesseurs: la fusion des blocs les invaliderait
+    }
+    CFGSimplifier(cfg).run();
+}
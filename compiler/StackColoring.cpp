@@ -0,0 +1,68 @@
+#include "Passes.h"
+#include "LiveIntervals.h"
+#include <algorithm>
+using namespace std;
+
+// Coloriage des emplacements de pile: les valeurs restées en mémoire après l'allocation de registres
+// reçoivent leur emplacement d'après leur intervalle de vie, et deux valeurs dont les intervalles sont
+// disjoints partagent le même emplacement. Un emplacement est un mot de 4 octets; une valeur de taille n
+// (tableau, sauvegarde d'un registre 64 bits) occupe n mots contigus.
+
+void StackColoringPass::runOnFunction(CFG *cfg)
+{
+    vector<int> calls;
+    vector<LiveInterval> intervals = buildLiveIntervals(cfg, calls);
+
+    // Les sauvegardes des registres de l'appelé vivent du prologue à l'épilogue, comme les tableaux dont
+    // l'adresse est prise (StrengthReduction.cpp): on y accède ensuite par un pointeur, sans les nommer
+    for (auto &saved : cfg->saved_regs)
+    {
+        intervals[saved.second].start = -1;
+        intervals[saved.second].end = INT_MAX;
+    }
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (instr->op != IRInstr::addrTblx)
+                continue;
+            intervals[instr->params[1].id].start = -1;
+            intervals[instr->params[1].id].end = INT_MAX;
+        }
+    }
+
+    vector<LiveInterval *> sorted;
+    for (LiveInterval &interval : intervals)
+    {
+        VirtualRegister &vreg = cfg->get_vreg(interval.vreg);
+        if (interval.end < 0 || !vreg.reg.empty())
+        {
+            vreg.offset = 0; // jamais lu ni écrit en mémoire: pas d'emplacement
+            continue;
+        }
+        sorted.push_back(&interval);
+    }
+    stable_sort(sorted.begin(), sorted.end(), [](LiveInterval *a, LiveInterval *b) { return a->start < b->start; });
+
+    // Premier emplacement libre assez grand, en partant du haut du cadre
+    vector<pair<LiveInterval *, int>> active; // intervalle et premier mot occupé
+    for (LiveInterval *current : sorted)
+    {
+        active.erase(remove_if(active.begin(), active.end(), [&](pair<LiveInterval *, int> &a) { return a.first->end < current->start; }), active.end());
+        sort(active.begin(), active.end(), [](const pair<LiveInterval *, int> &a, const pair<LiveInterval *, int> &b) { return a.second < b.second; });
+
+        int size = cfg->get_vreg(current->vreg).size;
+        int word = 1;
+        for (auto &a : active)
+        {
+            if (word + size <= a.second)
+                break;
+            word = max(word, a.second + cfg->get_vreg(a.first->vreg).size);
+        }
+
+        // Le mot le plus bas d'une valeur est à -offset(%rbp), les suivants au-dessus
+        cfg->get_vreg(current->vreg).offset = 4 * (word + size - 1);
+        active.push_back({current, word});
+    }
+    cfg->frame_compacted = true;
+}
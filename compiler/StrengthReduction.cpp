@@ -0,0 +1,402 @@
+#include "Passes.h"
+#include "Loops.h"
+#include <map>
+#include <set>
+using namespace std;
+
+// Réduction de force des variables d'induction: un accès a[i] dans une boucle où i avance d'un pas constant
+// recalculait son adresse à chaque tour (extension de signe de i, puis base + 4 * i). On tient à la place
+// un pointeur sur a[i], initialisé dans le preheader et avancé de 4 * pas à côté de i; a[i + k] se lit
+// à un déplacement constant de ce pointeur. Si le compteur ne sert plus qu'au test de sortie, ce test
+// compare directement le pointeur à l'adresse de a[borne] et le compteur disparaît: la boucle ne
+// manipule plus que des valeurs 64 bits, sans extension de signe.
+
+namespace
+{
+
+/** A vreg equal to base + offset, base being the phi (before the step) or the step of an induction variable */
+struct IndexForm
+{
+    int iv;
+    bool afterStep;
+    int offset;
+};
+
+/** The pointer walking an array along an induction variable: p = phi(&a[init], next) in the header, next = p + 4 * stride */
+struct ArrayPointer
+{
+    IROperand current;
+    IROperand next;
+};
+
+IRInstr::Operation arithmeticOf(IRInstr::Operation op)
+{
+    switch (op)
+    {
+    case IRInstr::addTblx:
+        return IRInstr::add;
+    case IRInstr::subTblx:
+        return IRInstr::sub;
+    case IRInstr::mulTblx:
+        return IRInstr::mul;
+    case IRInstr::divTblx:
+        return IRInstr::div;
+    default:
+        return IRInstr::mod;
+    }
+}
+
+bool isComparison(IRInstr::Operation op)
+{
+    return op == IRInstr::cmp_eq || op == IRInstr::cmp_ne || op == IRInstr::cmp_lt || op == IRInstr::cmp_le ||
+           op == IRInstr::cmp_gt || op == IRInstr::cmp_ge;
+}
+
+class StrengthReduction
+{
+public:
+    StrengthReduction(CFG *cfg, Loop *loop, BasicBlock *preheader);
+    void run();
+
+private:
+    void findIndexForms();
+    bool isAccess(IRInstr *instr); /**< getTblx or *Tblx indexed by a form of an induction variable */
+    ArrayPointer &pointerFor(int iv, int array);
+    void rewriteAccess(IRInstr *instr, vector<IRInstr *> &out);
+    void removeDeadIndices(); /**< the j = i + k whose accesses were rewritten */
+    void replaceExitTests();
+    bool isInvariant(const IROperand &o);
+
+    CFG *cfg;
+    Loop *loop;
+    BasicBlock *preheader;
+    map<int, IRInstr *> defs; /**< instruction defining each vreg of the loop */
+    vector<InductionVariable> ivs;
+    map<int, IndexForm> forms;
+    map<pair<int, int>, ArrayPointer> pointers; /**< (induction variable, array) -> pointer */
+};
+
+StrengthReduction::StrengthReduction(CFG *cfg, Loop *loop, BasicBlock *preheader) : cfg(cfg), loop(loop), preheader(preheader)
+{
+    for (BasicBlock *bb : loop->blocks)
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (d >= 0 && instr->params[d].isVreg())
+                defs[instr->params[d].id] = instr;
+        }
+    }
+}
+
+void StrengthReduction::findIndexForms()
+{
+    for (size_t k = 0; k < ivs.size(); k++)
+    {
+        forms[ivs[k].phi->params[0].id] = {(int)k, false, 0};
+        forms[ivs[k].step->params[0].id] = {(int)k, true, 0};
+    }
+
+    // j = i + k, i - k: dans l'ordre des blocs, la définition d'une valeur précède ses lectures
+    for (BasicBlock *bb : loop->blocks)
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            if ((instr->op != IRInstr::add && instr->op != IRInstr::sub && instr->op != IRInstr::copy) || instr->t != VarType::INT ||
+                forms.count(instr->params[0].id))
+                continue;
+            const IROperand &x = instr->params[1], &y = instr->params[2];
+            if (instr->op == IRInstr::copy)
+            {
+                if (x.isVreg() && forms.count(x.id))
+                    forms[instr->params[0].id] = forms[x.id];
+            }
+            else if (x.isVreg() && forms.count(x.id) && y.isImm())
+            {
+                IndexForm form = forms[x.id];
+                form.offset += (instr->op == IRInstr::sub ? -1 : 1) * stoi(y.name);
+                forms[instr->params[0].id] = form;
+            }
+            else if (instr->op == IRInstr::add && y.isVreg() && forms.count(y.id) && x.isImm())
+            {
+                IndexForm form = forms[y.id];
+                form.offset += stoi(x.name);
+                forms[instr->params[0].id] = form;
+            }
+        }
+    }
+}
+
+bool StrengthReduction::isAccess(IRInstr *instr)
+{
+    if (instr->op == IRInstr::addrTblx || instr->array_param_index() < 0)
+    {
+        return false;
+    }
+    const IROperand &index = instr->params[2];
+    return index.isVreg() && forms.count(index.id);
+}
+
+ArrayPointer &StrengthReduction::pointerFor(int iv, int array)
+{
+    auto it = pointers.find({iv, array});
+    if (it != pointers.end())
+    {
+        return it->second;
+    }
+
+    InductionVariable &v = ivs[iv];
+    VirtualRegister &a = cfg->get_vreg(array);
+    ArrayPointer p;
+    p.current = IROperand::makeVreg(cfg->new_vreg(VarType::ADDRESS, 2, a.name + ".ptr"), VarType::ADDRESS);
+    p.next = IROperand::makeVreg(cfg->new_vreg(VarType::ADDRESS, 2, a.name + ".ptr"), VarType::ADDRESS);
+    IROperand start = IROperand::makeVreg(cfg->new_vreg(VarType::ADDRESS, 2, a.name + ".ptr"), VarType::ADDRESS);
+
+    // p0 = &a[init] dans le preheader, p = phi(p0, next) dans l'en-tête, next = p + 4 * pas (inséré par run)
+    preheader->instrs.push_back(new IRInstr(preheader, IRInstr::addrTblx, a.type, {start, IROperand::makeVreg(array, a.type), v.init}));
+    IRInstr *phi = new IRInstr(loop->header, IRInstr::phi, VarType::ADDRESS, {p.current, start, p.next});
+    phi->phi_preds = {preheader, v.phi->phi_preds[v.phi->phi_preds[0] == preheader ? 1 : 0]};
+    loop->header->instrs.insert(loop->header->instrs.begin(), phi);
+    return pointers[{iv, array}] = p;
+}
+
+void StrengthReduction::rewriteAccess(IRInstr *instr, vector<IRInstr *> &out)
+{
+    int array = instr->array_param_index();
+    IndexForm form = forms[instr->params[2].id];
+    ArrayPointer &p = pointerFor(form.iv, instr->params[array].id);
+    IROperand address = form.afterStep ? p.next : p.current;
+    IROperand displacement = IROperand::makeImm(to_string(4 * form.offset), VarType::INT);
+    VarType element = Symbol::getBaseType(instr->t);
+    BasicBlock *bb = instr->bb;
+
+    if (instr->op == IRInstr::getTblx)
+    {
+        out.push_back(new IRInstr(bb, IRInstr::rmem, element, {instr->params[0], address, displacement}));
+    }
+    else if (instr->op == IRInstr::copyTblx)
+    {
+        out.push_back(new IRInstr(bb, IRInstr::wmem, element, {address, instr->params[1], displacement}));
+    }
+    else
+    {
+        // a[i] op= v: lecture, calcul, écriture
+        IROperand old = IROperand::makeVreg(cfg->new_vreg(element), element);
+        IROperand result = IROperand::makeVreg(cfg->new_vreg(element), element);
+        out.push_back(new IRInstr(bb, IRInstr::rmem, element, {old, address, displacement}));
+        out.push_back(new IRInstr(bb, arithmeticOf(instr->op), element, {result, old, instr->params[1]}));
+        out.push_back(new IRInstr(bb, IRInstr::wmem, element, {address, result, displacement}));
+    }
+    delete instr;
+}
+
+bool StrengthReduction::isInvariant(const IROperand &o)
+{
+    return (o.isImm() && o.type == VarType::INT) || (o.isVreg() && o.type == VarType::INT && defs.count(o.id) == 0);
+}
+
+void StrengthReduction::removeDeadIndices()
+{
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        set<int> used;
+        for (BasicBlock *bb : cfg->get_bbs())
+        {
+            for (IRInstr *instr : bb->instrs)
+            {
+                for (int u : instr->use_indices())
+                {
+                    if (instr->params[u].isVreg())
+                        used.insert(instr->params[u].id);
+                }
+            }
+            if (bb->test_var.isVreg())
+                used.insert(bb->test_var.id);
+        }
+
+        for (BasicBlock *bb : loop->blocks)
+        {
+            vector<IRInstr *> kept;
+            for (IRInstr *instr : bb->instrs)
+            {
+                int d = instr->params[0].id;
+                bool derived = instr->op != IRInstr::phi && instr->params[0].isVreg() && forms.count(d) && d != ivs[forms[d].iv].step->params[0].id;
+                if (derived && !used.count(d))
+                {
+                    forms.erase(d);
+                    delete instr;
+                    changed = true;
+                    continue;
+                }
+                kept.push_back(instr);
+            }
+            bb->instrs = kept;
+        }
+    }
+}
+
+void StrengthReduction::replaceExitTests()
+{
+    // Lectures de chaque vreg dans toute la fonction
+    map<int, vector<IRInstr *>> users;
+    set<int> tested;
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            for (int u : instr->use_indices())
+            {
+                if (instr->params[u].isVreg())
+                    users[instr->params[u].id].push_back(instr);
+            }
+        }
+        if (bb->test_var.isVreg())
+            tested.insert(bb->test_var.id);
+    }
+
+    for (size_t k = 0; k < ivs.size(); k++)
+    {
+        auto first = pointers.lower_bound({(int)k, -1});
+        if (first == pointers.end() || first->first.first != (int)k)
+            continue; // aucun tableau parcouru par cette variable
+        InductionVariable &v = ivs[k];
+        set<IRInstr *> chain = {v.phi, v.step};
+        chain.insert(v.chain.begin(), v.chain.end());
+        set<int> values; // le compteur avant le pas, puis après
+        for (IRInstr *instr : chain)
+            values.insert(instr->params[0].id);
+
+        // Le compteur ne doit plus servir qu'à son pas, à sa mise à jour et à des comparaisons à un invariant
+        vector<IRInstr *> tests;
+        bool replaceable = true;
+        for (int value : values)
+        {
+            if (tested.count(value))
+                replaceable = false;
+            for (IRInstr *user : users[value])
+            {
+                if (chain.count(user))
+                    continue;
+                // Seuls i et next sont à un déplacement nul d'un pointeur
+                bool isTest = isComparison(user->op) && user->t == VarType::INT && loop->contains(user->bb) && forms[value].offset == 0 &&
+                              (user->params[1].id == value ? isInvariant(user->params[2]) : isInvariant(user->params[1]));
+                if (!isTest)
+                {
+                    replaceable = false;
+                    break;
+                }
+                tests.push_back(user);
+            }
+        }
+        if (!replaceable)
+            continue;
+
+        // i < n devient p < &a[n]: les adresses sont rangées comme les indices
+        int array = first->first.second;
+        ArrayPointer &p = first->second;
+        VirtualRegister &a = cfg->get_vreg(array);
+        for (IRInstr *test : tests)
+        {
+            int side = (test->params[1].isVreg() && values.count(test->params[1].id)) ? 1 : 2;
+            IROperand bound = IROperand::makeVreg(cfg->new_vreg(VarType::ADDRESS, 2, a.name + ".end"), VarType::ADDRESS);
+            preheader->instrs.push_back(new IRInstr(preheader, IRInstr::addrTblx, a.type, {bound, IROperand::makeVreg(array, a.type), test->params[3 - side]}));
+            test->params[side] = forms[test->params[side].id].afterStep ? p.next : p.current;
+            test->params[3 - side] = bound;
+            test->t = VarType::ADDRESS;
+        }
+
+        // Le compteur n'a plus de lecteur: on retire sa phi, son pas et ses copies
+        for (BasicBlock *bb : loop->blocks)
+        {
+            vector<IRInstr *> kept;
+            for (IRInstr *instr : bb->instrs)
+            {
+                if (chain.count(instr))
+                    delete instr;
+                else
+                    kept.push_back(instr);
+            }
+            bb->instrs = kept;
+        }
+    }
+}
+
+void StrengthReduction::run()
+{
+    ivs = findInductionVariables(loop, preheader);
+    if (ivs.empty())
+    {
+        return;
+    }
+    findIndexForms();
+
+    // Les pointeurs d'abord, pour savoir quels pas accompagner de l'avancée d'un pointeur
+    vector<IRInstr *> accesses;
+    for (BasicBlock *bb : loop->blocks)
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (isAccess(instr))
+                accesses.push_back(instr);
+        }
+    }
+    if (accesses.empty())
+    {
+        return;
+    }
+    for (IRInstr *instr : accesses)
+    {
+        pointerFor(forms[instr->params[2].id].iv, instr->params[instr->array_param_index()].id);
+    }
+
+    set<IRInstr *> isAccessed(accesses.begin(), accesses.end());
+    for (BasicBlock *bb : loop->blocks)
+    {
+        vector<IRInstr *> out;
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (isAccessed.count(instr))
+            {
+                rewriteAccess(instr, out);
+                continue;
+            }
+            out.push_back(instr);
+            for (auto &[key, p] : pointers)
+            {
+                InductionVariable &v = ivs[key.first];
+                if (instr != v.step)
+                    continue;
+                IROperand stride = IROperand::makeImm(to_string(4 * v.stride), VarType::INT);
+                out.push_back(new IRInstr(bb, IRInstr::add, VarType::ADDRESS, {p.next, p.current, stride}));
+            }
+        }
+        bb->instrs = out;
+    }
+
+    removeDeadIndices();
+    replaceExitTests();
+}
+
+} // namespace
+
+void StrengthReductionPass::runOnFunction(CFG *cfg)
+{
+    if (!cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // les variables d'induction se lisent sur les phi de l'en-tête
+    }
+
+    // Les boucles internes d'abord, comme pour licm
+    vector<BasicBlock *> headers;
+    for (Loop *loop : cfg->get_loops()->loops())
+    {
+        headers.push_back(loop->header);
+    }
+    for (BasicBlock *header : headers)
+    {
+        BasicBlock *preheader = cfg->ensure_preheader(header);
+        StrengthReduction(cfg, cfg->get_loops()->loopFor(header), preheader).run();
+    }
+}
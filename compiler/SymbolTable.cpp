@@ -16,6 +16,7 @@ Symbol SymbolTable::addLocalVariable(std::string name, VarType type, int size) {
             currentDeclOffset += 4;
         }
         Symbol p = { type, currentDeclOffset, ScopeType::BLOCK };
+        p.size = size > 0 ? size : 1;
         table[name] = p;
         return p;
     } else {
@@ -44,6 +45,7 @@ std::string SymbolTable::addTempVariable(VarType type, int size) {
     currentDeclOffset += 4;
     std::string name = "!tmp" + std::to_string(currentDeclOffset);
     Symbol p = { type, currentDeclOffset, ScopeType::BLOCK };
+    p.size = size > 0 ? size : 1;
     table[name] = p;
     return name;
 }
@@ -0,0 +1,297 @@
+#include "Passes.h"
+#include <algorithm>
+using namespace std;
+
+// Appels terminaux, avant la mise en SSA.
+// Un appel récursif terminal (return f(...)) devient une boucle: les arguments sont rangés dans les
+// paramètres et le code reprend après leur copie depuis les registres. Quand le résultat de l'appel est
+// combiné par une addition ou une multiplication entière (return n * f(n - 1)), la combinaison est
+// accumulée dans une variable initialisée à l'élément neutre et appliquée à la valeur rendue par l'épilogue.
+// Les autres appels terminaux, vers une autre fonction, sont marqués: gen_asm défait le cadre de pile
+// puis saute à la fonction appelée, qui revient directement à l'appelant.
+
+namespace
+{
+
+/** A call in tail position: the end of its block only moves its result to the return value */
+struct TailSite
+{
+    BasicBlock *bb;
+    size_t index;                  /**< of the call in bb */
+    IRInstr *combine = nullptr;    /**< addition or multiplication of the result, for an accumulator */
+    IROperand other;               /**< the other operand of combine */
+    vector<IRInstr *> argCopies;   /**< copies of the arguments to their registers, in the order of the parameters */
+};
+
+class TailCallElimination
+{
+public:
+    TailCallElimination(CFG *cfg) : cfg(cfg) {}
+    void run();
+
+private:
+    bool findTailCall(BasicBlock *bb, TailSite &site);
+    bool hasParameterCopies(size_t nbParams);
+    bool findArgumentCopies(TailSite &site, size_t nbParams);
+    bool eliminateRecursion(vector<TailSite> sites);
+    BasicBlock *loopHeader(size_t nbParams);
+
+    CFG *cfg;
+    IROperand returned; /**< the value copied to the return register by the epilogue, none for a void function */
+};
+
+bool TailCallElimination::findTailCall(BasicBlock *bb, TailSite &site)
+{
+    if (bb->exit_true != cfg->epilogue_bb || bb->exit_false != nullptr)
+    {
+        return false;
+    }
+    vector<IRInstr *> &instrs = bb->instrs;
+    size_t k = instrs.size();
+    while (k > 0 && instrs[k - 1]->op != IRInstr::call)
+    {
+        k--;
+    }
+    if (k == 0)
+    {
+        return false;
+    }
+    site.bb = bb;
+    site.index = k - 1;
+
+    // Ce qui suit l'appel: lecture du registre de retour, combinaison éventuelle, copie dans la valeur rendue
+    IROperand result;
+    if (k < instrs.size() && instrs[k]->op == IRInstr::copy && instrs[k]->params[1].kind == IROperand::preg)
+    {
+        result = instrs[k]->params[0];
+        k++;
+    }
+    size_t rest = instrs.size() - k;
+    if (rest == 0)
+    {
+        return returned.isNone();
+    }
+    IRInstr *last = instrs.back();
+    if (returned.isNone() || result.isNone() || last->op != IRInstr::copy || last->params[0] != returned)
+    {
+        return false;
+    }
+    if (rest == 1)
+    {
+        return last->params[1] == result && last->t == instrs[k - 1]->t;
+    }
+    IRInstr *combine = instrs[k];
+    if (rest != 2 || (combine->op != IRInstr::add && combine->op != IRInstr::mul) || combine->t != VarType::INT ||
+        last->params[1] != combine->params[0])
+    {
+        return false;
+    }
+    // L'autre opérande est lu avant l'appel: pas une globale, que l'appel peut modifier
+    IROperand other = combine->params[1] == result ? combine->params[2] : combine->params[1];
+    if ((combine->params[1] != result && combine->params[2] != result) || other == result || (!other.isVreg() && !other.isImm()) ||
+        returned.type != VarType::INT)
+    {
+        return false;
+    }
+    site.combine = combine;
+    site.other = other;
+    return true;
+}
+
+// Le bloc d'entrée commence par la copie des paramètres depuis leurs registres
+bool TailCallElimination::hasParameterCopies(size_t nbParams)
+{
+    BasicBlock *entry = cfg->get_bbs()[0];
+    if (entry->instrs.size() < nbParams)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < nbParams; i++)
+    {
+        IRInstr *instr = entry->instrs[i];
+        if (instr->op != IRInstr::copy || instr->params[1].kind != IROperand::preg || !instr->params[0].isVreg())
+            return false;
+    }
+    return true;
+}
+
+// Les copies des arguments dans leurs registres (copy ou ldconst), entre l'appel précédent et celui-ci
+bool TailCallElimination::findArgumentCopies(TailSite &site, size_t nbParams)
+{
+    BasicBlock *entry = cfg->get_bbs()[0];
+    site.argCopies.assign(nbParams, nullptr);
+    for (size_t k = site.index; k-- > 0;)
+    {
+        IRInstr *instr = site.bb->instrs[k];
+        if (instr->op == IRInstr::call)
+            break;
+        bool toRegister = (instr->op == IRInstr::copy || instr->op == IRInstr::ldconst) && instr->params[0].kind == IROperand::preg;
+        for (size_t i = 0; i < nbParams && toRegister; i++)
+        {
+            if (site.argCopies[i] == nullptr && instr->params[0].name == entry->instrs[i]->params[1].name)
+                site.argCopies[i] = instr;
+        }
+    }
+    return find(site.argCopies.begin(), site.argCopies.end(), nullptr) == site.argCopies.end();
+}
+
+// Bloc où reprend un tour de la boucle: la suite du bloc d'entrée, après la copie des paramètres
+BasicBlock *TailCallElimination::loopHeader(size_t nbParams)
+{
+    BasicBlock *entry = cfg->get_bbs()[0];
+    BasicBlock *header = new BasicBlock(cfg, cfg->new_BB_name());
+    for (size_t k = nbParams; k < entry->instrs.size(); k++)
+    {
+        entry->instrs[k]->bb = header;
+        header->instrs.push_back(entry->instrs[k]);
+    }
+    entry->instrs.resize(nbParams);
+    header->exit_true = entry->exit_true;
+    header->exit_false = entry->exit_false;
+    header->test_var = entry->test_var;
+    header->test_var_name = entry->test_var_name;
+    entry->exit_true = header;
+    entry->exit_false = nullptr;
+    entry->test_var = IROperand();
+    entry->test_var_name.clear();
+    vector<BasicBlock *> &bbs = cfg->get_bbs();
+    bbs.insert(bbs.begin() + 1, header);
+    return header;
+}
+
+/** Returns true if an accumulator is applied to the result by the epilogue */
+bool TailCallElimination::eliminateRecursion(vector<TailSite> sites)
+{
+    size_t nbParams = cfg->ast->getParameters().size();
+    if (!hasParameterCopies(nbParams))
+    {
+        return false;
+    }
+    sites.erase(remove_if(sites.begin(), sites.end(), [&](TailSite &site) { return !findArgumentCopies(site, nbParams); }), sites.end());
+
+    // Une seule opération d'accumulation: les sites qui en utilisent une autre restent des appels
+    IRInstr::Operation op = IRInstr::add;
+    bool accumulates = false;
+    for (TailSite &site : sites)
+    {
+        if (site.combine != nullptr && !accumulates)
+        {
+            op = site.combine->op;
+            accumulates = true;
+        }
+    }
+    sites.erase(remove_if(sites.begin(), sites.end(), [&](TailSite &site) { return site.combine != nullptr && site.combine->op != op; }),
+                sites.end());
+    if (sites.empty())
+    {
+        return false;
+    }
+
+    BasicBlock *entry = cfg->get_bbs()[0];
+    BasicBlock *header = loopHeader(nbParams);
+    IROperand acc;
+    if (accumulates)
+    {
+        acc = IROperand::makeVreg(cfg->new_vreg(VarType::INT, 1, "acc"), VarType::INT);
+        entry->instrs.push_back(new IRInstr(entry, IRInstr::ldconst, VarType::INT, {acc, IROperand::makeImm(op == IRInstr::mul ? "1" : "0", VarType::INT)}));
+        BasicBlock *epilogue = cfg->epilogue_bb;
+        epilogue->instrs.insert(epilogue->instrs.begin(), new IRInstr(epilogue, op, VarType::INT, {returned, returned, acc}));
+    }
+
+    for (TailSite &site : sites)
+    {
+        // Les arguments sont calculés dans des temporaires, puis copiés ensemble dans les paramètres
+        vector<IROperand> args;
+        for (size_t i = 0; i < nbParams; i++)
+        {
+            IRInstr *param = entry->instrs[i];
+            args.push_back(IROperand::makeVreg(cfg->new_vreg(param->t), param->t));
+            site.argCopies[i]->params[0] = args[i];
+        }
+        BasicBlock *bb = site.bb;
+        for (size_t k = site.index; k < bb->instrs.size(); k++)
+        {
+            delete bb->instrs[k];
+        }
+        bb->instrs.resize(site.index);
+        if (site.combine != nullptr)
+        {
+            bb->instrs.push_back(new IRInstr(bb, op, VarType::INT, {acc, acc, site.other}));
+        }
+        for (size_t i = 0; i < nbParams; i++)
+        {
+            IRInstr *param = entry->instrs[i];
+            bb->instrs.push_back(new IRInstr(bb, IRInstr::copy, param->t, {param->params[0], args[i]}));
+        }
+        bb->exit_true = header;
+    }
+    return accumulates;
+}
+
+void TailCallElimination::run()
+{
+    BasicBlock *epilogue = cfg->epilogue_bb;
+    if (epilogue == nullptr || epilogue->exit_true != nullptr || epilogue->instrs.size() > 1)
+    {
+        return;
+    }
+    if (!epilogue->instrs.empty())
+    {
+        IRInstr *copy = epilogue->instrs[0];
+        if (copy->op != IRInstr::copy || copy->params[0].kind != IROperand::preg)
+            return;
+        returned = copy->params[1];
+    }
+
+    vector<TailSite> recursive;
+    vector<TailSite> siblings;
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        TailSite site;
+        if (!findTailCall(bb, site))
+            continue;
+        bool self = bb->instrs[site.index]->params[0].name == cfg->ast->getName();
+        if (self)
+            recursive.push_back(site);
+        else if (site.combine == nullptr)
+            siblings.push_back(site); // un résultat combiné n'est accumulé que dans une boucle
+    }
+    // L'accumulateur est appliqué par l'épilogue: un saut vers une autre fonction le contournerait
+    if (!recursive.empty() && eliminateRecursion(recursive))
+    {
+        siblings.clear();
+        recursive.clear();
+    }
+    // Un appel récursif qui n'a pas pu devenir un tour de boucle peut toujours être un saut
+    for (TailSite &site : recursive)
+    {
+        if (site.combine == nullptr && site.bb->exit_true == cfg->epilogue_bb)
+            siblings.push_back(site);
+    }
+
+    for (TailSite &site : siblings)
+    {
+        BasicBlock *bb = site.bb;
+        for (size_t k = site.index + 1; k < bb->instrs.size(); k++)
+        {
+            delete bb->instrs[k];
+        }
+        bb->instrs.resize(site.index + 1);
+        bb->instrs.back()->tail_call = true;
+        bb->exit_true = nullptr;
+    }
+    cfg->invalidate_analyses();
+    cfg->remove_unreachable_bbs();
+    cfg->compute_predecessors();
+}
+
+} // namespace
+
+void TailCallPass::runOnFunction(CFG *cfg)
+{
+    if (cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // les paramètres sont réaffectés comme des variables
+    }
+    TailCallElimination(cfg).run();
+}
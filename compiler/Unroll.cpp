@@ -0,0 +1,488 @@
+#include "Passes.h"
+#include "Loops.h"
+#include <map>
+#include <set>
+#include <algorithm>
+using namespace std;
+
+// Déroulage des boucles while (i < N) dont le nombre de tours se calcule: i est une variable d'induction
+// de pas constant c et N un invariant de la boucle.
+// - Nombre de tours constant et petit: la boucle est remplacée par ses tours mis bout à bout.
+// - Sinon: une boucle déroulée fait F tours d'un coup tant que i + (F - 1) * c < N, c'est-à-dire
+//   i < N - (F - 1) * c; la boucle d'origine, laissée en place, fait les tours restants. Quand N n'est
+//   pas constant, un test à l'entrée vérifie que N - (F - 1) * c ne déborde pas.
+// Seules les boucles les plus internes, qui ne sortent que par leur en-tête, sont déroulées.
+
+namespace
+{
+
+const int maxFullUnrollTrips = 16;  /**< a loop making more tours is never fully unrolled */
+const int maxFullUnrollSize = 128;  /**< instructions of a fully unrolled loop */
+const int maxUnrolledBodySize = 160; /**< instructions of the body of a partially unrolled loop */
+
+/** One copy of the blocks of a loop, and the values of the copy of each vreg they define */
+struct Iteration
+{
+    map<BasicBlock *, BasicBlock *> blocks;
+    map<int, IROperand> values;
+    map<int, IROperand> next; /**< value of each header phi at the back edge, for the next iteration */
+};
+
+IRInstr::Operation swapped(IRInstr::Operation op)
+{
+    switch (op)
+    {
+    case IRInstr::cmp_lt:
+        return IRInstr::cmp_gt;
+    case IRInstr::cmp_le:
+        return IRInstr::cmp_ge;
+    case IRInstr::cmp_gt:
+        return IRInstr::cmp_lt;
+    case IRInstr::cmp_ge:
+        return IRInstr::cmp_le;
+    default:
+        return op;
+    }
+}
+
+class LoopUnroller
+{
+public:
+    LoopUnroller(CFG *cfg, Loop *loop, BasicBlock *preheader, int factor);
+    void run();
+
+private:
+    bool analyze(); /**< finds the exit test i op N, false if the trip count can not be computed */
+    long long constantTripCount(); /**< -1 if init or N is not constant */
+    int size();
+
+    Iteration cloneIteration(const map<int, IROperand> &incoming, bool headerOnly);
+    IROperand mapped(const Iteration &it, const IROperand &o);
+    void fullyUnroll(long long trips);
+    void partiallyUnroll();
+
+    CFG *cfg;
+    Loop *loop;
+    BasicBlock *preheader;
+    int factor;
+
+    BasicBlock *body = nullptr; /**< successor of the header in the loop */
+    BasicBlock *exit = nullptr; /**< successor of the header outside the loop */
+    BasicBlock *latch = nullptr;
+    IRInstr *test = nullptr;    /**< i op N, whose result is the test of the header */
+    bool testUsedElsewhere = false;
+    IRInstr::Operation op;      /**< comparison, with i on the left */
+    IROperand bound;            /**< N */
+    InductionVariable iv;
+    set<int> defined;           /**< vregs defined in the loop */
+};
+
+LoopUnroller::LoopUnroller(CFG *cfg, Loop *loop, BasicBlock *preheader, int factor)
+    : cfg(cfg), loop(loop), preheader(preheader), factor(factor)
+{
+}
+
+int LoopUnroller::size()
+{
+    int n = 0;
+    for (BasicBlock *bb : loop->blocks)
+    {
+        n += bb->instrs.size();
+    }
+    return n;
+}
+
+bool LoopUnroller::analyze()
+{
+    BasicBlock *header = loop->header;
+    if (!loop->children.empty() || loop->latches.size() != 1 || loop->exits.size() != 1 || header->exit_false == nullptr)
+    {
+        return false;
+    }
+    latch = loop->latches[0];
+    body = header->exit_true;
+    exit = header->exit_false;
+    if (!loop->contains(body) || loop->contains(exit))
+    {
+        return false;
+    }
+    // Pas d'autre sortie que l'en-tête (un return dans la boucle en est une)
+    for (BasicBlock *bb : loop->blocks)
+    {
+        for (BasicBlock *succ : bb->successors())
+        {
+            if (bb != header && !loop->contains(succ))
+                return false;
+        }
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (d >= 0 && instr->params[d].isVreg())
+                defined.insert(instr->params[d].id);
+        }
+    }
+
+    for (IRInstr *instr : header->instrs)
+    {
+        if (instr->def_index() == 0 && instr->params[0] == header->test_var)
+            test = instr;
+    }
+    if (test == nullptr || test->t != VarType::INT || test->op < IRInstr::cmp_eq || test->op > IRInstr::cmp_ge)
+    {
+        return false;
+    }
+
+    for (InductionVariable &candidate : findInductionVariables(loop, preheader))
+    {
+        const IROperand &i = candidate.phi->params[0];
+        if (test->params[1] != i && test->params[2] != i)
+            continue;
+        op = (test->params[1] == i) ? test->op : swapped(test->op);
+        bound = (test->params[1] == i) ? test->params[2] : test->params[1];
+        iv = candidate;
+        bool invariant = (bound.isImm() && bound.type == VarType::INT) || (bound.isVreg() && !defined.count(bound.id));
+        bool towardsBound = ((op == IRInstr::cmp_lt || op == IRInstr::cmp_le) && iv.stride > 0) ||
+                            ((op == IRInstr::cmp_gt || op == IRInstr::cmp_ge) && iv.stride < 0) ||
+                            (op == IRInstr::cmp_ne && iv.stride != 0);
+        if (!invariant || !towardsBound)
+            return false;
+
+        // Le résultat du test sert-il à autre chose qu'au branchement de l'en-tête ?
+        for (BasicBlock *bb : cfg->get_bbs())
+        {
+            for (IRInstr *instr : bb->instrs)
+            {
+                for (int u : instr->use_indices())
+                    testUsedElsewhere |= instr->params[u] == test->params[0];
+            }
+            testUsedElsewhere |= bb != header && bb->test_var == test->params[0];
+        }
+        return true;
+    }
+    return false;
+}
+
+long long LoopUnroller::constantTripCount()
+{
+    if (!iv.init.isImm() || !bound.isImm())
+    {
+        return -1;
+    }
+    long long init = stoll(iv.init.name), n = stoll(bound.name), c = iv.stride;
+    long long trips;
+    switch (op)
+    {
+    case IRInstr::cmp_lt:
+        trips = (init < n) ? (n - init + c - 1) / c : 0;
+        break;
+    case IRInstr::cmp_le:
+        trips = (init <= n) ? (n - init) / c + 1 : 0;
+        break;
+    case IRInstr::cmp_gt:
+        trips = (init > n) ? (init - n - c - 1) / -c : 0;
+        break;
+    case IRInstr::cmp_ge:
+        trips = (init >= n) ? (init - n) / -c + 1 : 0;
+        break;
+    default: // i != N n'atteint N que par un nombre entier de pas
+        if ((n - init) % c != 0 || (n - init) / c < 0)
+            return -1;
+        trips = (n - init) / c;
+    }
+
+    // La dernière valeur de i doit tenir sur 32 bits, sinon la boucle ne se comporte pas comme on le calcule
+    long long last = init + trips * c;
+    return (last < INT32_MIN || last > INT32_MAX) ? -1 : trips;
+}
+
+IROperand LoopUnroller::mapped(const Iteration &it, const IROperand &o)
+{
+    if (!o.isVreg())
+    {
+        return o;
+    }
+    auto found = it.values.find(o.id);
+    return found == it.values.end() ? o : found->second;
+}
+
+Iteration LoopUnroller::cloneIteration(const map<int, IROperand> &incoming, bool headerOnly)
+{
+    Iteration it;
+    it.values = incoming;
+    vector<BasicBlock *> originals = headerOnly ? vector<BasicBlock *>{loop->header} : loop->blocks;
+
+    // Un vreg neuf pour chaque valeur définie dans la boucle, avant de copier des lectures
+    for (BasicBlock *bb : originals)
+    {
+        it.blocks[bb] = new BasicBlock(cfg, cfg->new_BB_name());
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (d < 0 || !instr->params[d].isVreg() || it.values.count(instr->params[d].id))
+                continue;
+            VirtualRegister &v = cfg->get_vreg(instr->params[d].id);
+            it.values[instr->params[d].id] = IROperand::makeVreg(cfg->new_vreg(v.type, v.size, v.name), instr->params[d].type);
+        }
+    }
+
+    for (BasicBlock *bb : originals)
+    {
+        BasicBlock *copy = it.blocks[bb];
+        for (IRInstr *instr : bb->instrs)
+        {
+            // Les phi de l'en-tête prennent la valeur entrante; le test ne sert qu'au branchement de l'en-tête
+            if (bb == loop->header && (instr->op == IRInstr::phi || (instr == test && !testUsedElsewhere && !headerOnly)))
+                continue;
+            vector<IROperand> params;
+            for (const IROperand &o : instr->params)
+                params.push_back(mapped(it, o));
+            IRInstr *clone = new IRInstr(copy, instr->op, instr->t, params);
+            for (BasicBlock *pred : instr->phi_preds)
+                clone->phi_preds.push_back(it.blocks[pred]);
+            copy->instrs.push_back(clone);
+        }
+
+        auto target = [&](BasicBlock *succ) { return it.blocks.count(succ) ? it.blocks[succ] : succ; };
+        copy->exit_true = bb->exit_true == nullptr ? nullptr : target(bb->exit_true);
+        copy->exit_false = bb->exit_false == nullptr ? nullptr : target(bb->exit_false);
+        copy->test_var = mapped(it, bb->test_var);
+        copy->test_var_name = bb->test_var_name;
+    }
+
+    for (IRInstr *phi : loop->header->instrs)
+    {
+        if (phi->op != IRInstr::phi)
+            break;
+        for (size_t k = 0; k < phi->phi_preds.size(); k++)
+        {
+            if (phi->phi_preds[k] == latch)
+                it.next[phi->params[0].id] = mapped(it, phi->params[k + 1]);
+        }
+    }
+    return it;
+}
+
+// Les tours se suivent: l'en-tête de chaque copie va droit au corps, et une dernière copie de l'en-tête sort
+void LoopUnroller::fullyUnroll(long long trips)
+{
+    BasicBlock *header = loop->header;
+    map<int, IROperand> incoming;
+    for (IRInstr *phi : header->instrs)
+    {
+        if (phi->op != IRInstr::phi)
+            break;
+        for (size_t k = 0; k < phi->phi_preds.size(); k++)
+        {
+            if (phi->phi_preds[k] == preheader)
+                incoming[phi->params[0].id] = phi->params[k + 1];
+        }
+    }
+
+    vector<BasicBlock *> created;
+    BasicBlock *previous = preheader;
+    for (long long t = 0; t <= trips; t++)
+    {
+        bool last = (t == trips);
+        Iteration it = cloneIteration(incoming, last);
+        BasicBlock *copy = it.blocks[header];
+        if (previous == preheader)
+            preheader->exit_true = copy;
+        else
+            previous->exit_true = copy;
+        copy->exit_true = last ? exit : it.blocks[body];
+        copy->exit_false = nullptr;
+        copy->test_var = IROperand();
+        copy->test_var_name.clear();
+        for (BasicBlock *bb : loop->blocks)
+        {
+            if (it.blocks.count(bb))
+                created.push_back(it.blocks[bb]);
+        }
+
+        if (last)
+        {
+            // Après la boucle, les valeurs de l'en-tête sont celles de sa dernière copie
+            for (BasicBlock *bb : cfg->get_bbs())
+            {
+                if (loop->contains(bb))
+                    continue;
+                for (IRInstr *instr : bb->instrs)
+                {
+                    for (IROperand &o : instr->params)
+                        o = mapped(it, o);
+                    for (BasicBlock *&pred : instr->phi_preds)
+                        pred = (pred == header) ? copy : pred;
+                }
+                bb->test_var = mapped(it, bb->test_var);
+            }
+            break;
+        }
+        previous = it.blocks[latch];
+        incoming = it.next;
+    }
+
+    vector<BasicBlock *> &bbs = cfg->get_bbs();
+    bbs.insert(find(bbs.begin(), bbs.end(), header), created.begin(), created.end());
+    cfg->invalidate_analyses();
+    cfg->remove_unreachable_bbs();
+}
+
+// Boucle déroulée de factor tours, puis la boucle d'origine pour les tours restants
+void LoopUnroller::partiallyUnroll()
+{
+    BasicBlock *header = loop->header;
+    IROperand i = iv.phi->params[0];
+    long long distance = (long long)(factor - 1) * iv.stride;
+    vector<BasicBlock *> created;
+
+    // lim = N - (F - 1) * c, vérifié à l'entrée s'il n'est pas constant
+    BasicBlock *entry = preheader;
+    IROperand limit;
+    if (bound.isImm())
+    {
+        long long lim = stoll(bound.name) - distance;
+        if (lim < INT32_MIN || lim > INT32_MAX)
+            return;
+        limit = IROperand::makeImm(to_string(lim), VarType::INT);
+    }
+    else
+    {
+        entry = new BasicBlock(cfg, cfg->new_BB_name());
+        created.push_back(entry);
+        limit = IROperand::makeVreg(cfg->new_vreg(VarType::INT, 1, "lim"), VarType::INT);
+        IROperand fits = IROperand::makeVreg(cfg->new_vreg(VarType::INT, 1, "lim.ok"), VarType::INT);
+        entry->instrs.push_back(new IRInstr(entry, IRInstr::sub, VarType::INT, {limit, bound, IROperand::makeImm(to_string(distance), VarType::INT)}));
+        entry->instrs.push_back(new IRInstr(entry, iv.stride > 0 ? IRInstr::cmp_lt : IRInstr::cmp_gt, VarType::INT, {fits, limit, bound}));
+        entry->test_var = fits;
+        entry->test_var_name = cfg->get_vreg(fits.id).name;
+        entry->exit_false = header;
+        preheader->exit_true = entry;
+    }
+
+    // En-tête de la boucle déroulée: ses phi reçoivent les valeurs d'entrée, puis celles de la dernière copie
+    BasicBlock *unrolled = new BasicBlock(cfg, cfg->new_BB_name());
+    created.push_back(unrolled);
+    entry->exit_true = unrolled;
+    map<int, IROperand> incoming;
+    vector<IRInstr *> phis;
+    for (IRInstr *phi : header->instrs)
+    {
+        if (phi->op != IRInstr::phi)
+            break;
+        IROperand start;
+        for (size_t k = 0; k < phi->phi_preds.size(); k++)
+        {
+            if (phi->phi_preds[k] == preheader)
+                start = phi->params[k + 1];
+        }
+        VirtualRegister &v = cfg->get_vreg(phi->params[0].id);
+        IROperand value = IROperand::makeVreg(cfg->new_vreg(v.type, v.size, v.name), phi->params[0].type);
+        IRInstr *merge = new IRInstr(unrolled, IRInstr::phi, phi->t, {value, start});
+        merge->phi_preds = {entry};
+        unrolled->instrs.push_back(merge);
+        phis.push_back(merge);
+        incoming[phi->params[0].id] = value;
+
+        // La boucle d'origine reprend où la boucle déroulée s'arrête, ou au début si lim déborde
+        for (size_t k = 0; k < phi->phi_preds.size(); k++)
+        {
+            if (phi->phi_preds[k] != preheader)
+                continue;
+            phi->phi_preds[k] = unrolled;
+            phi->params[k + 1] = value;
+            if (entry != preheader)
+            {
+                phi->phi_preds.push_back(entry);
+                phi->params.push_back(start);
+            }
+            break;
+        }
+    }
+    IROperand go = IROperand::makeVreg(cfg->new_vreg(VarType::INT, 1, "unroll.test"), VarType::INT);
+    unrolled->instrs.push_back(new IRInstr(unrolled, op, VarType::INT, {go, incoming[i.id], limit}));
+    unrolled->test_var = go;
+    unrolled->test_var_name = cfg->get_vreg(go.id).name;
+    unrolled->exit_false = header;
+
+    BasicBlock *previous = unrolled;
+    for (int k = 0; k < factor; k++)
+    {
+        Iteration it = cloneIteration(incoming, false);
+        BasicBlock *copy = it.blocks[header];
+        copy->exit_true = it.blocks[body];
+        copy->exit_false = nullptr;
+        copy->test_var = IROperand();
+        copy->test_var_name.clear();
+        if (previous == unrolled)
+            unrolled->exit_true = copy;
+        else
+            previous->exit_true = copy;
+        for (BasicBlock *bb : loop->blocks)
+            created.push_back(it.blocks[bb]);
+        previous = it.blocks[latch];
+        incoming = it.next;
+    }
+    previous->exit_true = unrolled;
+    for (size_t k = 0; k < phis.size(); k++)
+    {
+        phis[k]->params.push_back(incoming[header->instrs[k]->params[0].id]);
+        phis[k]->phi_preds.push_back(previous);
+    }
+
+    vector<BasicBlock *> &bbs = cfg->get_bbs();
+    bbs.insert(find(bbs.begin(), bbs.end(), header), created.begin(), created.end());
+    cfg->invalidate_analyses();
+}
+
+void LoopUnroller::run()
+{
+    if (!analyze())
+    {
+        return;
+    }
+    long long trips = constantTripCount();
+    if (trips < 0 && !(bound.isVreg() || bound.isImm()))
+    {
+        return;
+    }
+    if (op == IRInstr::cmp_ne && trips < 0)
+    {
+        return; // i != N peut ne jamais s'arrêter: on ne sait pas borner les tours
+    }
+
+    int bodySize = size();
+    if (trips >= 0 && trips <= maxFullUnrollTrips && trips * bodySize <= maxFullUnrollSize)
+    {
+        fullyUnroll(trips);
+        return;
+    }
+    factor = min(factor, maxUnrolledBodySize / max(bodySize, 1));
+    if (factor < 2 || (trips >= 0 && trips < factor) || op == IRInstr::cmp_ne)
+    {
+        return;
+    }
+    partiallyUnroll();
+}
+
+} // namespace
+
+void LoopUnrollPass::runOnFunction(CFG *cfg)
+{
+    if (!cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // le nombre de tours se lit sur les phi de l'en-tête
+    }
+
+    vector<BasicBlock *> headers;
+    for (Loop *loop : cfg->get_loops()->loops())
+    {
+        if (loop->children.empty())
+            headers.push_back(loop->header);
+    }
+    for (BasicBlock *header : headers)
+    {
+        BasicBlock *preheader = cfg->ensure_preheader(header);
+        LoopUnroller(cfg, cfg->get_loops()->loopFor(header), preheader, factor).run();
+        cfg->compute_predecessors();
+    }
+}
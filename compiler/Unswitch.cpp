@@ -0,0 +1,255 @@
+#include "Passes.h"
+#include "Loops.h"
+#include <map>
+#include <set>
+#include <algorithm>
+using namespace std;
+
+// Désaiguillage des boucles (unswitching): un if du corps dont la condition est invariante (paramètre,
+// globale chargée dans le preheader par LICM...) est sorti de la boucle. La boucle est dupliquée, le
+// preheader teste la condition une fois et choisit la copie: dans l'originale le if va toujours vers
+// sa branche vraie, dans la copie vers sa branche fausse.
+// La duplication est limitée par la taille de la boucle et par un budget par fonction.
+
+namespace
+{
+
+const int maxUnswitchedLoopSize = 64; /**< instructions of a loop that can be duplicated */
+const int maxFunctionGrowth = 256;    /**< instructions added to a function by unswitching */
+
+class LoopUnswitching
+{
+public:
+    LoopUnswitching(CFG *cfg, Loop *loop, BasicBlock *preheader) : cfg(cfg), loop(loop), preheader(preheader) {}
+    int run(int budget); /**< returns the number of instructions added */
+
+private:
+    BasicBlock *findInvariantBranch();
+    void cloneLoop();
+    void mergeExitValues();
+    void foldBranch(BasicBlock *bb, bool taken);
+
+    CFG *cfg;
+    Loop *loop;
+    BasicBlock *preheader;
+    BasicBlock *exit = nullptr;
+    set<int> defined;                         /**< vregs defined in the loop */
+    map<BasicBlock *, BasicBlock *> blocks;   /**< block of the loop -> its copy */
+    map<int, IROperand> values;               /**< vreg defined in the loop -> its copy */
+};
+
+BasicBlock *LoopUnswitching::findInvariantBranch()
+{
+    for (BasicBlock *bb : loop->blocks)
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (d >= 0 && instr->params[d].isVreg())
+                defined.insert(instr->params[d].id);
+        }
+    }
+    // Le test de l'en-tête est celui de la boucle elle-même
+    for (BasicBlock *bb : loop->blocks)
+    {
+        if (bb != loop->header && bb->exit_false != nullptr && bb->exit_true != bb->exit_false &&
+            bb->test_var.isVreg() && !defined.count(bb->test_var.id))
+            return bb;
+    }
+    return nullptr;
+}
+
+void LoopUnswitching::cloneLoop()
+{
+    for (BasicBlock *bb : loop->blocks)
+    {
+        blocks[bb] = new BasicBlock(cfg, cfg->new_BB_name());
+    }
+    for (int id : defined)
+    {
+        VirtualRegister &v = cfg->get_vreg(id);
+        values[id] = IROperand::makeVreg(cfg->new_vreg(v.type, v.size, v.name), v.type);
+    }
+    auto mapped = [&](const IROperand &o) { return o.isVreg() && values.count(o.id) ? values[o.id] : o; };
+    auto target = [&](BasicBlock *bb) { return bb != nullptr && blocks.count(bb) ? blocks[bb] : bb; };
+
+    for (BasicBlock *bb : loop->blocks)
+    {
+        BasicBlock *copy = blocks[bb];
+        for (IRInstr *instr : bb->instrs)
+        {
+            vector<IROperand> params;
+            for (const IROperand &o : instr->params)
+                params.push_back(mapped(o));
+            IRInstr *clone = new IRInstr(copy, instr->op, instr->t, params);
+            for (BasicBlock *pred : instr->phi_preds)
+                clone->phi_preds.push_back(target(pred));
+            copy->instrs.push_back(clone);
+        }
+        copy->exit_true = target(bb->exit_true);
+        copy->exit_false = target(bb->exit_false);
+        copy->test_var = mapped(bb->test_var);
+        copy->test_var_name = bb->test_var_name;
+    }
+
+    // La copie se place après le dernier bloc de la boucle
+    vector<BasicBlock *> &bbs = cfg->get_bbs();
+    auto last = bbs.begin();
+    for (auto it = bbs.begin(); it != bbs.end(); ++it)
+    {
+        if (loop->contains(*it))
+            last = it;
+    }
+    vector<BasicBlock *> copies;
+    for (BasicBlock *bb : loop->blocks)
+        copies.push_back(blocks[bb]);
+    bbs.insert(last + 1, copies.begin(), copies.end());
+}
+
+// La sortie est atteinte par les deux copies: ses phi et les valeurs de la boucle lues après elle fusionnent les deux versions
+void LoopUnswitching::mergeExitValues()
+{
+    vector<BasicBlock *> preds = exit->preds;
+    for (IRInstr *instr : exit->instrs)
+    {
+        if (instr->op != IRInstr::phi)
+            break;
+        size_t n = instr->phi_preds.size();
+        for (size_t k = 0; k < n; k++)
+        {
+            IROperand o = instr->params[k + 1];
+            instr->phi_preds.push_back(blocks[instr->phi_preds[k]]);
+            instr->params.push_back(o.isVreg() && values.count(o.id) ? values[o.id] : o);
+        }
+    }
+
+    map<int, IROperand> merged;
+    vector<IRInstr *> phis;
+    auto rename = [&](IROperand &o) {
+        if (!o.isVreg() || !defined.count(o.id))
+            return;
+        if (!merged.count(o.id))
+        {
+            VirtualRegister &v = cfg->get_vreg(o.id);
+            IROperand out = IROperand::makeVreg(cfg->new_vreg(v.type, v.size, v.name), o.type);
+            IRInstr *phi = new IRInstr(exit, IRInstr::phi, o.type, {out});
+            for (BasicBlock *pred : preds)
+            {
+                phi->params.push_back(o);
+                phi->phi_preds.push_back(pred);
+                phi->params.push_back(values[o.id]);
+                phi->phi_preds.push_back(blocks[pred]);
+            }
+            phis.push_back(phi);
+            merged[o.id] = out;
+        }
+        o = merged[o.id];
+    };
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        if (loop->contains(bb) || blocks.count(bb) || bb == preheader)
+            continue;
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (bb == exit && instr->op == IRInstr::phi)
+                continue;
+            for (int u : instr->use_indices())
+                rename(instr->params[u]);
+        }
+        rename(bb->test_var);
+    }
+    exit->instrs.insert(exit->instrs.begin(), phis.begin(), phis.end());
+}
+
+void LoopUnswitching::foldBranch(BasicBlock *bb, bool taken)
+{
+    BasicBlock *target = taken ? bb->exit_true : bb->exit_false;
+    BasicBlock *dropped = taken ? bb->exit_false : bb->exit_true;
+    for (IRInstr *instr : dropped->instrs)
+    {
+        if (instr->op != IRInstr::phi)
+            break;
+        for (size_t i = instr->phi_preds.size(); i-- > 0;)
+        {
+            if (instr->phi_preds[i] == bb)
+            {
+                instr->phi_preds.erase(instr->phi_preds.begin() + i);
+                instr->params.erase(instr->params.begin() + i + 1);
+            }
+        }
+    }
+    bb->exit_true = target;
+    bb->exit_false = nullptr;
+    bb->test_var = IROperand();
+}
+
+int LoopUnswitching::run(int budget)
+{
+    if (loop->exits.size() != 1 || loop->preheader() != preheader)
+    {
+        return 0;
+    }
+    exit = loop->exits[0];
+    for (BasicBlock *pred : exit->preds)
+    {
+        if (!loop->contains(pred))
+            return 0; // les valeurs de la boucle ne seraient pas définies sur cet arc
+    }
+    int size = 0;
+    for (BasicBlock *bb : loop->blocks)
+    {
+        size += bb->instrs.size();
+    }
+    BasicBlock *branch = findInvariantBranch();
+    if (branch == nullptr || size > maxUnswitchedLoopSize || size > budget)
+    {
+        return 0;
+    }
+
+    cloneLoop();
+    mergeExitValues();
+    preheader->test_var = branch->test_var;
+    preheader->test_var_name = branch->test_var_name;
+    preheader->exit_true = loop->header;
+    preheader->exit_false = blocks[loop->header];
+    foldBranch(branch, true);
+    foldBranch(blocks[branch], false);
+
+    cfg->invalidate_analyses();
+    cfg->remove_unreachable_bbs();
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            if (instr->op == IRInstr::phi && instr->phi_preds.size() == 1)
+            {
+                instr->op = IRInstr::copy;
+                instr->phi_preds.clear();
+            }
+        }
+    }
+    cfg->compute_predecessors();
+    return size;
+}
+
+} // namespace
+
+void LoopUnswitchingPass::runOnFunction(CFG *cfg)
+{
+    if (!cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // les deux copies de la boucle fusionnent leurs valeurs par des phi
+    }
+
+    vector<BasicBlock *> headers;
+    for (Loop *loop : cfg->get_loops()->loops())
+    {
+        headers.push_back(loop->header);
+    }
+    int budget = maxFunctionGrowth;
+    for (BasicBlock *header : headers)
+    {
+        BasicBlock *preheader = cfg->ensure_preheader(header);
+        budget -= LoopUnswitching(cfg, cfg->get_loops()->loopFor(header), preheader).run(budget);
+    }
+}
@@ -0,0 +1,333 @@
+#include "Passes.h"
+#include "Dominators.h"
+#include <unordered_map>
+#include <algorithm>
+using namespace std;
+
+// Numérotation des valeurs: deux instructions qui calculent la même opération (op, type t) sur les mêmes
+// numéros de valeur donnent la même valeur, et la seconde reprend le résultat de la première.
+// Les opérandes d'une opération commutative sont rangés, et a > b se lit b < a.
+// Une lecture de tableau (getTblx) porte aussi la version du tableau, changée par chaque écriture et à
+// l'entrée de chaque bloc: une écriture sur un autre chemin peut avoir eu lieu entre deux blocs.
+
+namespace
+{
+
+bool isNumbered(IRInstr::Operation op)
+{
+    switch (op)
+    {
+    case IRInstr::add:
+    case IRInstr::sub:
+    case IRInstr::mul:
+    case IRInstr::div:
+    case IRInstr::mod:
+    case IRInstr::cmp_eq:
+    case IRInstr::cmp_ne:
+    case IRInstr::cmp_lt:
+    case IRInstr::cmp_le:
+    case IRInstr::cmp_gt:
+    case IRInstr::cmp_ge:
+    case IRInstr::bit_and:
+    case IRInstr::bit_or:
+    case IRInstr::bit_xor:
+    case IRInstr::unary_minus:
+    case IRInstr::not_op:
+    case IRInstr::log_and:
+    case IRInstr::log_or:
+    case IRInstr::intToFloat:
+    case IRInstr::floatToInt:
+    case IRInstr::getTblx:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool isCommutative(IRInstr::Operation op)
+{
+    switch (op)
+    {
+    case IRInstr::add:
+    case IRInstr::mul:
+    case IRInstr::cmp_eq:
+    case IRInstr::cmp_ne:
+    case IRInstr::bit_and:
+    case IRInstr::bit_or:
+    case IRInstr::bit_xor:
+    case IRInstr::log_and:
+    case IRInstr::log_or:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/** The value numbers of a function: which value each vreg holds, and which vreg holds each expression.
+ *  The expressions are scoped, so that a walk of the dominator tree forgets those of a subtree when it leaves it. */
+class ValueTable
+{
+public:
+    int numberOf(const IROperand &o); /**< value number of an operand, -1 if it can change behind our back */
+    string key(IRInstr *instr);       /**< (op, t, value numbers of the operands), empty if not numbered */
+    void define(int vreg, int number) { numbers[vreg] = number; }
+    int fresh() { return next++; }
+    void arrayWritten(int vreg) { arrayVersions[vreg]++; }
+
+    /** the vreg still holding the value of key, -1 if none */
+    int holder(const string &key);
+    void record(const string &key, int number, int vreg);
+
+    void enterBlock() { epoch++; } /**< the arrays may have been written on another path */
+    size_t scope() { return undo.size(); }
+    void leaveScope(size_t scope); /**< forgets the expressions recorded since scope() returned this value */
+
+private:
+    int next = 0;
+    int epoch = 0;
+    unordered_map<int, int> numbers;
+    unordered_map<string, int> constants;
+    unordered_map<int, int> arrayVersions;
+    unordered_map<string, pair<int, int>> exprs; /**< value number and holder of each expression */
+    vector<pair<string, pair<int, int>>> undo;   /**< previous entry of each recorded key, holder -1 if none */
+};
+
+int ValueTable::numberOf(const IROperand &o)
+{
+    if (o.isVreg())
+    {
+        auto it = numbers.find(o.id);
+        if (it != numbers.end())
+            return it->second;
+        return numbers[o.id] = fresh();
+    }
+    // Les données en lecture seule (masque du moins flottant...) ne changent pas, les globales si
+    bool constant = o.isImm() || (o.kind == IROperand::global && o.name[0] == '.');
+    if (!constant)
+        return -1;
+    string k = o.toString() + ":" + to_string(o.type);
+    auto it = constants.find(k);
+    if (it != constants.end())
+        return it->second;
+    return constants[k] = fresh();
+}
+
+string ValueTable::key(IRInstr *instr)
+{
+    if (!isNumbered(instr->op))
+        return "";
+
+    IRInstr::Operation op = instr->op;
+    int array = instr->array_param_index();
+    vector<string> operands;
+    for (size_t i = 1; i < instr->params.size(); i++)
+    {
+        const IROperand &o = instr->params[i];
+        if (o.isNone())
+            continue;
+        if ((int)i == array)
+        {
+            operands.push_back("a" + to_string(o.id) + "." + to_string(epoch) + "." + to_string(arrayVersions[o.id]));
+            continue;
+        }
+        int n = numberOf(o);
+        if (n < 0)
+            return "";
+        operands.push_back(to_string(n));
+    }
+
+    if (op == IRInstr::cmp_gt || op == IRInstr::cmp_ge)
+    {
+        op = (op == IRInstr::cmp_gt) ? IRInstr::cmp_lt : IRInstr::cmp_le;
+        swap(operands[0], operands[1]);
+    }
+    if (isCommutative(op) && operands[1] < operands[0])
+    {
+        swap(operands[0], operands[1]);
+    }
+
+    string k = to_string(op) + ":" + to_string(instr->t);
+    for (string &operand : operands)
+        k += " " + operand;
+    return k;
+}
+
+int ValueTable::holder(const string &key)
+{
+    auto it = exprs.find(key);
+    if (it == exprs.end())
+        return -1;
+    int vreg = it->second.second;
+    // Hors SSA le porteur a pu être redéfini depuis
+    auto held = numbers.find(vreg);
+    return (held != numbers.end() && held->second == it->second.first) ? vreg : -1;
+}
+
+void ValueTable::record(const string &key, int number, int vreg)
+{
+    auto it = exprs.find(key);
+    undo.push_back({key, it == exprs.end() ? make_pair(-1, -1) : it->second});
+    exprs[key] = {number, vreg};
+}
+
+void ValueTable::leaveScope(size_t scope)
+{
+    while (undo.size() > scope)
+    {
+        auto &last = undo.back();
+        if (last.second.second < 0)
+            exprs.erase(last.first);
+        else
+            exprs[last.first] = last.second;
+        undo.pop_back();
+    }
+}
+
+/** Replaces the redundant computations of a function, block by block */
+class ValueNumbering
+{
+public:
+    ValueNumbering(CFG *cfg);
+    void numberBlock(BasicBlock *bb, ValueTable &table);
+    void renameReplaced(); /**< renames the uses of the deleted computations in the whole function */
+
+private:
+    CFG *cfg;
+    vector<int> defs;                 /**< number of definitions of each vreg */
+    unordered_map<int, int> replaced; /**< deleted vreg -> vreg holding the same value */
+};
+
+ValueNumbering::ValueNumbering(CFG *cfg) : cfg(cfg), defs(cfg->get_vreg_count(), 0)
+{
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            int d = instr->def_index();
+            if (d >= 0 && instr->params[d].isVreg())
+                defs[instr->params[d].id]++;
+        }
+    }
+}
+
+void ValueNumbering::numberBlock(BasicBlock *bb, ValueTable &table)
+{
+    table.enterBlock();
+    vector<IRInstr *> kept;
+    for (IRInstr *instr : bb->instrs)
+    {
+        int d = instr->def_index();
+        bool definesVreg = d >= 0 && instr->params[d].isVreg();
+        string k = definesVreg ? table.key(instr) : "";
+        if (k.empty())
+        {
+            if (definesVreg)
+            {
+                // Une copie transmet le numéro de sa source
+                int n = (instr->op == IRInstr::copy) ? table.numberOf(instr->params[1]) : -1;
+                table.define(instr->params[d].id, n >= 0 ? n : table.fresh());
+            }
+            int array = instr->array_param_index();
+            if (array >= 0 && instr->def_index() < 0)
+            {
+                table.arrayWritten(instr->params[array].id);
+            }
+            kept.push_back(instr);
+            continue;
+        }
+
+        int dest = instr->params[d].id;
+        int previous = table.holder(k);
+        if (previous < 0)
+        {
+            int n = table.fresh();
+            table.define(dest, n);
+            table.record(k, n, dest);
+            kept.push_back(instr);
+            continue;
+        }
+
+        // En SSA, une valeur recalculée est remplacée partout par celle qui la précède: la définition de
+        // celle-ci domine toutes les lectures de la première. Sinon on garde une copie.
+        IROperand source = IROperand::makeVreg(previous, cfg->get_vreg(previous).type);
+        table.define(dest, table.numberOf(source));
+        if (cfg->in_ssa && defs[dest] == 1 && defs[previous] == 1)
+        {
+            replaced[dest] = previous;
+            delete instr;
+            continue;
+        }
+        instr->op = IRInstr::copy;
+        instr->params = {instr->params[d], source};
+        kept.push_back(instr);
+    }
+    bb->instrs = kept;
+}
+
+void ValueNumbering::renameReplaced()
+{
+    if (replaced.empty())
+    {
+        return;
+    }
+    auto rename = [&](IROperand &o) {
+        if (o.isVreg() && replaced.count(o.id))
+            o = IROperand::makeVreg(replaced[o.id], cfg->get_vreg(replaced[o.id]).type);
+    };
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        for (IRInstr *instr : bb->instrs)
+        {
+            for (IROperand &o : instr->params)
+                rename(o);
+        }
+        rename(bb->test_var);
+    }
+}
+
+} // namespace
+
+void LocalValueNumberingPass::runOnFunction(CFG *cfg)
+{
+    ValueNumbering numbering(cfg);
+    for (BasicBlock *bb : cfg->get_bbs())
+    {
+        ValueTable table;
+        numbering.numberBlock(bb, table);
+    }
+    numbering.renameReplaced();
+}
+
+void GlobalValueNumberingPass::runOnFunction(CFG *cfg)
+{
+    if (!cfg->in_ssa || cfg->get_bbs().empty())
+    {
+        return; // hors SSA, une valeur d'un bloc dominant peut avoir été écrasée depuis
+    }
+
+    // Parcours en profondeur de l'arbre des dominateurs: un bloc voit les expressions de ses dominateurs
+    DominatorTree *dom = cfg->get_dominators();
+    ValueNumbering numbering(cfg);
+    ValueTable table;
+    BasicBlock *entry = dom->rpo()[0];
+    vector<pair<BasicBlock *, size_t>> stack = {{entry, 0}};
+    vector<size_t> scopes = {table.scope()};
+    numbering.numberBlock(entry, table);
+    while (!stack.empty())
+    {
+        BasicBlock *bb = stack.back().first;
+        const vector<BasicBlock *> &kids = dom->children(bb);
+        if (stack.back().second < kids.size())
+        {
+            BasicBlock *kid = kids[stack.back().second++];
+            scopes.push_back(table.scope());
+            numbering.numberBlock(kid, table);
+            stack.push_back({kid, 0});
+            continue;
+        }
+        table.leaveScope(scopes.back());
+        scopes.pop_back();
+        stack.pop_back();
+    }
+    numbering.renameReplaced();
+}
@@ -4,6 +4,7 @@
 #include <algorithm> // Required for std::all_of
 #include "IR.h"
 #include "CodeGenVisitor.h"
+#include "FeedbackStyleOutput.h"
 
 using namespace std;
 
@@ -20,6 +21,11 @@ vector<string> floatRegs = {"s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7"};
 string returnReg = "w0"; // Register used for return value
 string floatReturnReg = "s0"; // Register used for return value (float)
 
+// The register allocator (RegisterAllocator.cpp) only targets x86-64 for now: every value stays in its stack slot
+vector<string> allocatableCalleeSaved = {};
+vector<string> allocatableCallerSaved = {};
+vector<string> allocatableFloatRegs = {};
+
 bool is_cst(const std::string& s) {
     return !s.empty() && s[0] == '#';
 }
@@ -135,18 +141,43 @@ void fmove(std::ostream &o, const std::string& src, const std::string& dest) {
     }
 }
 
+// Condition de b.cond d'une comparaison entière, et sa négation
+string conditionCode(IRInstr::Operation op)
+{
+    switch (op)
+    {
+    case IRInstr::cmp_eq: return "eq";
+    case IRInstr::cmp_ne: return "ne";
+    case IRInstr::cmp_lt: return "lt";
+    case IRInstr::cmp_le: return "le";
+    case IRInstr::cmp_gt: return "gt";
+    default: return "ge";
+    }
+}
+
+string negated(string cond)
+{
+    if (cond == "eq") return "ne";
+    if (cond == "ne") return "eq";
+    if (cond == "lt") return "ge";
+    if (cond == "ge") return "lt";
+    if (cond == "le") return "gt";
+    return "le";
+}
+
 void IRInstr::gen_asm(std::ostream &o)
 {
     static int labelCounter = 0;
+    std::vector<std::string> asmParams = lower_params();
 
-    for (int i = 0; i < params.size(); i++) {
-        if (is_memory_big_offset(params[i])) {
+    for (int i = 0; i < asmParams.size(); i++) {
+        if (is_memory_big_offset(asmParams[i])) {
             // cout << "; Memory address with big offset: " << params[i] << "-> [x" << i + 2 << "]" << endl;
-            std::string offset = get_memory_offset(params[i]);
-            std::string reg = get_memory_register(params[i]);
+            std::string offset = get_memory_offset(asmParams[i]);
+            std::string reg = get_memory_register(asmParams[i]);
 
             o << "    sub x" << i + 6 << ", " << reg << ", #" << offset << "\n"; // Calculate the address
-            params[i] = std::string("[x") + std::to_string(i + 6) + "]"; // Update the parameter to use the calculated address
+            asmParams[i] = std::string("[x") + std::to_string(i + 6) + "]"; // Update the parameter to use the calculated address
         }
     }
 
@@ -154,107 +185,123 @@ void IRInstr::gen_asm(std::ostream &o)
     {
     case ldconst:
         // ldconst: params[0] = destination, params[1] = immediate constant (#val)
-        move(o, params[1], "w9"); // Move immediate constant to destination
-        move(o, "w9", params[0]); // Move w0 to destination
+        move(o, asmParams[1], "w9"); // Move immediate constant to destination
+        move(o, "w9", asmParams[0]); // Move w0 to destination
         break;
     case copy:
         // copy: params[0] = destination (memory), params[1] = source (memory or immediate)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, "s0", params[0]);
+            fmove(o, asmParams[1], "s0");
+            fmove(o, "s0", asmParams[0]);
+            break;
+        }
+
+        if (t == VarType::ADDRESS) {
+            // Une adresse (StrengthReduction.cpp) occupe 64 bits et reste toujours en mémoire
+            o << "    ldr x9, " << asmParams[1] << "\n";
+            o << "    str x9, " << asmParams[0] << "\n";
             break;
         }
 
-        move(o, params[1], "w9"); // Move source to w0
-        move(o, "w9", params[0]); // Move w0 to destination
+        move(o, asmParams[1], "w9"); // Move source to w0
+        move(o, "w9", asmParams[0]); // Move w0 to destination
         break;
     case add:
         // add: params[0] = dest (mem), params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fadd s0, s0, s1\n";
-            fmove(o, "s0", params[0]); // Move s0 to destination
+            fmove(o, "s0", asmParams[0]); // Move s0 to destination
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        if (t == VarType::ADDRESS) {
+            // Pas d'un pointeur: params[2] est un immédiat
+            int step = stoi(params[2].name);
+            o << "    ldr x0, " << asmParams[1] << "\n";
+            o << "    " << (step < 0 ? "sub" : "add") << " x0, x0, #" << abs(step) << "\n";
+            o << "    str x0, " << asmParams[0] << "\n";
+            break;
+        }
+
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    add w0, w0, w1\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
     case sub:
         // sub: params[0] = dest (mem), params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fsub s0, s0, s1\n";
-            fmove(o, "s0", params[0]); // Move s0 to destination
+            fmove(o, "s0", asmParams[0]); // Move s0 to destination
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    sub w0, w0, w1\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
     case mul:
         // mul: params[0] = dest (mem), params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fmul s0, s0, s1\n";
-            fmove(o, "s0", params[0]); // Move s0 to destination
+            fmove(o, "s0", asmParams[0]); // Move s0 to destination
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    mul w0, w0, w1\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
     case div:
         // div: params[0] = dest (mem), params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fdiv s0, s0, s1\n";
-            fmove(o, "s0", params[0]); // Move s0 to destination
+            fmove(o, "s0", asmParams[0]); // Move s0 to destination
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    sdiv w0, w0, w1\n"; // Signed division
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
     case mod:
         // mod: params[0] = dest (mem), params[1] = left (mem/imm), params[2] = right (mem/imm)
 
-        move(o, params[1], "w0"); // dividend
-        move(o, params[2], "w1"); // divisor
+        move(o, asmParams[1], "w0"); // dividend
+        move(o, asmParams[2], "w1"); // divisor
         o << "    sdiv w2, w0, w1\n";   // quotient in w2
         o << "    msub w0, w2, w1, w0\n"; // remainder = dividend - (quotient * divisor)
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case copyTblx: {
         // copyTblx: params[0] = base_offset (string literal number), params[1] = value (mem/imm), params[2] = index (mem/imm)
         // Address = fp - base_offset + index * 4
         if (t == VarType::FLOAT_PTR) {
-            move(o, params[2], "w5");      // Load index into w5
-            fmove(o, params[1], "s0");      // Load value to store into s0
+            move(o, asmParams[2], "w5");      // Load index into w5
+            fmove(o, asmParams[1], "s0");      // Load value to store into s0
             o << "    lsl w2, w5, #2\n";         // w2 = index * 4
-            o << "    sub x3, fp, #" << params[0] << "\n"; // w3 = fp - base_offset
+            o << "    sub x3, fp, #" << asmParams[0] << "\n"; // w3 = fp - base_offset
             o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
             fmove(o, "s0", "[x2]");           // Move s0 to a temporary register
             break;
         }
 
-        move(o, params[2], "w1");      // Load index into w1
-        move(o, params[1], "w0");      // Load value to store into w0
+        move(o, asmParams[2], "w1");      // Load index into w1
+        move(o, asmParams[1], "w0");      // Load value to store into w0
         o << "    lsl w2, w1, #2\n";         // w2 = index * 4
-        o << "    sub x3, fp, #" << params[0] << "\n"; // w3 = fp - base_offset
+        o << "    sub x3, fp, #" << asmParams[0] << "\n"; // w3 = fp - base_offset
         o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
         o << "    str w0, [x2]\n";           // Store value at the calculated address
         break;
@@ -263,10 +310,10 @@ void IRInstr::gen_asm(std::ostream &o)
         // addTblx: params[0]=base_offset, params[1]=value_to_add (mem/imm), params[2]=index (mem/imm)
         // Address = fp - base_offset + index * 4
         if (t == VarType::FLOAT_PTR) {
-            move(o, params[2], "w5");      // index
-            fmove(o, params[1], "s0");      // value_to_add
+            move(o, asmParams[2], "w5");      // index
+            fmove(o, asmParams[1], "s0");      // value_to_add
             o << "    lsl w2, w5, #2\n";         // offset = index * 4
-            o << "    sub x3, fp, #" << params[0] << "\n"; // base addr = fp - base_offset
+            o << "    sub x3, fp, #" << asmParams[0] << "\n"; // base addr = fp - base_offset
             o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
             o << "    ldr s1, [x2]\n";           // Load current array value into s1
             o << "    fadd s1, s1, s0\n";         // Add the value
@@ -274,10 +321,10 @@ void IRInstr::gen_asm(std::ostream &o)
             break;
         }
 
-        move(o, params[2], "w1");      // index
-        move(o, params[1], "w0");      // value_to_add
+        move(o, asmParams[2], "w1");      // index
+        move(o, asmParams[1], "w0");      // value_to_add
         o << "    lsl w2, w1, #2\n";         // offset = index * 4
-        o << "    sub x3, fp, #" << params[0] << "\n"; // base addr = fp - base_offset
+        o << "    sub x3, fp, #" << asmParams[0] << "\n"; // base addr = fp - base_offset
         o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
         o << "    ldr w3, [x2]\n";           // Load current array value into w3
         o << "    add w3, w3, w0\n";         // Add the value
@@ -288,10 +335,10 @@ void IRInstr::gen_asm(std::ostream &o)
         // subTblx: params[0]=base_offset, params[1]=value_to_sub (mem/imm), params[2]=index (mem/imm)
         // Address = fp - base_offset + index * 4
         if (t == VarType::FLOAT_PTR) {
-            move(o, params[2], "w5");      // index
-            fmove(o, params[1], "s0");      // value_to_sub
+            move(o, asmParams[2], "w5");      // index
+            fmove(o, asmParams[1], "s0");      // value_to_sub
             o << "    lsl w2, w5, #2\n";         // offset = index * 4
-            o << "    sub x3, fp, #" << params[0] << "\n"; // base addr = fp - base_offset
+            o << "    sub x3, fp, #" << asmParams[0] << "\n"; // base addr = fp - base_offset
             o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
             o << "    ldr s1, [x2]\n";           // Load current array value into s1
             o << "    fsub s1, s1, s0\n";         // Subtract the value
@@ -299,10 +346,10 @@ void IRInstr::gen_asm(std::ostream &o)
             break;
         }
 
-        move(o, params[2], "w1");      // index
-        move(o, params[1], "w0");      // value_to_sub
+        move(o, asmParams[2], "w1");      // index
+        move(o, asmParams[1], "w0");      // value_to_sub
         o << "    lsl w2, w1, #2\n";         // offset = index * 4
-        o << "    sub x3, fp, #" << params[0] << "\n"; // base addr = fp - base_offset
+        o << "    sub x3, fp, #" << asmParams[0] << "\n"; // base addr = fp - base_offset
         o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
         o << "    ldr w3, [x2]\n";           // Load current array value into w3
         o << "    sub w3, w3, w0\n";         // Subtract the value
@@ -313,10 +360,10 @@ void IRInstr::gen_asm(std::ostream &o)
         // mulTblx: params[0]=base_offset, params[1]=value_to_mul (mem/imm), params[2]=index (mem/imm)
         // Address = fp - base_offset + index * 4
         if (t == VarType::FLOAT_PTR) {
-            move(o, params[2], "w5");      // index
-            fmove(o, params[1], "s0");      // value_to_mul
+            move(o, asmParams[2], "w5");      // index
+            fmove(o, asmParams[1], "s0");      // value_to_mul
             o << "    lsl w2, w5, #2\n";         // offset = index * 4
-            o << "    sub x3, fp, #" << params[0] << "\n"; // base addr = fp - base_offset
+            o << "    sub x3, fp, #" << asmParams[0] << "\n"; // base addr = fp - base_offset
             o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
             o << "    ldr s1, [x2]\n";           // Load current array value into s1
             o << "    fmul s1, s1, s0\n";         // Multiply the value
@@ -324,10 +371,10 @@ void IRInstr::gen_asm(std::ostream &o)
             break;
         }
 
-        move(o, params[2], "w1");      // index
-        move(o, params[1], "w0");      // value_to_mul
+        move(o, asmParams[2], "w1");      // index
+        move(o, asmParams[1], "w0");      // value_to_mul
         o << "    lsl w2, w1, #2\n";         // offset = index * 4
-        o << "    sub x3, fp, #" << params[0] << "\n"; // base addr = fp - base_offset
+        o << "    sub x3, fp, #" << asmParams[0] << "\n"; // base addr = fp - base_offset
         o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
         o << "    ldr w3, [x2]\n";           // Load current array value into w3
         o << "    mul w3, w3, w0\n";         // Multiply the value
@@ -338,10 +385,10 @@ void IRInstr::gen_asm(std::ostream &o)
         // divTblx: params[0]=base_offset, params[1]=divisor (mem/imm), params[2]=index (mem/imm)
         // Address = fp - base_offset + index * 4
         if (t == VarType::FLOAT_PTR) {
-            move(o, params[2], "w5");      // index
-            fmove(o, params[1], "s0");      // divisor
+            move(o, asmParams[2], "w5");      // index
+            fmove(o, asmParams[1], "s0");      // divisor
             o << "    lsl w2, w5, #2\n";         // offset = index * 4
-            o << "    sub x3, fp, #" << params[0] << "\n"; // base addr = fp - base_offset
+            o << "    sub x3, fp, #" << asmParams[0] << "\n"; // base addr = fp - base_offset
             o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
             o << "    ldr s1, [x2]\n";           // Load current array value (dividend) into s1
             o << "    fdiv s1, s1, s0\n";         // Divide the value
@@ -349,10 +396,10 @@ void IRInstr::gen_asm(std::ostream &o)
             break;
         }
 
-        move(o, params[2], "w1");      // index
-        move(o, params[1], "w0");      // divisor
+        move(o, asmParams[2], "w1");      // index
+        move(o, asmParams[1], "w0");      // divisor
         o << "    lsl w2, w1, #2\n";         // offset = index * 4
-        o << "    sub x3, fp, #" << params[0] << "\n"; // base addr = fp - base_offset
+        o << "    sub x3, fp, #" << asmParams[0] << "\n"; // base addr = fp - base_offset
         o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
         o << "    ldr w3, [x2]\n";           // Load current array value (dividend) into w3
         o << "    sdiv w3, w3, w0\n";        // Divide the value
@@ -360,10 +407,10 @@ void IRInstr::gen_asm(std::ostream &o)
         break;
     }
     case modTblx: {
-        move(o, params[2], "w1");      // index
-        move(o, params[1], "w0");      // divisor
+        move(o, asmParams[2], "w1");      // index
+        move(o, asmParams[1], "w0");      // divisor
         o << "    lsl w2, w1, #2\n";         // offset = index * 4
-        o << "    sub x3, fp, #" << params[0] << "\n"; // base addr = fp - base_offset
+        o << "    sub x3, fp, #" << asmParams[0] << "\n"; // base addr = fp - base_offset
         o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
         o << "    ldr w3, [x2]\n";           // Load current array value (dividend) into w3
         o << "    sdiv w4, w3, w0\n";        // quotient in w4
@@ -375,207 +422,269 @@ void IRInstr::gen_asm(std::ostream &o)
         // getTblx: params[0] = destination (mem), params[1] = base_offset (string literal number), params[2] = index (mem/imm)
         // Address = fp - base_offset + index * 4
         if (t == VarType::FLOAT_PTR) {
-            move(o, params[2], "w5");      // index
+            move(o, asmParams[2], "w5");      // index
             o << "    lsl w2, w5, #2\n";         // offset = index * 4
-            o << "    sub x3, fp, #" << params[1] << "\n"; // base addr = fp - base_offset
+            o << "    sub x3, fp, #" << asmParams[1] << "\n"; // base addr = fp - base_offset
             o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
             o << "    ldr s0, [x2]\n";           // Load value from array element into s0
-            fmove(o, "s0", params[0]); // Move s0 to destination
+            fmove(o, "s0", asmParams[0]); // Move s0 to destination
             break;
         }
 
-        move(o, params[2], "w1");      // index
+        move(o, asmParams[2], "w1");      // index
         o << "    lsl w2, w1, #2\n";         // offset = index * 4
-        o << "    sub x3, fp, #" << params[1] << "\n"; // base addr = fp - base_offset
+        o << "    sub x3, fp, #" << asmParams[1] << "\n"; // base addr = fp - base_offset
         o << "    add x2, x3, w2, uxtw\n";         // final addr = base + offset
         o << "    ldr w0, [x2]\n";           // Load value from array element into w0
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
+        break;
+    }
+    case addrTblx: {
+        // addrTblx: params[0] = destination (64 bits, mem), params[1] = base_offset, params[2] = index (mem/imm)
+        move(o, asmParams[2], "w1");      // index
+        o << "    sub x3, fp, #" << asmParams[1] << "\n"; // base addr = fp - base_offset
+        o << "    add x0, x3, w1, sxtw #2\n";   // final addr = base + index * 4
+        o << "    str x0, " << asmParams[0] << "\n";
         break;
     }
     case incr:
         // incr: params[0] = var (memory)
         if (t == VarType::FLOAT) {
-            fmove(o, params[0], "s0");
+            fmove(o, asmParams[0], "s0");
             fmove(o, "#1.00000000", "s1");
             o << "    fadd s0, s0, s1\n";
-            fmove(o, "s0", params[0]); // Move s0 to destination
+            fmove(o, "s0", asmParams[0]); // Move s0 to destination
             break;
         }
 
-        move(o, params[0], "w0"); // Load variable into w0
+        move(o, asmParams[0], "w0"); // Load variable into w0
         o << "    add w0, w0, #1\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case decr:
         // decr: params[0] = var (memory)
         if (t == VarType::FLOAT) {
-            fmove(o, params[0], "s0");
+            fmove(o, asmParams[0], "s0");
             fmove(o, "#1.00000000", "s1");
             o << "    fsub s0, s0, s1\n";
-            fmove(o, "s0", params[0]); // Move s0 to destination
+            fmove(o, "s0", asmParams[0]); // Move s0 to destination
             break;
         }
 
-        move(o, params[0], "w0"); // Load variable into w0
+        move(o, asmParams[0], "w0"); // Load variable into w0
         o << "    sub w0, w0, #1\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case cmp_eq: // ==
         // cmp_eq: params[0] = destination, params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fcmp s0, s1\n";
             o << "    cset w8, eq\n"; // Set w0 to 1 if eq, 0 otherwise
             o << "    and w8, w8, #0x1\n"; // Mask to get the result
-            move(o, "w8", params[0]); // Move w0 to destination
+            move(o, "w8", asmParams[0]); // Move w0 to destination
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        if (t == VarType::ADDRESS) {
+            o << "    ldr x0, " << asmParams[1] << "\n";
+            o << "    ldr x1, " << asmParams[2] << "\n";
+            o << "    cmp x0, x1\n";
+            o << "    cset w0, eq\n";
+            move(o, "w0", asmParams[0]);
+            break;
+        }
+
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    cmp w0, w1\n";
         o << "    cset w0, eq\n"; // Set w0 to 1 if eq, 0 otherwise
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
     case cmp_lt: // <
         // cmp_lt: params[0] = destination, params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fcmp s0, s1\n";
             o << "    cset w8, mi\n"; // Set w0 to 1 if lt, 0 otherwise
             o << "    and w8, w8, #0x1\n"; // Mask to get the result
-            move(o, "w8", params[0]); // Move w0 to destination
+            move(o, "w8", asmParams[0]); // Move w0 to destination
+            break;
+        }
+
+        if (t == VarType::ADDRESS) {
+            o << "    ldr x0, " << asmParams[1] << "\n";
+            o << "    ldr x1, " << asmParams[2] << "\n";
+            o << "    cmp x0, x1\n";
+            o << "    cset w0, lt\n";
+            move(o, "w0", asmParams[0]);
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    cmp w0, w1\n";
         o << "    cset w0, lt\n"; // Set w0 to 1 if lt, 0 otherwise
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case cmp_le: // <=
         // cmp_le: params[0] = destination, params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fcmp s0, s1\n";
             o << "    cset w8, ls\n"; // Set w0 to 1 if le, 0 otherwise
             o << "    and w8, w8, #0x1\n"; // Mask to get the result
-            move(o, "w8", params[0]); // Move w0 to destination
+            move(o, "w8", asmParams[0]); // Move w0 to destination
+            break;
+        }
+
+        if (t == VarType::ADDRESS) {
+            o << "    ldr x0, " << asmParams[1] << "\n";
+            o << "    ldr x1, " << asmParams[2] << "\n";
+            o << "    cmp x0, x1\n";
+            o << "    cset w0, le\n";
+            move(o, "w0", asmParams[0]);
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    cmp w0, w1\n";
         o << "    cset w0, le\n"; // Set w0 to 1 if le, 0 otherwise
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case cmp_ne: // !=
         // cmp_ne: params[0] = destination, params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fcmp s0, s1\n";
             o << "    cset w8, ne\n"; // Set w0 to 1 if ne, 0 otherwise
             o << "    and w8, w8, #0x1\n"; // Mask to get the result
-            move(o, "w8", params[0]); // Move w0 to destination
+            move(o, "w8", asmParams[0]); // Move w0 to destination
+            break;
+        }
+
+        if (t == VarType::ADDRESS) {
+            o << "    ldr x0, " << asmParams[1] << "\n";
+            o << "    ldr x1, " << asmParams[2] << "\n";
+            o << "    cmp x0, x1\n";
+            o << "    cset w0, ne\n";
+            move(o, "w0", asmParams[0]);
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    cmp w0, w1\n";
         o << "    cset w0, ne\n"; // Set w0 to 1 if ne, 0 otherwise
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case cmp_gt: // >
         // cmp_gt: params[0] = destination, params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fcmp s0, s1\n";
             o << "    cset w8, gt\n"; // Set w0 to 1 if gt, 0 otherwise
             o << "    and w8, w8, #0x1\n"; // Mask to get the result
-            move(o, "w8", params[0]); // Move w0 to destination
+            move(o, "w8", asmParams[0]); // Move w0 to destination
+            break;
+        }
+
+        if (t == VarType::ADDRESS) {
+            o << "    ldr x0, " << asmParams[1] << "\n";
+            o << "    ldr x1, " << asmParams[2] << "\n";
+            o << "    cmp x0, x1\n";
+            o << "    cset w0, gt\n";
+            move(o, "w0", asmParams[0]);
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    cmp w0, w1\n";
         o << "    cset w0, gt\n"; // Set w0 to 1 if gt, 0 otherwise
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case cmp_ge: // >=
         // cmp_ge: params[0] = destination, params[1] = left (mem/imm), params[2] = right (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
-            fmove(o, params[2], "s1");
+            fmove(o, asmParams[1], "s0");
+            fmove(o, asmParams[2], "s1");
             o << "    fcmp s0, s1\n";
             o << "    cset w8, ge\n"; // Set w0 to 1 if ge, 0 otherwise
             o << "    and w8, w8, #0x1\n"; // Mask to get the result
-            move(o, "w8", params[0]); // Move w0 to destination
+            move(o, "w8", asmParams[0]); // Move w0 to destination
             break;
         }
 
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        if (t == VarType::ADDRESS) {
+            o << "    ldr x0, " << asmParams[1] << "\n";
+            o << "    ldr x1, " << asmParams[2] << "\n";
+            o << "    cmp x0, x1\n";
+            o << "    cset w0, ge\n";
+            move(o, "w0", asmParams[0]);
+            break;
+        }
+
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    cmp w0, w1\n";
         o << "    cset w0, ge\n"; // Set w0 to 1 if ge, 0 otherwise
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case bit_and:
         // bit_and: params[0] = dest (mem), params[1] = left (mem/imm), params[2] = right (mem/imm)
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    and w0, w0, w1\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case bit_or:
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    orr w0, w0, w1\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case bit_xor:
-        move(o, params[1], "w0");
-        move(o, params[2], "w1");
+        move(o, asmParams[1], "w0");
+        move(o, asmParams[2], "w1");
         o << "    eor w0, w0, w1\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case unary_minus:
         // unary_minus: params[0] = destination, params[1] = source (mem/imm)
         if (t == VarType::FLOAT) {
-            fmove(o, params[1], "s0");
+            fmove(o, asmParams[1], "s0");
             o << "    fneg s0, s0\n"; // Negate the float
-            fmove(o, "s0", params[0]); // Move s0 to destination
+            fmove(o, "s0", asmParams[0]); // Move s0 to destination
             break;
         }
 
-        move(o, params[1], "w0");
+        move(o, asmParams[1], "w0");
         o << "    neg w0, w0\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case not_op: // logical not !
-        move(o, params[1], "w0");
+        move(o, asmParams[1], "w0");
         o << "    cmp w0, #0\n";
         o << "    cset w0, eq\n"; // Set w0 to 1 if w0 == 0, else 0
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case log_and: { // &&
@@ -583,11 +692,11 @@ void IRInstr::gen_asm(std::ostream &o)
         std::string labelFalse = ".Lfalse" + std::to_string(currentLabel);
         std::string labelEnd = ".Lend" + std::to_string(currentLabel);
 
-        move(o, params[1], "w0");
+        move(o, asmParams[1], "w0");
         o << "    cmp w0, #0\n";
         o << "    b.eq " << labelFalse << "\n"; // if first is false, result is false
 
-        move(o, params[2], "w0");
+        move(o, asmParams[2], "w0");
         o << "    cmp w0, #0\n";
         o << "    b.eq " << labelFalse << "\n"; // if second is false, result is false
 
@@ -599,7 +708,7 @@ void IRInstr::gen_asm(std::ostream &o)
         o << "    mov w0, #0\n";
 
         o << labelEnd << ":\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
     }
     case log_or: { // ||
@@ -607,11 +716,11 @@ void IRInstr::gen_asm(std::ostream &o)
         std::string labelTrue = ".Ltrue" + std::to_string(currentLabel);
         std::string labelEnd = ".Lend" + std::to_string(currentLabel);
 
-        move(o, params[1], "w0");
+        move(o, asmParams[1], "w0");
         o << "    cmp w0, #0\n";
         o << "    b.ne " << labelTrue << "\n"; // if first is true, result is true
 
-        move(o, params[2], "w0");
+        move(o, asmParams[2], "w0");
         o << "    cmp w0, #0\n";
         o << "    b.ne " << labelTrue << "\n"; // if second is true, result is true
 
@@ -623,131 +732,189 @@ void IRInstr::gen_asm(std::ostream &o)
         o << "    mov w0, #1\n";
 
         o << labelEnd << ":\n";
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
     }
 
-    case rmem:
-        // rmem: params[0] = destination (mem), params[1] = address (mem/imm)
-        move(o, params[1], "w1"); // Load address into w1
-        o << "    ldr w0, [x1]\n";        // Load value from address in w1 into w0
-        move(o, "w0", params[0]); // Move w0 to destination // Store value to destination
+    case rmem: {
+        // rmem: params[0] = destination (mem), params[1] = address (64 bits, mem), params[2] = displacement in bytes
+        std::string element = "[x1, #" + (params.size() > 2 ? params[2].name : "0") + "]";
+        o << "    ldr x1, " << asmParams[1] << "\n"; // Load address into x1
+        if (t == VarType::FLOAT) {
+            o << "    ldr s0, " << element << "\n";
+            fmove(o, "s0", asmParams[0]);
+            break;
+        }
+        o << "    ldr w0, " << element << "\n";  // Load value from address in x1 into w0
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
+    }
 
-    case wmem:
-        // wmem: params[0] = address (mem/imm), params[1] = value (mem/imm)
-        move(o, params[0], "w1"); // Load address into w1
-        move(o, params[1], "w0"); // Load value into w0
-        o << "    str w0, [x1]\n";        // Store value w0 to address in w1
+    case wmem: {
+        // wmem: params[0] = address (64 bits, mem), params[1] = value (mem/imm), params[2] = displacement in bytes
+        std::string element = "[x1, #" + (params.size() > 2 ? params[2].name : "0") + "]";
+        o << "    ldr x1, " << asmParams[0] << "\n"; // Load address into x1
+        if (t == VarType::FLOAT) {
+            fmove(o, asmParams[1], "s0");
+            o << "    str s0, " << element << "\n";
+            break;
+        }
+        move(o, asmParams[1], "w0"); // Load value into w0
+        o << "    str w0, " << element << "\n";  // Store value w0 to address in x1
         break;
+    }
 
     case intToFloat:
         // intToFloat: params[0] = destination, params[1] = source
-        move(o, params[1], "w0");
+        move(o, asmParams[1], "w0");
         o << "    scvtf s0, w0\n"; // Convert int to float
-        fmove(o, "s0", params[0]); // Move s0 to destination
+        fmove(o, "s0", asmParams[0]); // Move s0 to destination
         break;
 
     case floatToInt:
         // floatToInt: params[0] = destination, params[1] = source
-        fmove(o, params[1], "s0");
+        fmove(o, asmParams[1], "s0");
         o << "    fcvtzs w0, s0\n"; // Convert float to int
-        move(o, "w0", params[0]); // Move w0 to destination
+        move(o, "w0", asmParams[0]); // Move w0 to destination
         break;
 
     case call:
         // call: params[0] = label, params[1] = destination (mem), params[2]... = parameters (assume setup before call)
         // Parameters should be loaded into w0-w7 by preceding instructions (e.g., copy)
-        o << "    bl _" << params[0] << "\n"; // Branch with link (call)
-        move(o, "w0", params[1]); // Move return value to w0
+        o << "    bl _" << asmParams[0] << "\n"; // Branch with link (call)
+        move(o, "w0", asmParams[1]); // Move return value to w0
         break;
 
     case jmp:
         // jmp: params[0] = label
-        o << "    b " << params[0] << "\n";
+        o << "    b " << asmParams[0] << "\n";
         break;
 
-    default:
-        o << "    // Unsupported IR operation for ARM64\n";
+    case select: {
+        // select: params[0] = dest, params[1] = condition, params[2] = value if true, params[3] = value otherwise
+        if (t == VarType::FLOAT) {
+            fmove(o, asmParams[2], "s0");
+            fmove(o, asmParams[3], "s1");
+        } else if (t == VarType::ADDRESS) {
+            o << "    ldr x10, " << asmParams[2] << "\n";
+            o << "    ldr x11, " << asmParams[3] << "\n";
+        } else {
+            move(o, asmParams[2], "w10");
+            move(o, asmParams[3], "w11");
+        }
+        string cond = "ne";
+        if (fused_cmp != nullptr) {
+            // The comparison right before gives the flags of csel directly
+            vector<string> cmpParams = fused_cmp->lower_params();
+            if (fused_cmp->t == VarType::ADDRESS) {
+                o << "    ldr x12, " << cmpParams[1] << "\n";
+                o << "    ldr x13, " << cmpParams[2] << "\n";
+                o << "    cmp x12, x13\n";
+            } else {
+                move(o, cmpParams[1], "w12");
+                move(o, cmpParams[2], "w13");
+                o << "    cmp w12, w13\n";
+            }
+            cond = conditionCode(fused_cmp->op);
+        } else {
+            move(o, asmParams[1], "w12");
+            o << "    cmp w12, #0\n";
+        }
+        if (t == VarType::FLOAT) {
+            o << "    fcsel s0, s0, s1, " << cond << "\n";
+            fmove(o, "s0", asmParams[0]);
+            break;
+        }
+        if (t == VarType::ADDRESS) {
+            o << "    csel x10, x10, x11, " << cond << "\n";
+            o << "    str x10, " << asmParams[0] << "\n";
+            break;
+        }
+        o << "    csel w10, w10, w11, " << cond << "\n";
+        move(o, "w10", asmParams[0]);
         break;
     }
+
+    default:
+        // Une opération que les passes auraient dû faire disparaître (un phi hors SSA...): le code serait faux
+        FeedbackOutputFormat::showFeedbackOutput("error", "internal error: unsupported IR operation " + to_string(op) + " in " + bb->label);
+        exit(1);
+    }
 }
 
 //* ---------------------- BasicBlock ---------------------- */
 
-void BasicBlock::gen_asm(std::ostream &o)
+void BasicBlock::gen_asm(std::ostream &o, BasicBlock *next)
 {
     // Generate assembly for each instruction in the block
-    for (auto instr : instrs)
+    for (size_t i = 0; i < instrs.size(); i++)
     {
-        instr->gen_asm(o);
+        // A fused comparison is emitted with the branch or the select that follows it
+        bool fused = instrs[i] == fused_test || (i + 1 < instrs.size() && instrs[i + 1]->fused_cmp == instrs[i]);
+        if (!fused && !instrs[i]->tail_call)
+            instrs[i]->gen_asm(o);
     }
 
-    // Handle jumps at the end of the block
+    // Handle jumps at the end of the block; the next block is reached by falling through
     if (!test_var_name.empty() && exit_true != nullptr && exit_false != nullptr)
     {
-        // Conditional jump based on test_var_register (already in assembly format, e.g., [fp, #-8])
-        move(o, test_var_register, "w0"); // Load variable into w0
-        o << "    cmp w0, #0\n";                        // Compare with zero
-        o << "    b.eq " << exit_false->label << "\n";    // Branch to false label if zero
-        o << "    b " << exit_true->label << "\n";       // Otherwise, branch to true label
+        if (fused_test != nullptr)
+        {
+            // La comparaison donne directement les drapeaux du saut
+            vector<string> asmParams = fused_test->lower_params();
+            if (fused_test->t == VarType::ADDRESS) {
+                o << "    ldr x0, " << asmParams[1] << "\n";
+                o << "    ldr x1, " << asmParams[2] << "\n";
+                o << "    cmp x0, x1\n";
+            } else {
+                move(o, asmParams[1], "w0");
+                move(o, asmParams[2], "w1");
+                o << "    cmp w0, w1\n";
+            }
+            string cond = conditionCode(fused_test->op);
+            if (exit_true == next) {
+                o << "    b." << negated(cond) << " " << exit_false->label << "\n";
+                return;
+            }
+            o << "    b." << cond << " " << exit_true->label << "\n";
+        }
+        else
+        {
+            // Conditional jump based on test_var (lowered to e.g. [fp, #-8])
+            move(o, cfg->IR_reg_to_asm(test_var), "w0"); // Load variable into w0
+            if (exit_true == next) {
+                o << "    cbz w0, " << exit_false->label << "\n"; // Branch to false label if zero
+                return;
+            }
+            o << "    cbnz w0, " << exit_true->label << "\n"; // Branch to true label if not zero
+        }
+        if (exit_false != next)
+            o << "    b " << exit_false->label << "\n";
     }
     else if (exit_true != nullptr)
     {
-        // Unconditional jump
-        if (exit_true->label != cfg->get_epilogue_label())
-        {
+        // Unconditional jump, unless the target comes right after
+        if (exit_true != next)
             o << "    b " << exit_true->label << "\n";
-        }
     } 
     else
-    {   // si on est à la fin de cfg (fin de function)
-        cfg->gen_asm_epilogue(o);
+    {   // si on est à la fin de cfg (fin de function), ou sur un appel terminal
+        bool tail = !instrs.empty() && instrs.back()->tail_call;
+        cfg->gen_asm_epilogue(o, tail ? instrs.back()->params[0].name : "");
     }
 }
 
 //* ---------------------- CFG ---------------------- */
-void BasicBlock::add_IRInstr(IRInstr::Operation op, VarType t, std::vector<std::string> params)
-{
-    bool isCallOrJmp = (op == IRInstr::Operation::call || op == IRInstr::Operation::jmp);
-    bool isTblBaseOffset = (op == IRInstr::Operation::copyTblx || op == IRInstr::Operation::addTblx ||
-                           op == IRInstr::Operation::subTblx || op == IRInstr::Operation::mulTblx ||
-                           op == IRInstr::Operation::divTblx || op == IRInstr::Operation::modTblx );
-
-    std::string p0 = isCallOrJmp ? params[0] : cfg->IR_reg_to_asm(params[0]);
-    std::string p1 = params.size() >= 2 ? cfg->IR_reg_to_asm(params[1]) : "";
-    std::string p2 = params.size() >= 3 ? cfg->IR_reg_to_asm(params[2]) : "";
-
-    if (isTblBaseOffset) {
-        Symbol *p = cfg->currentScope->findVariable(params[0]);
-        p0 = std::to_string(p->offset); // Get the offset for the base address
-    }
-
-    if (op == IRInstr::Operation::getTblx) {
-        Symbol *p = cfg->currentScope->findVariable(params[1]);
-        p1 = std::to_string(p->offset); // Get the offset for the index
-    }
-
-    std::vector<std::string> paramsRealAddr = {p0, p1, p2};
-
-    // Optimization: If it's a copy from a constant, change op to ldconst
-    if (op == IRInstr::Operation::copy && CFG::isRegConstant(paramsRealAddr[1])) {
-        op = IRInstr::Operation::ldconst;
-    }
-
-    IRInstr *instr = new IRInstr(this, op, t, paramsRealAddr);
-    instrs.push_back(instr);
-
-    // Update test_var_register if this block sets a condition variable for a later jump
-    if (op >= IRInstr::Operation::cmp_eq && op <= IRInstr::Operation::cmp_ge && cfg->current_bb == this) {
-        test_var_register = paramsRealAddr[0]; // Store the assembly operand (e.g., "[fp, #-12]")
-    }
-}
-
 
 void CFG::gen_asm(std::ostream &o)
 {
+    allocate_stack_slots();
+    find_fused_tests();
+
     o << ".global _" << ast->getName() << "\n"; // Export function symbol
+    if (memo_size > 0) {
+        gen_asm_memo(o); // the exported name is the table lookup, which calls the body on a miss
+    }
 
     for (size_t i = 0; i < bbs.size(); i++)
     {
@@ -757,46 +924,81 @@ void CFG::gen_asm(std::ostream &o)
             o << "_" << bbs[i]->label << ":\n";
             gen_asm_prologue(o);
         } else {
+            if (bbs[i]->aligned)
+                o << "    .p2align 4\n"; // en-tête de boucle aligné sur 16 octets
             o << bbs[i]->label << ":\n";
         }
-        bbs[i]->gen_asm(o);
+        bbs[i]->gen_asm(o, i + 1 < bbs.size() ? bbs[i + 1] : nullptr);
     }
 }
 
-// Translate IR Register names to ARM64 assembly operands
-std::string CFG::IR_reg_to_asm(std::string &reg, bool ignoreCst)
+// Translate IR operands to ARM64 assembly operands
+std::string CFG::IR_reg_to_asm(const IROperand &reg)
 {
-    // Use symbol table to find variable/parameter location
-    Symbol *p = currentScope->findVariable(reg);
-    if (p != nullptr)
+    switch (reg.kind)
     {
-        if (p->isConstant() && !ignoreCst) {
-            if (p->getType() != VarType::FLOAT) {
-                return "#" + p->getCstValue();
-            }
-
-            std::string label = rodm->putFloatIfNotExists(std::stof(p->getCstValue()));
-            return "_" + label;
+    case IROperand::vreg: {
+        int offset = vregs[reg.id].offset;
+        if (offset < 254) {
+            // Return frame pointer relative address [fp, #offset]
+            return "[fp, #-" + std::to_string(offset) + "]";
         }
 
-        if (p->scopeType == GLOBAL) {
-            return "_" + reg;
-
-        } else {
-
-            if (p->offset < 254) {
-                // Return frame pointer relative address [fp, #offset]
-                return "[fp, #-" + std::to_string(p->offset) + "]";
-            }
-
-            // With offset > 254, we can not use [fp, #offset] directly, so add ;;; to indicate
-            // that this is a special case and needs to be handled differently
-            return ";;;[fp, #-" + std::to_string(p->offset) + "]";
+        // With offset > 254, we can not use [fp, #offset] directly, so add ;;; to indicate
+        // that this is a special case and needs to be handled differently
+        return ";;;[fp, #-" + std::to_string(offset) + "]";
+    }
+    case IROperand::global:
+        return "_" + reg.name;
+    case IROperand::imm:
+        if (!Symbol::isFloatingType(reg.type)) {
+            return "#" + reg.name;
         }
+        return "_" + rodm->putFloatIfNotExists(std::stof(reg.name));
+    case IROperand::preg:
+    case IROperand::label:
+        // Registers of the calling convention and labels are used as is
+        return reg.name;
+    default:
+        return "";
     }
+}
 
-    // Fallback: return the name itself, maybe it's a label or needs later handling.
-    return reg;
+// Entry of a memoized function: an argument inside the table (unsigned comparison, which also rejects the
+// negative ones) already computed returns its value, otherwise the body is called and its result stored
+void CFG::gen_asm_memo(std::ostream &o)
+{
+    std::string name = "_" + ast->getName();
+    std::string body = "_" + bbs[0]->label;
+    std::string miss = ".Lmemo_" + ast->getName();
+    o << name << ":\n";
+    o << "    cmp w0, #" << memo_size << "\n";
+    o << "    b.hs " << body << "\n";
+    o << "    adrp x9, " << name << ".known@PAGE\n";
+    o << "    add x9, x9, " << name << ".known@PAGEOFF\n";
+    o << "    ldrb w10, [x9, w0, uxtw]\n";
+    o << "    cbz w10, " << miss << "\n";
+    o << "    adrp x9, " << name << ".memo@PAGE\n";
+    o << "    add x9, x9, " << name << ".memo@PAGEOFF\n";
+    o << "    ldr w0, [x9, w0, uxtw #2]\n";
+    o << "    ret\n";
+    o << miss << ":\n";
+    o << "    stp fp, x30, [sp, #-32]!\n";
+    o << "    mov fp, sp\n";
+    o << "    str w0, [sp, #16]\n"; // keep the argument across the call
+    o << "    bl " << body << "\n";
+    o << "    ldr w1, [sp, #16]\n";
+    o << "    adrp x9, " << name << ".memo@PAGE\n";
+    o << "    add x9, x9, " << name << ".memo@PAGEOFF\n";
+    o << "    str w0, [x9, w1, uxtw #2]\n";
+    o << "    adrp x9, " << name << ".known@PAGE\n";
+    o << "    add x9, x9, " << name << ".known@PAGEOFF\n";
+    o << "    mov w10, #1\n";
+    o << "    strb w10, [x9, w1, uxtw]\n";
+    o << "    ldp fp, x30, [sp], #32\n";
+    o << "    ret\n";
+    o << ".zerofill __DATA,__bss," << name << ".memo," << 4 * memo_size << ",2\n";
+    o << ".zerofill __DATA,__bss," << name << ".known," << memo_size << ",0\n";
 }
 
 void CFG::gen_asm_prologue(std::ostream &o)
@@ -818,7 +1020,7 @@ void CFG::gen_asm_prologue(std::ostream &o)
     }
 }
 
-void CFG::gen_asm_epilogue(std::ostream &o)
+void CFG::gen_asm_epilogue(std::ostream &o, std::string tailCallee)
 {
     // Standard ARM64 epilogue
     size_t stackSize = getStackSize();
@@ -830,15 +1032,14 @@ void CFG::gen_asm_epilogue(std::ostream &o)
     }
     // Restore frame pointer and link register
     o << "    ldp x29, x30, [sp], #16\n";
+    if (!tailCallee.empty()) {
+        // Tail call: the callee returns directly to our caller through the restored x30
+        o << "    b _" << tailCallee << "\n";
+        return;
+    }
     o << "    ret\n";
 }
 
-// Helper to check if a string represents an immediate constant ('#...')
-bool CFG::isRegConstant(std::string& reg)
-{
-    return !reg.empty() && reg[0] == '#';
-}
-
 
 //* ---------------------- GlobalVarManager ---------------------- */
 void GVM::gen_asm(std::ostream &o)
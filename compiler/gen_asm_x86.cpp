@@ -2,6 +2,7 @@
 #include <vector>
 #include "IR.h"
 #include "CodeGenVisitor.h"
+#include "FeedbackStyleOutput.h"
 using namespace std;
 
 // Génération de code assembleur pour l'instruction for x86 machine
@@ -18,12 +19,46 @@ vector<string> floatRegs = {"%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5"
 string returnReg = "%eax"; // Register used for return value
 string floatReturnReg = "%xmm0"; // Register used for return value (float)
 
+// Registers given to the virtual registers by the register allocator (RegisterAllocator.cpp).
+// None of them is used as a scratch register by IRInstr::gen_asm.
+vector<string> allocatableCalleeSaved = {"%r12d", "%r13d", "%r14d", "%r15d"}; // saved by the prologue, kept across calls
+vector<string> allocatableCallerSaved = {"%r10d", "%r11d"};                    // only for values not live across a call
+vector<string> allocatableFloatRegs = {"%xmm8", "%xmm9", "%xmm10", "%xmm11", "%xmm12", "%xmm13", "%xmm14", "%xmm15"}; // all caller-saved
+
 
 bool isRegister(std::string &reg)
 {
     return (!reg.empty() && reg[0] == '%' );
 }
 
+// An address (VarType::ADDRESS) takes 64 bits: the register allocator gives "%r12d", the address is in %r12
+std::string quad(std::string operand)
+{
+    if (isRegister(operand) && operand.back() == 'd')
+        return operand.substr(0, operand.size() - 1);
+    return operand;
+}
+
+// Base register of an access through an address: the address itself if it is in a register, else %rax
+std::string loadAddress(std::ostream &o, std::string address)
+{
+    if (isRegister(address))
+        return quad(address);
+
+    o << "    movq " << address << ", %rax\n";
+    return "%rax";
+}
+
+// Comparison of two addresses: setcc is the set instruction of the comparison, e.g. "setl"
+void compareAddresses(std::ostream &o, std::string setcc, std::vector<std::string> &asmParams)
+{
+    o << "    movq " << quad(asmParams[1]) << ", %rax\n";
+    o << "    cmpq " << quad(asmParams[2]) << ", %rax\n";
+    o << "    " << setcc << " %al\n";
+    o << "    movzbl %al, %eax\n";
+    o << "    movl %eax, " << asmParams[0] << "\n";
+}
+
 void move(std::ostream &o, VarType t, std::string src, std::string dest)
 {
     if (t == VarType::FLOAT || t == VarType::FLOAT_PTR)
@@ -37,407 +72,522 @@ void move(std::ostream &o, VarType t, std::string src, std::string dest)
     o << "    movl " << src << ", " << dest << "\n";
 }
 
+bool isImmediate(std::string &operand)
+{
+    return (!operand.empty() && operand[0] == '$');
+}
+
+// idiv can not take an immediate operand: load it in the given register first
+std::string loadDivisor(std::ostream &o, std::string divisor, std::string reg)
+{
+    if (!isImmediate(divisor))
+        return divisor;
+
+    o << "    movl " << divisor << ", " << reg << "\n";
+    return reg;
+}
+
+// Suffixe de jcc d'une comparaison entière, et sa négation
+std::string conditionCode(IRInstr::Operation op)
+{
+    switch (op)
+    {
+    case IRInstr::cmp_eq: return "e";
+    case IRInstr::cmp_ne: return "ne";
+    case IRInstr::cmp_lt: return "l";
+    case IRInstr::cmp_le: return "le";
+    case IRInstr::cmp_gt: return "g";
+    default: return "ge";
+    }
+}
+
+std::string negated(std::string cc)
+{
+    if (cc == "e") return "ne";
+    if (cc == "ne") return "e";
+    if (cc == "l") return "ge";
+    if (cc == "ge") return "l";
+    if (cc == "le") return "g";
+    return "le";
+}
+
 void IRInstr::gen_asm(std::ostream &o)
 {
     static int labelCounter = 0;
-    // Pour simplifier, on gère ici ldconst, copy, add, sub et mul.
+    std::vector<std::string> asmParams = lower_params();
+    std::string divisor;
 
     switch (op)
     {
     case ldconst:
         // ldconst: params[0] = destination, params[1] = constante
-        o << "    movl " << params[1] << ", " << params[0] << "\n";
+        o << "    movl " << asmParams[1] << ", " << asmParams[0] << "\n";
         break;
     case copy:
         // copy: params[0] = destination, params[1] = source
+        if (asmParams[0] == asmParams[1])
+            break; // same register after allocation
+
+        if (t == VarType::ADDRESS) {
+            if (isRegister(asmParams[0]) || isRegister(asmParams[1])) {
+                o << "    movq " << quad(asmParams[1]) << ", " << quad(asmParams[0]) << "\n";
+                break;
+            }
+            o << "    movq " << asmParams[1] << ", %rax\n";
+            o << "    movq %rax, " << asmParams[0] << "\n";
+            break;
+        }
+
+        if (isRegister(asmParams[0]) || isRegister(asmParams[1])) {
+            move(o, t, asmParams[1], asmParams[0]); // no memory to memory move
+            break;
+        }
+
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm5");
-            move(o, t, "%xmm5", params[0]);
+            move(o, t, asmParams[1], "%xmm5");
+            move(o, t, "%xmm5", asmParams[0]);
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        if (params[0] != "%eax")
-            o << "    movl %eax, " << params[0] << "\n"; // Stocke le résultat
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    movl %eax, " << asmParams[0] << "\n"; // Stocke le résultat
         break;
     case add:
         // add: params[0] = dest, params[1] = gauche, params[2] = droite
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm0");
-            o << "    addss " << params[2] << ", %xmm0\n";
-            move(o, t, "%xmm0", params[0]);
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    addss " << asmParams[2] << ", %xmm0\n";
+            move(o, t, "%xmm0", asmParams[0]);
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    addl " << params[2] << ", %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        if (t == VarType::ADDRESS) {
+            // Pas d'un pointeur (StrengthReduction.cpp): params[2] est un immédiat
+            if (asmParams[0] == asmParams[1] && isRegister(asmParams[0])) {
+                o << "    addq " << asmParams[2] << ", " << quad(asmParams[0]) << "\n";
+                break;
+            }
+            o << "    movq " << quad(asmParams[1]) << ", %rax\n";
+            o << "    addq " << asmParams[2] << ", %rax\n";
+            o << "    movq %rax, " << quad(asmParams[0]) << "\n";
+            break;
+        }
+
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    addl " << asmParams[2] << ", %eax\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
     case sub:
         // sub: params[0] = dest, params[1] = gauche, params[2] = droite
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm0");
-            o << "    subss " << params[2] << ", %xmm0\n";
-            move(o, t, "%xmm0", params[0]);
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    subss " << asmParams[2] << ", %xmm0\n";
+            move(o, t, "%xmm0", asmParams[0]);
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    subl " << params[2] << ", %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    subl " << asmParams[2] << ", %eax\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
     case mul:
         // mul: params[0] = dest, params[1] = gauche, params[2] = droite
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm0");
-            o << "    mulss " << params[2] << ", %xmm0\n";
-            move(o, t, "%xmm0", params[0]);
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    mulss " << asmParams[2] << ", %xmm0\n";
+            move(o, t, "%xmm0", asmParams[0]);
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    imull " << params[2] << ", %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    imull " << asmParams[2] << ", %eax\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
     case div: // params : dest, source1, source2
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm0");
-            o << "    divss " << params[2] << ", %xmm0\n";
-            move(o, t, "%xmm0", params[0]);
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    divss " << asmParams[2] << ", %xmm0\n";
+            move(o, t, "%xmm0", asmParams[0]);
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
+        divisor = loadDivisor(o, asmParams[2], "%ecx");
+        o << "    movl " << asmParams[1] << ", %eax\n";
         o << "    cltd\n";
-        o << "    idivl " << params[2] << "\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    idivl " << divisor << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
     case mod: // params : dest, source1, source2
-        o << "    movl " << params[1] << ", %eax\n";
+        divisor = loadDivisor(o, asmParams[2], "%ecx");
+        o << "    movl " << asmParams[1] << ", %eax\n";
         o << "    cltd\n";
-        o << "    idivl " << params[2] << "\n";
-        o << "    movl %edx, " << params[0] << "\n";
+        o << "    idivl " << divisor << "\n";
+        o << "    movl %edx, " << asmParams[0] << "\n";
         break;
 
     case copyTblx: {
         // copy: params[0] = destination, params[1] = expr, params[2] = position
         if (t == VarType::FLOAT_PTR) {
-            move(o, t, params[1], "%xmm0");
-            move (o, VarType::INT, params[2], "%eax");                     // Load index into %eax
+            move(o, t, asmParams[1], "%xmm0");
+            move (o, VarType::INT, asmParams[2], "%eax");                     // Load index into %eax
             o << "    movslq %eax, %rbx\n";                                // Sign extend to 64-bit
-            o << "    leaq -" << (params[0]) << "(%rbp, %rbx, 4), %rax\n"; // Correct displacement and scaling
+            o << "    leaq -" << (asmParams[0]) << "(%rbp, %rbx, 4), %rax\n"; // Correct displacement and scaling
             move (o, t, "%xmm0", "(%rax)"); // Store back
             break;
         }
         
-        o << "    movl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[2] << ", %eax\n";
         o << "    movslq %eax, %rbx\n";                                // Sign extend to 64-bit
-        o << "    leaq -" << (params[0]) << "(%rbp, %rbx, 4), %rax\n"; // Correct displacement and scaling
-        o << "    movl " << params[1] << ", %edx\n";
+        o << "    leaq -" << (asmParams[0]) << "(%rbp, %rbx, 4), %rax\n"; // Correct displacement and scaling
+        o << "    movl " << asmParams[1] << ", %edx\n";
         o << "    movl %edx, (%rax)\n";
         break;
     }
     case addTblx: {
         // add: params[0] = destination, params[1] = expr, params[2] = position
         if (t == VarType::FLOAT_PTR) {
-            move(o, t, params[1], "%xmm0");
-            move (o, VarType::INT, params[2], "%eax");                      // Load index into %eax
+            move(o, t, asmParams[1], "%xmm0");
+            move (o, VarType::INT, asmParams[2], "%eax");                      // Load index into %eax
             o << "    movslq %eax, %rbx\n";                                 // Sign extend to 64-bit
-            o << "    leaq -" << (params[0]) << "(%rbp, %rbx, 4), %rax\n";
+            o << "    leaq -" << (asmParams[0]) << "(%rbp, %rbx, 4), %rax\n";
             move (o, t, "(%rax)", "%xmm1");                                 // Load current array value into %xmm1
             o << "    addss %xmm1, %xmm0\n";
             move (o, t, "%xmm0", "(%rax)");                                 // Store back
             break;
         }
         
-        o << "    movl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[2] << ", %eax\n";
         o << "    movslq %eax, %rbx\n"; // Sign extend to 64-bit
-        o << "    leaq -" << (params[0]) << "(%rbp, %rbx, 4), %rax\n";
+        o << "    leaq -" << (asmParams[0]) << "(%rbp, %rbx, 4), %rax\n";
         o << "    movl (%rax), %edx\n";
-        o << "    addl " << params[1] << ", %edx\n"; // Ajoute la valeur
+        o << "    addl " << asmParams[1] << ", %edx\n"; // Ajoute la valeur
         o << "    movl %edx, (%rax)\n";
         break;
     }
     case subTblx: {
         // sub: params[0] = destination, params[1] = expr, params[2] = position
         if (t == VarType::FLOAT_PTR) {
-            move(o, t, params[1], "%xmm0");
-            move (o, VarType::INT, params[2], "%eax");                      // Load index into %eax
+            move(o, t, asmParams[1], "%xmm0");
+            move (o, VarType::INT, asmParams[2], "%eax");                      // Load index into %eax
             o << "    movslq %eax, %rbx\n";                                 // Sign extend to 64-bit
-            o << "    leaq -" << (params[0]) << "(%rbp, %rbx, 4), %rax\n";
+            o << "    leaq -" << (asmParams[0]) << "(%rbp, %rbx, 4), %rax\n";
             move (o, t, "(%rax)", "%xmm1");                                 // Load current array value into %xmm1
             o << "    subss %xmm0, %xmm1\n";
             move (o, t, "%xmm1", "(%rax)");                                 // Store back
             break;
         }
         
-        o << "    movl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[2] << ", %eax\n";
         o << "    movslq %eax, %rbx\n"; // Sign extend to 64-bit
-        o << "    leaq -" << (params[0]) << "(%rbp, %rbx, 4), %rax\n";
+        o << "    leaq -" << (asmParams[0]) << "(%rbp, %rbx, 4), %rax\n";
         o << "    movl (%rax), %edx\n";
-        o << "    subl " << params[1] << ", %edx\n"; // Sub la valeur
+        o << "    subl " << asmParams[1] << ", %edx\n"; // Sub la valeur
         o << "    movl %edx, (%rax)\n";
         break;
     }
     case mulTblx: {
         // mul: params[0] = destination, params[1] = expr, params[2] = position
         if (t == VarType::FLOAT_PTR) {
-            move(o, t, params[1], "%xmm0");
-            move (o, VarType::INT, params[2], "%eax");                      // Load index into %eax
+            move(o, t, asmParams[1], "%xmm0");
+            move (o, VarType::INT, asmParams[2], "%eax");                      // Load index into %eax
             o << "    movslq %eax, %rbx\n";                                 // Sign extend to 64-bit
-            o << "    leaq -" << (params[0]) << "(%rbp, %rbx, 4), %rax\n";
+            o << "    leaq -" << (asmParams[0]) << "(%rbp, %rbx, 4), %rax\n";
             move (o, t, "(%rax)", "%xmm1");                                 // Load current array value into %xmm1
             o << "    mulss %xmm1, %xmm0\n";
             move (o, t, "%xmm0", "(%rax)");                                 // Store back
             break;
         }
         
-        o << "    movl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[2] << ", %eax\n";
         o << "    movslq %eax, %rbx\n"; // Sign extend to 64-bit
-        o << "    leaq -" << params[0] << "(%rbp, %rbx, 4), %rax\n";
+        o << "    leaq -" << asmParams[0] << "(%rbp, %rbx, 4), %rax\n";
         o << "    movl (%rax), %edx\n";
-        o << "    imull " << params[1] << ", %edx\n"; // Mul la valeur
+        o << "    imull " << asmParams[1] << ", %edx\n"; // Mul la valeur
         o << "    movl %edx, (%rax)\n";
         break;
     }
     case divTblx: {
         // div: params[0] = destination, params[1] = expr, params[2] = position
         if (t == VarType::FLOAT_PTR) {
-            move(o, t, params[1], "%xmm0");
-            move (o, VarType::INT, params[2], "%eax");                      // Load index into %eax
+            move(o, t, asmParams[1], "%xmm0");
+            move (o, VarType::INT, asmParams[2], "%eax");                      // Load index into %eax
             o << "    movslq %eax, %rbx\n";                                 // Sign extend to 64-bit
-            o << "    leaq -" << (params[0]) << "(%rbp, %rbx, 4), %rax\n";
+            o << "    leaq -" << (asmParams[0]) << "(%rbp, %rbx, 4), %rax\n";
             move (o, t, "(%rax)", "%xmm1");                                 // Load current array value into %xmm1
             o << "    divss %xmm0, %xmm1\n";
             move (o, t, "%xmm1", "(%rax)");                                 // Store back
             break;
         }
         
-        o << "    movl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[2] << ", %eax\n";
         o << "    movslq %eax, %rbx\n"; // Sign extend to 64-bit
-        o << "    leaq -" << params[0] << "(%rbp, %rbx, 4), %rcx\n";
+        o << "    leaq -" << asmParams[0] << "(%rbp, %rbx, 4), %rcx\n";
         o << "    movl (%rcx), %eax\n";
         o << "    cltd\n";
-        o << "    idivl " << params[1] << "\n"; // Div la valeur
+        divisor = loadDivisor(o, asmParams[1], "%esi");
+        o << "    idivl " << divisor << "\n"; // Div la valeur
         o << "    movl %eax, (%rcx)\n";
         break;
     }
     case modTblx: {
         // mod: params[0] = destination, params[1] = expr, params[2] = position
-        o << "    movl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[2] << ", %eax\n";
         o << "    movslq %eax, %rbx\n"; // Sign extend to 64-bit
-        o << "    leaq -" << params[0] << "(%rbp, %rbx, 4), %rcx\n";
+        o << "    leaq -" << asmParams[0] << "(%rbp, %rbx, 4), %rcx\n";
         o << "    movl (%rcx), %eax\n";
         o << "    cltd\n";
-        o << "    idivl " << params[1] << "\n"; // Mod la valeur
+        divisor = loadDivisor(o, asmParams[1], "%esi");
+        o << "    idivl " << divisor << "\n"; // Mod la valeur
         o << "    movl %edx, (%rcx)\n";
         break;
     }
     case getTblx: {
         // copy: params[0] = destination, params[1] = tableaux, params[2] = position
         if (t == VarType::FLOAT_PTR) {
-            move (o, VarType::INT, params[2], "%eax");                      // Load index into %eax
+            move (o, VarType::INT, asmParams[2], "%eax");                      // Load index into %eax
             o << "    movslq %eax, %rbx\n"; // Sign extend to 64-bit
-            o << "    leaq -" << (params[1]) << "(%rbp, %rbx, 4), %rax\n";  // Correct displacement and scaling
+            o << "    leaq -" << (asmParams[1]) << "(%rbp, %rbx, 4), %rax\n";  // Correct displacement and scaling
             move (o, t, "(%rax)", "%xmm1"); // Store back
-            move (o, t, "%xmm1", params[0]);
+            move (o, t, "%xmm1", asmParams[0]);
             break;
         }
         
-        o << "    movl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[2] << ", %eax\n";
         o << "    movslq %eax, %rbx\n";                                // Sign extend to 64-bit
-        o << "    leaq -" << (params[1]) << "(%rbp, %rbx, 4), %rax\n"; // Correct displacement and scaling
+        o << "    leaq -" << (asmParams[1]) << "(%rbp, %rbx, 4), %rax\n"; // Correct displacement and scaling
         o << "    movl (%rax), %edx\n";
-        o << "    movl %edx, " << params[0] << "\n";
+        o << "    movl %edx, " << asmParams[0] << "\n";
+        break;
+    }
+    case addrTblx: {
+        // addrTblx: params[0] = destination (64 bits), params[1] = tableau, params[2] = position
+        if (isImmediate(asmParams[2])) {
+            int offset = stoi(asmParams[1]) - 4 * stoi(asmParams[2].substr(1));
+            o << "    leaq " << -offset << "(%rbp), %rax\n";
+        } else {
+            o << "    movslq " << asmParams[2] << ", %rax\n";
+            o << "    leaq -" << asmParams[1] << "(%rbp, %rax, 4), %rax\n";
+        }
+        o << "    movq %rax, " << quad(asmParams[0]) << "\n";
         break;
     }
     case incr:
         // incr: params[0] = var
         if (t == VarType::FLOAT) {
-            move(o, t, params[0], "%xmm1");
-            move(o, t, params[1], "%xmm0"); // params[1] = label for float 1.0
+            move(o, t, asmParams[0], "%xmm1");
+            move(o, t, asmParams[1], "%xmm0"); // params[1] = label for float 1.0
             o << "    addss	%xmm1, %xmm0\n";
-            o << "    movss %xmm0, " << params[0] << "\n";
+            o << "    movss %xmm0, " << asmParams[0] << "\n";
             break;
         }
 
-        o << "    movl " << params[0] << ", %eax\n";
+        o << "    movl " << asmParams[0] << ", %eax\n";
         o << "    addl $1, %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case decr:
         // decr: params[0] = var
         if (t == VarType::FLOAT) {
-            move(o, t, params[0], "%xmm0");
-            move(o, t, params[1], "%xmm1"); // params[1] = label for float 1.0
+            move(o, t, asmParams[0], "%xmm0");
+            move(o, t, asmParams[1], "%xmm1"); // params[1] = label for float 1.0
             o << "    subss	%xmm1, %xmm0\n";
-            o << "    movss %xmm0, " << params[0] << "\n";
+            o << "    movss %xmm0, " << asmParams[0] << "\n";
             break;
         }
 
-        o << "    movl " << params[0] << ", %eax\n";
+        o << "    movl " << asmParams[0] << ", %eax\n";
         o << "    subl $1, %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case cmp_eq:
         // cmp_eq: params[0] = dest, params[1] = gauche, params[2] = droite
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm0");
-            o << "    ucomiss " << params[2] << ", %xmm0\n";
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    ucomiss " << asmParams[2] << ", %xmm0\n";
             o << "    setnp %al\n";
             o << "    movl	$0, %edx\n";
-            move(o, t, params[1], "%xmm0");
-            o << "    ucomiss " << params[2] << ", %xmm0\n";
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    ucomiss " << asmParams[2] << ", %xmm0\n";
             o << "    cmovne %edx, %eax\n";
             o << "    movzbl %al, %eax\n";
-            o << "    movl %eax, " << params[0] << "\n";
+            o << "    movl %eax, " << asmParams[0] << "\n";
+            break;
+        }
+
+        if (t == VarType::ADDRESS) {
+            compareAddresses(o, "sete", asmParams);
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    cmpl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    cmpl " << asmParams[2] << ", %eax\n";
         o << "    sete %al\n";
         o << "    movzbl %al, %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
     case cmp_lt:
         // cmp_lt: params[0] = dest, params[1] = gauche, params[2] = droite
         if (t == VarType::FLOAT) {
-            move(o, t, params[2], "%xmm0");
-            o << "    comiss " << params[1] << ", %xmm0\n";
+            move(o, t, asmParams[2], "%xmm0");
+            o << "    comiss " << asmParams[1] << ", %xmm0\n";
             o << "    seta %al\n";
             o << "    movzbl %al, %eax\n";
-            o << "    movl %eax, " << params[0] << "\n";
+            o << "    movl %eax, " << asmParams[0] << "\n";
+            break;
+        }
+
+        if (t == VarType::ADDRESS) {
+            compareAddresses(o, "setl", asmParams);
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    cmpl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    cmpl " << asmParams[2] << ", %eax\n";
         o << "    setl %al\n";
         o << "    movzbl %al, %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
     case cmp_le:
         // cmp_le: params[0] = dest, params[1] = gauche, params[2] = droite
         if (t == VarType::FLOAT) {
-            move(o, t, params[2], "%xmm0");
-            o << "    comiss " << params[1] << ", %xmm0\n";
+            move(o, t, asmParams[2], "%xmm0");
+            o << "    comiss " << asmParams[1] << ", %xmm0\n";
             o << "    setnb %al\n";
             o << "    movzbl %al, %eax\n";
-            o << "    movl %eax, " << params[0] << "\n";
+            o << "    movl %eax, " << asmParams[0] << "\n";
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    cmpl " << params[2] << ", %eax\n";
+        if (t == VarType::ADDRESS) {
+            compareAddresses(o, "setle", asmParams);
+            break;
+        }
+
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    cmpl " << asmParams[2] << ", %eax\n";
         o << "    setle %al\n";
         o << "    movzbl %al, %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case cmp_ne:
         // cmp_ne: params[0] = dest, params[1] = gauche, params[2] = droite
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm0");
-            o << "    ucomiss " << params[2] << ", %xmm0\n";
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    ucomiss " << asmParams[2] << ", %xmm0\n";
             o << "    setp %al\n";
             o << "    movl	$1, %edx\n";
-            move(o, t, params[1], "%xmm0");
-            o << "    ucomiss " << params[2] << ", %xmm0\n";
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    ucomiss " << asmParams[2] << ", %xmm0\n";
             o << "    cmovne %edx, %eax\n";
             o << "    movzbl %al, %eax\n";
-            o << "    movl %eax, " << params[0] << "\n";
+            o << "    movl %eax, " << asmParams[0] << "\n";
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    cmpl " << params[2] << ", %eax\n";
+        if (t == VarType::ADDRESS) {
+            compareAddresses(o, "setne", asmParams);
+            break;
+        }
+
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    cmpl " << asmParams[2] << ", %eax\n";
         o << "    setne %al\n";
         o << "    movzbl %al, %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case cmp_gt:
         // cmp_gt: params[0] = dest, params[1] = gauche, params[2] = droite
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm0");
-            o << "    comiss " << params[2] << ", %xmm0\n";
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    comiss " << asmParams[2] << ", %xmm0\n";
             o << "    seta %al\n";
             o << "    movzbl %al, %eax\n";
-            o << "    movl %eax, " << params[0] << "\n";
+            o << "    movl %eax, " << asmParams[0] << "\n";
+            break;
+        }
+
+        if (t == VarType::ADDRESS) {
+            compareAddresses(o, "setg", asmParams);
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    cmpl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    cmpl " << asmParams[2] << ", %eax\n";
         o << "    setg %al\n";
         o << "    movzbl %al, %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case cmp_ge:
         // cmp_ge: params[0] = dest, params[1] = gauche, params[2] = droite
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm0");
-            o << "    comiss " << params[2] << ", %xmm0\n";
+            move(o, t, asmParams[1], "%xmm0");
+            o << "    comiss " << asmParams[2] << ", %xmm0\n";
             o << "    setnb %al\n";
             o << "    movzbl %al, %eax\n";
-            o << "    movl %eax, " << params[0] << "\n";
+            o << "    movl %eax, " << asmParams[0] << "\n";
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    cmpl " << params[2] << ", %eax\n";
+        if (t == VarType::ADDRESS) {
+            compareAddresses(o, "setge", asmParams);
+            break;
+        }
+
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    cmpl " << asmParams[2] << ", %eax\n";
         o << "    setge %al\n";
         o << "    movzbl %al, %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case bit_and:
         // bit_and: params[0] = dest, params[1] = gauche, params[2] = droite
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    andl " << params[2] << ", %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    andl " << asmParams[2] << ", %eax\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case bit_or:
         // bit_or: params[0] = dest, params[1] = gauche, params[2] = droite
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    orl " << params[2] << ", %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    orl " << asmParams[2] << ", %eax\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case bit_xor:
         // bit_xor: params[0] = dest, params[1] = gauche, params[2] = droite
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    xorl " << params[2] << ", %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
+        o << "    xorl " << asmParams[2] << ", %eax\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case unary_minus:
         // unary_minus: params[0] = dest, params[1] = source
         if (t == VarType::FLOAT) {
-            move(o, t, params[1], "%xmm0");
-            move(o, t, params[2], "%xmm1"); // params[2] = float data for unary
+            move(o, t, asmParams[1], "%xmm0");
+            move(o, t, asmParams[2], "%xmm1"); // params[2] = float data for unary
             o << "    xorps %xmm1, %xmm0\n"; 
-            move(o, t, "%xmm0", params[0]);
+            move(o, t, "%xmm0", asmParams[0]);
             break;
         }
 
-        o << "    movl " << params[1] << ", %eax\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
         o << "    negl %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case not_op:
         // not_op: params[0] = dest, params[1] = source
-        o << "    movl " << params[1] << ", %eax\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
         o << "    cmpl $0, %eax\n";
         o << "    sete %al\n";
         o << "    movzbl %al, %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
     case log_and: {
@@ -445,11 +595,11 @@ void IRInstr::gen_asm(std::ostream &o)
         std::string labelFalse = ".Lfalse" + std::to_string(currentLabel);
         std::string labelEnd = ".Lend" + std::to_string(currentLabel);
 
-        o << "    movl " << params[1] << ", %eax\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
         o << "    testl %eax, %eax\n";
         o << "    jz " << labelFalse << "\n";
 
-        o << "    movl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[2] << ", %eax\n";
         o << "    testl %eax, %eax\n";
         o << "    jz " << labelFalse << "\n";
 
@@ -460,7 +610,7 @@ void IRInstr::gen_asm(std::ostream &o)
         o << "    movl $0, %eax\n";
 
         o << labelEnd << ":\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
     }
     case log_or: {
@@ -468,11 +618,11 @@ void IRInstr::gen_asm(std::ostream &o)
         std::string labelTrue = ".Ltrue" + std::to_string(currentLabel);
         std::string labelEnd = ".Lend" + std::to_string(currentLabel);
 
-        o << "    movl " << params[1] << ", %eax\n";
+        o << "    movl " << asmParams[1] << ", %eax\n";
         o << "    testl %eax, %eax\n";
         o << "    jnz " << labelTrue << "\n";
 
-        o << "    movl " << params[2] << ", %eax\n";
+        o << "    movl " << asmParams[2] << ", %eax\n";
         o << "    testl %eax, %eax\n";
         o << "    jnz " << labelTrue << "\n";
 
@@ -483,159 +633,287 @@ void IRInstr::gen_asm(std::ostream &o)
         o << "    movl $1, %eax\n";
 
         o << labelEnd << ":\n";
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
     }
 
     case intToFloat:
         // intToFloat: params[0] = destination, params[1] = source
         o << "    pxor %xmm0, %xmm0\n"; // Clear xmm0
-        o << "    cvtsi2ssl " << params[1] << ", %xmm0\n"; // Convert int to double
-        move(o, t, "%xmm0", params[0]);
+        if (isImmediate(asmParams[1])) {
+            // cvtsi2ss ne prend pas de constante
+            o << "    movl " << asmParams[1] << ", %eax\n";
+            asmParams[1] = "%eax";
+        }
+        o << "    cvtsi2ssl " << asmParams[1] << ", %xmm0\n"; // Convert int to double
+        move(o, t, "%xmm0", asmParams[0]);
         break;
 
     case floatToInt:
         // floatToInt: params[0] = destination, params[1] = source
-        o << "    cvttss2sil " << params[1] << ", %eax\n"; // Convert double to int
-        o << "    movl %eax, " << params[0] << "\n";
+        o << "    cvttss2sil " << asmParams[1] << ", %eax\n"; // Convert double to int
+        o << "    movl %eax, " << asmParams[0] << "\n";
         break;
 
-    case rmem:
-        // rmem: params[0] = destination, params[1] = adresse
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    movl (%eax), %eax\n";
-        o << "    movl %eax, " << params[0] << "\n";
+    case rmem: {
+        // rmem: params[0] = destination, params[1] = adresse (64 bits), params[2] = déplacement en octets
+        std::string element = (params.size() > 2 ? params[2].name : "") + "(" + loadAddress(o, asmParams[1]) + ")";
+        if (t == VarType::FLOAT) {
+            move(o, t, element, isRegister(asmParams[0]) ? asmParams[0] : "%xmm0");
+            if (!isRegister(asmParams[0]))
+                move(o, t, "%xmm0", asmParams[0]);
+            break;
+        }
+
+        if (isRegister(asmParams[0])) {
+            o << "    movl " << element << ", " << asmParams[0] << "\n";
+            break;
+        }
+        o << "    movl " << element << ", %edx\n";
+        o << "    movl %edx, " << asmParams[0] << "\n";
         break;
+    }
 
-    case wmem:
-        // wmem: params[0] = adresse, params[1] = valeur
-        o << "    movl " << params[1] << ", %eax\n";
-        o << "    movl " << params[0] << ", %edx\n";
-        o << "    movl %eax, (%edx)\n";
+    case wmem: {
+        // wmem: params[0] = adresse (64 bits), params[1] = valeur, params[2] = déplacement en octets
+        std::string element = (params.size() > 2 ? params[2].name : "") + "(" + loadAddress(o, asmParams[0]) + ")";
+        if (t == VarType::FLOAT) {
+            if (!isRegister(asmParams[1])) {
+                move(o, t, asmParams[1], "%xmm0");
+                asmParams[1] = "%xmm0";
+            }
+            move(o, t, asmParams[1], element);
+            break;
+        }
+
+        if (!isRegister(asmParams[1]) && !isImmediate(asmParams[1])) {
+            o << "    movl " << asmParams[1] << ", %edx\n";
+            asmParams[1] = "%edx";
+        }
+        o << "    movl " << asmParams[1] << ", " << element << "\n";
         break;
+    }
 
     case call:
         // call: params[0] = label
-        o << "    call " << params[0] << "\n";
+        o << "    call " << asmParams[0] << "\n";
         break;
 
     case jmp:
         // jmp: params[0] = label
-        o << "    jmp " << params[0] << "\n";
+        o << "    jmp " << asmParams[0] << "\n";
         break;
 
-    default:
-        o << "    # Opération IR non supportée\n";
+    case select: {
+        // select: params[0] = dest, params[1] = condition, params[2] = valeur si vraie, params[3] = valeur sinon
+        // Pas de cmov sur les xmm: un float passe par ses bits dans %eax et %ecx
+        if (t == VarType::ADDRESS) {
+            o << "    movq " << quad(asmParams[3]) << ", %rax\n";
+            o << "    movq " << quad(asmParams[2]) << ", %rcx\n";
+        } else {
+            bool inXmm = asmParams[3].rfind("%xmm", 0) == 0;
+            o << (inXmm ? "    movd " : "    movl ") << asmParams[3] << ", %eax\n";
+            inXmm = asmParams[2].rfind("%xmm", 0) == 0;
+            o << (inXmm ? "    movd " : "    movl ") << asmParams[2] << ", %ecx\n";
+        }
+        std::string cc = "ne";
+        if (fused_cmp != nullptr) {
+            // La comparaison qui précède donne directement les drapeaux du cmov
+            std::vector<std::string> cmpParams = fused_cmp->lower_params();
+            if (fused_cmp->t == VarType::ADDRESS) {
+                o << "    movq " << quad(cmpParams[1]) << ", %rdx\n";
+                o << "    cmpq " << quad(cmpParams[2]) << ", %rdx\n";
+            } else {
+                std::string left = cmpParams[1];
+                if (!isRegister(left)) {
+                    o << "    movl " << left << ", %edx\n";
+                    left = "%edx";
+                }
+                o << "    cmpl " << cmpParams[2] << ", " << left << "\n";
+            }
+            cc = conditionCode(fused_cmp->op);
+        } else {
+            std::string test = asmParams[1];
+            if (isImmediate(test)) {
+                o << "    movl " << test << ", %edx\n";
+                test = "%edx";
+            }
+            if (isRegister(test))
+                o << "    testl " << test << ", " << test << "\n";
+            else
+                o << "    cmpl $0, " << test << "\n";
+        }
+        if (t == VarType::ADDRESS) {
+            o << "    cmov" << cc << " %rcx, %rax\n";
+            o << "    movq %rax, " << quad(asmParams[0]) << "\n";
+            break;
+        }
+        o << "    cmov" << cc << " %ecx, %eax\n";
+        o << (asmParams[0].rfind("%xmm", 0) == 0 ? "    movd " : "    movl ") << "%eax, " << asmParams[0] << "\n";
         break;
     }
+
+    default:
+        // Une opération que les passes auraient dû faire disparaître (un phi hors SSA...): le code serait faux
+        FeedbackOutputFormat::showFeedbackOutput("error", "internal error: unsupported IR operation " + to_string(op) + " in " + bb->label);
+        exit(1);
+    }
 }
 
 //* ---------------------- BasicBlock ---------------------- */
 
-void BasicBlock::gen_asm(std::ostream &o)
+// Saut vers ifTrue si cc est vrai, vers ifFalse sinon; le bloc suivant (next) est atteint sans saut
+void branch(std::ostream &o, std::string cc, BasicBlock *ifTrue, BasicBlock *ifFalse, BasicBlock *next)
 {
-    for (auto instr : instrs)
+    if (ifTrue == next)
     {
-        instr->gen_asm(o);
+        o << "    j" << negated(cc) << " " << ifFalse->label << "\n";
+        return;
+    }
+    o << "    j" << cc << " " << ifTrue->label << "\n";
+    if (ifFalse != next)
+        o << "    jmp " << ifFalse->label << "\n";
+}
+
+void BasicBlock::gen_asm(std::ostream &o, BasicBlock *next)
+{
+    for (size_t i = 0; i < instrs.size(); i++)
+    {
+        // Une comparaison fusionnée est émise avec le branchement ou le select qui la suit
+        bool fused = instrs[i] == fused_test || (i + 1 < instrs.size() && instrs[i + 1]->fused_cmp == instrs[i]);
+        if (!fused && !instrs[i]->tail_call)
+            instrs[i]->gen_asm(o);
     }
 
     if (!test_var_name.empty() && exit_true != nullptr && exit_false != nullptr)
     {
+        if (fused_test != nullptr)
+        {
+            // La comparaison donne directement les drapeaux du saut
+            std::vector<std::string> asmParams = fused_test->lower_params();
+            if (fused_test->t == VarType::ADDRESS) {
+                o << "    movq " << quad(asmParams[1]) << ", %rax\n";
+                o << "    cmpq " << quad(asmParams[2]) << ", %rax\n";
+            } else {
+                std::string left = asmParams[1];
+                if (!isRegister(left)) {
+                    o << "    movl " << left << ", %eax\n";
+                    left = "%eax";
+                }
+                o << "    cmpl " << asmParams[2] << ", " << left << "\n";
+            }
+            branch(o, conditionCode(fused_test->op), exit_true, exit_false, next);
+            return;
+        }
+
         // Conditional jump based on test_var_name
-        o << "    movl " << test_var_register << ", %eax\n";
-        o << "    cmpl $0, %eax\n";
-        o << "    je " << exit_false->label << "\n";
-        o << "    jmp " << exit_true->label << "\n";
+        std::string test = cfg->IR_reg_to_asm(test_var);
+        if (test.rfind("%xmm", 0) == 0 || isImmediate(test)) {
+            o << (test.rfind("%xmm", 0) == 0 ? "    movd " : "    movl ") << test << ", %eax\n"; // un float est testé sur ses bits, comme depuis la mémoire
+            o << "    cmpl $0, %eax\n";
+        } else if (isRegister(test)) {
+            o << "    testl " << test << ", " << test << "\n";
+        } else {
+            o << "    cmpl $0, " << test << "\n";
+        }
+        branch(o, "ne", exit_true, exit_false, next);
     }
     else if (exit_true != nullptr)
     {
-        // Unconditional jump to exit_true
-        if (exit_true->label != cfg->get_epilogue_label())
-        { // Already have jmp to end with return statement
+        // Unconditional jump to exit_true, unless it comes right after
+        if (exit_true != next)
             o << "    jmp " << exit_true->label << "\n";
-        }
     }
     else
-    { // si on est à la fin de cfg (fin de function)
-        cfg->gen_asm_epilogue(o);
+    { // si on est à la fin de cfg (fin de function), ou sur un appel terminal
+        bool tail = !instrs.empty() && instrs.back()->tail_call;
+        cfg->gen_asm_epilogue(o, tail ? instrs.back()->params[0].name : "");
     }
 }
 
 //* ---------------------- CFG ---------------------- */
 
-void BasicBlock::add_IRInstr(IRInstr::Operation op, VarType t, std::vector<std::string> params)
+void CFG::gen_asm(std::ostream &o)
 {
-    // General case
-    bool needFindAdd = (op == IRInstr::Operation::call || op == IRInstr::Operation::jmp);
-    std::string p0 = needFindAdd ? params[0] : cfg->IR_reg_to_asm(params[0]);
-    std::string p1 = params.size() >= 2 ? cfg->IR_reg_to_asm(params[1]) : "";
-    std::string p2 = params.size() >= 3 ? cfg->IR_reg_to_asm(params[2]) : "";
-
-    // Tableau case
-    if (op == IRInstr::Operation::copyTblx || op == IRInstr::Operation::addTblx || op == IRInstr::Operation::subTblx ||
-        op == IRInstr::Operation::mulTblx || op == IRInstr::Operation::divTblx || op == IRInstr::Operation::modTblx)
-    {
-        Symbol *p = cfg->currentScope->findVariable(params[0]);
-        p0 = to_string(p->offset);
-    }
+    allocate_stack_slots();
+    find_fused_tests();
 
-    if (op == IRInstr::Operation::getTblx)
+    o << ".global " << ast->getName() << "\n";
+    if (memo_size > 0)
     {
-        Symbol *p = cfg->currentScope->findVariable(params[1]);
-        p1 = to_string(p->offset);
+        gen_asm_memo(o);
     }
-
-    std::vector<std::string> paramsRealAddr = {p0, p1, p2};
-
-    if (op == IRInstr::Operation::copy && CFG::isRegConstant(p1)) {
-        op = IRInstr::Operation::ldconst;
-    }
-
-    IRInstr *instr = new IRInstr(this, op, t, paramsRealAddr);
-    instrs.push_back(instr);
-}
-
-void CFG::gen_asm(std::ostream &o)
-{
-    o << ".global " << ast->getName() << "\n";
     for (size_t i = 0; i < bbs.size(); i++)
     {
+        // En-tête de boucle: aligné sur 16 octets si cela coûte au plus 10 octets de remplissage
+        if (bbs[i]->aligned)
+            o << "    .p2align 4,,10\n";
         o << bbs[i]->label << ":\n";
         if (i == 0)
         {
             gen_asm_prologue(o);
         }
-        bbs[i]->gen_asm(o);
+        bbs[i]->gen_asm(o, i + 1 < bbs.size() ? bbs[i + 1] : nullptr);
     }
 }
 
-std::string CFG::IR_reg_to_asm(std::string &reg, bool ignoreCst)
+// Point d'entrée d'une fonction mémoïsée: un argument dans la table (comparaison non signée, qui écarte
+// aussi les négatifs) déjà calculé rend sa valeur, sinon le corps est appelé et son résultat rangé
+void CFG::gen_asm_memo(std::ostream &o)
 {
-    // Utilise la table des symboles pour obtenir l'index et calcule l'offset mémoire.
-    Symbol *p = currentScope->findVariable(reg);
-    if (p != nullptr)
-    {
-        if (p->isConstant() & !ignoreCst) {
-            if (p->getType() != VarType::FLOAT) {
-                return "$" + p->getCstValue();
-            }
+    std::string name = ast->getName();
+    std::string miss = ".Lmemo_" + name;
+    o << name << ":\n";
+    o << "    cmpl $" << memo_size << ", %edi\n";
+    o << "    jae " << bbs[0]->label << "\n";
+    o << "    movl %edi, %eax\n";
+    o << "    leaq " << name << ".known(%rip), %rdx\n";
+    o << "    cmpb $0, (%rdx,%rax)\n";
+    o << "    je " << miss << "\n";
+    o << "    leaq " << name << ".memo(%rip), %rdx\n";
+    o << "    movl (%rdx,%rax,4), %eax\n";
+    o << "    ret\n";
+    o << miss << ":\n";
+    o << "    pushq %rdi\n"; // garde l'argument, et aligne la pile sur 16 octets pour l'appel
+    o << "    call " << bbs[0]->label << "\n";
+    o << "    popq %rcx\n";
+    o << "    movl %ecx, %ecx\n";
+    o << "    leaq " << name << ".memo(%rip), %rdx\n";
+    o << "    movl %eax, (%rdx,%rcx,4)\n";
+    o << "    leaq " << name << ".known(%rip), %rdx\n";
+    o << "    movb $1, (%rdx,%rcx)\n";
+    o << "    ret\n";
+    o << "    .bss\n";
+    o << "    .p2align 2\n";
+    o << name << ".memo:\n";
+    o << "    .zero " << 4 * memo_size << "\n";
+    o << name << ".known:\n";
+    o << "    .zero " << memo_size << "\n";
+    o << "    .text\n";
+}
 
-            std::string label = rodm->putFloatIfNotExists(std::stof(p->getCstValue()));
-            return label + "(%rip)";
+std::string CFG::IR_reg_to_asm(const IROperand &reg)
+{
+    switch (reg.kind)
+    {
+    case IROperand::vreg:
+        if (!vregs[reg.id].reg.empty()) {
+            return vregs[reg.id].reg;
         }
-
-        if (p->scopeType == GLOBAL)
-        {
-            return reg + "(%rip)";
+        return "-" + to_string(vregs[reg.id].offset) + "(%rbp)";
+    case IROperand::global:
+        return reg.name + "(%rip)";
+    case IROperand::imm:
+        if (!Symbol::isFloatingType(reg.type)) {
+            return "$" + reg.name;
         }
-        return "-" + to_string(p->offset) + "(%rbp)";
-    }
-
-    if (!reg.empty() && reg[0] == '.' && reg[1] == 'L') // Label
-    {
-        return reg + "(%rip)";
+        return rodm->putFloatIfNotExists(std::stof(reg.name)) + "(%rip)";
+    case IROperand::preg:
+    case IROperand::label:
+        return reg.name;
+    default:
+        return "";
     }
-    return reg;
 }
 
 void CFG::gen_asm_prologue(std::ostream &o)
@@ -643,19 +921,30 @@ void CFG::gen_asm_prologue(std::ostream &o)
     o << "    pushq %rbp\n";
     o << "    movq %rsp, %rbp\n";
     o << "    subq $" << getStackSize() << ", %rsp\n";
+
+    // Callee-saved registers used by the register allocator: "%r12d" is saved as %r12
+    for (auto &[reg, slot] : saved_regs)
+    {
+        o << "    movq " << reg.substr(0, reg.size() - 1) << ", -" << vregs[slot].offset << "(%rbp)\n";
+    }
 }
 
-void CFG::gen_asm_epilogue(std::ostream &o)
+void CFG::gen_asm_epilogue(std::ostream &o, std::string tailCallee)
 {
+    for (auto &[reg, slot] : saved_regs)
+    {
+        o << "    movq -" << vregs[slot].offset << "(%rbp), " << reg.substr(0, reg.size() - 1) << "\n";
+    }
     o << "    leave\n";
+    if (!tailCallee.empty())
+    {
+        // Appel terminal: la fonction appelée revient directement à notre appelant
+        o << "    jmp " << tailCallee << "\n";
+        return;
+    }
     o << "    ret\n";
 }
 
-bool CFG::isRegConstant(std::string& reg)
-{
-    return reg[0] == '$';
-}
-
 //* ---------------------- GlobalVarManager ---------------------- */
 void GVM::gen_asm(std::ostream &o)
 {
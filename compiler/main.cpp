@@ -9,6 +9,7 @@
 #include "generated/ifccBaseVisitor.h"
 
 #include "CodeGenVisitor.h"
+#include "PassManager.h"
 
 using namespace antlr4;
 using namespace std;
@@ -26,14 +27,28 @@ void predefineFunctions() {
 
 int main(int argn, const char **argv)
 {
-    if(argn != 2) {
-        cerr << "usage: ifcc path/to/file.c" << endl;
+    // ifcc [-O0|-O1|-O2] [-fno-<pass>] [-ftime-report] [-funroll-factor=N] [-fmemoize] path/to/file.c
+    OptimizationOptions options;
+    string inputName;
+    for (int i = 1; i < argn; i++) {
+        string arg = argv[i];
+        if (options.parse(arg)) {
+            continue;
+        }
+        if (arg[0] == '-' || !inputName.empty()) {
+            inputName.clear();
+            break;
+        }
+        inputName = arg;
+    }
+    if(inputName.empty()) {
+        cerr << "usage: ifcc [-O0|-O1|-O2] [-fno-<pass>] [-ftime-report] [-funroll-factor=N] [-fmemoize] path/to/file.c" << endl;
         exit(1);
     }
 
-    ifstream inputFile(argv[1]);
+    ifstream inputFile(inputName);
     if(!inputFile.good()) {
-        cerr << "error: cannot read file: " << argv[1] << endl;
+        cerr << "error: cannot read file: " << inputName << endl;
         exit(1);
     }
     
@@ -58,6 +73,12 @@ int main(int argn, const char **argv)
     // Le visiteur construit le CFG/IR et, en fin de visite, génère le code assembleur sur stdout.
     CodeGenVisitor v;
     v.visit(tree);
+
+    // Les passes d'optimisation transforment l'IR entre la visite et la génération de code
+    PassManager* passManager = PassManager::standardPipeline(options);
+    passManager->run(v.getCfgs(), cerr);
+    delete passManager;
+
     v.gen_asm(cout);
 
     return 0;
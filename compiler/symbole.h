@@ -13,6 +13,8 @@ enum VarType {
     INT_PTR, //TODO: j'ai ajouté ça pour les tableaux, mais j'ai rien fait, il faut que qui est responsable pour le pointer le fasse
     CHAR_PTR,
     FLOAT_PTR,
+
+    ADDRESS, // adresse d'un élément de tableau, sur 64 bits: créée par l'optimiseur (StrengthReduction.cpp)
 };
 
 enum ScopeType {
@@ -27,6 +29,8 @@ class Symbol
         VarType type;
         int offset;
         ScopeType scopeType;
+        int size = 1; // number of elements of an array
+        int vreg = -1; // virtual register of the CFG, assigned when the IR first refers to the symbol
 
         // Constructors
 
@@ -92,6 +96,7 @@ class Symbol
                 case VarType::INT_PTR: return "int*";
                 case VarType::CHAR_PTR: return "char*";
                 case VarType::FLOAT_PTR: return "float*";
+                case VarType::ADDRESS: return "address";
                 default: return "unknown";
             }
         }
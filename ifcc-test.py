@@ -82,12 +82,20 @@ argparser.add_argument('-d','--debug',action="count",default=0,
 argparser.add_argument('-S',action = "store_true", help='single-file mode: compile from C to assembly, but do not assemble')
 argparser.add_argument('-c',action = "store_true", help='single-file mode: compile/assemble to machine code, but do not link')
 argparser.add_argument('-o','--output',metavar = 'OUTPUTNAME', help='single-file mode: write output to that file')
+argparser.add_argument('--ifcc-opts',metavar = 'OPTIONS', action='append',
+                       help='options passed to ifcc, e.g. --ifcc-opts="-O2 -ftime-report".'
+                       +' In multiple-files mode, can be given several times: each test-case is compiled and checked once per option set'
+                       +' (by default: -O0, -O1 and -O2, so that the optimizations are tested too)')
 
 args=argparser.parse_args()
 
 if args.debug >=2:
     print('debug: command-line arguments '+str(args))
 
+# single-file mode uses the last option set given, multiple-files mode all of them
+ifcc_opts_list=args.ifcc_opts if args.ifcc_opts else ['-O0','-O1','-O2']
+args.ifcc_opts=args.ifcc_opts[-1] if args.ifcc_opts else ''
+
 orig_cwd=os.getcwd()
 if "ifcc-test-output" in orig_cwd:
     print('error: cannot run ifcc-test.py from within its own output directory')
@@ -140,9 +148,9 @@ if args.S or args.c or args.output:
         if args.output[-2:] != ".s":
             print("error: output file name must end with '.s'")
             exit(1)
-        ifccstatus=run_command(f'"{pld_base_dir}/compiler/ifcc" {inputfilename} > {args.output}')
+        ifccstatus=run_command(f'"{pld_base_dir}/compiler/ifcc" {args.ifcc_opts} {inputfilename} > {args.output}')
         if ifccstatus: # let's show error messages on screen
-            exit(run_command(f'"{pld_base_dir}/compiler/ifcc" {inputfilename}',toscreen=True))
+            exit(run_command(f'"{pld_base_dir}/compiler/ifcc" {args.ifcc_opts} {inputfilename}',toscreen=True))
         else:
             exit(0)
 
@@ -151,9 +159,9 @@ if args.S or args.c or args.output:
             print("error: output file name must end with '.o'")
             exit(1)
         asmname=args.output[:-2]+".s"
-        ifccstatus=run_command(f'"{pld_base_dir}/compiler/ifcc" {inputfilename} > {asmname}')
+        ifccstatus=run_command(f'"{pld_base_dir}/compiler/ifcc" {args.ifcc_opts} {inputfilename} > {asmname}')
         if ifccstatus: # let's show error messages on screen
-            exit(run_command(f'"{pld_base_dir}/compiler/ifcc" {inputfilename}',toscreen=True))
+            exit(run_command(f'"{pld_base_dir}/compiler/ifcc" {args.ifcc_opts} {inputfilename}',toscreen=True))
         exit(run_command(f'gcc -c -o {args.output} {asmname}',toscreen=True))
         
     else: # produce an executable
@@ -161,9 +169,9 @@ if args.S or args.c or args.output:
             print("error: incorrect name for an executable: "+args.output)
             exit(1)
         asmname=args.output+".s"
-        ifccstatus=run_command(f'"{pld_base_dir}/compiler/ifcc" {inputfilename} > {asmname}')
+        ifccstatus=run_command(f'"{pld_base_dir}/compiler/ifcc" {args.ifcc_opts} {inputfilename} > {asmname}')
         if ifccstatus:
-            exit(run_command(f'"{pld_base_dir}/compiler/ifcc" {inputfilename}', toscreen=True))
+            exit(run_command(f'"{pld_base_dir}/compiler/ifcc" {args.ifcc_opts} {inputfilename}', toscreen=True))
         exit(run_command(f'gcc -o {args.output} {asmname}'))
 
     # we should never end up here
@@ -301,59 +309,62 @@ for jobname in jobs:
             dumpfile("gcc-execute.txt")
 
             
-    ## IFCC compiler
-    ifccstatus=run_command(f'"{pld_base_dir}/compiler/ifcc" input.c > asm-ifcc.s', 'ifcc-compile.txt')
+    ## IFCC compiler, once per option set: the files of each run are suffixed by its options
+    for ifcc_opts in ifcc_opts_list:
+        suffix=ifcc_opts.replace(' ','') if len(ifcc_opts_list) > 1 else ''
+        label=f' ({ifcc_opts})' if len(ifcc_opts_list) > 1 else ''
+        ifccstatus=run_command(f'"{pld_base_dir}/compiler/ifcc" {ifcc_opts} input.c > asm-ifcc{suffix}.s', f'ifcc-compile{suffix}.txt')
     
-    if gccstatus != 0 and ifccstatus != 0:
-        ## ifcc correctly rejects invalid program -> test-case ok
-        print_ok("TEST OK")
-        continue
-    elif gccstatus != 0 and ifccstatus == 0:
-        ## ifcc wrongly accepts invalid program -> error
-        print_fail("TEST FAIL (your compiler accepts an invalid program)")
-        all_ok=False
-        continue
-    elif gccstatus == 0 and ifccstatus != 0:
-        ## ifcc wrongly rejects valid program -> error
-        print_fail("TEST FAIL (your compiler rejects a valid program)")
-        all_ok=False
-        if args.verbose:
-            dumpfile("asm-ifcc.s")       # stdout of ifcc
-            dumpfile("ifcc-compile.txt") # stderr of ifcc
-        continue
-    else:
-        ## ifcc accepts to compile valid program -> let's link it
-        ldstatus=run_command("gcc -o exe-ifcc asm-ifcc.s", "ifcc-link.txt")
-        if ldstatus:
-            print_fail("TEST FAIL (your compiler produces incorrect assembly)")
+        if gccstatus != 0 and ifccstatus != 0:
+            ## ifcc correctly rejects invalid program -> test-case ok
+            print_ok("TEST OK"+label)
+            continue
+        elif gccstatus != 0 and ifccstatus == 0:
+            ## ifcc wrongly accepts invalid program -> error
+            print_fail("TEST FAIL (your compiler accepts an invalid program)"+label)
+            all_ok=False
+            continue
+        elif gccstatus == 0 and ifccstatus != 0:
+            ## ifcc wrongly rejects valid program -> error
+            print_fail("TEST FAIL (your compiler rejects a valid program)"+label)
             all_ok=False
             if args.verbose:
-                dumpfile("asm-ifcc.s")
-                dumpfile("ifcc-link.txt")
+                dumpfile(f"asm-ifcc{suffix}.s")       # stdout of ifcc
+                dumpfile(f"ifcc-compile{suffix}.txt") # stderr of ifcc
             continue
-
-    ## both compilers  did produce an  executable, so now we  run both
-    ## these executables and compare the results.
+        else:
+            ## ifcc accepts to compile valid program -> let's link it
+            ldstatus=run_command(f'gcc -o exe-ifcc{suffix} asm-ifcc{suffix}.s', f'ifcc-link{suffix}.txt')
+            if ldstatus:
+                print_fail("TEST FAIL (your compiler produces incorrect assembly)"+label)
+                all_ok=False
+                if args.verbose:
+                    dumpfile(f"asm-ifcc{suffix}.s")
+                    dumpfile(f"ifcc-link{suffix}.txt")
+                continue
+
+        ## both compilers  did produce an  executable, so now we  run both
+        ## these executables and compare the results.
         
-    if "getchar" in inputfilename:
-        exe_command = "echo -n 'A' | ./exe-ifcc"
-    else:
-        exe_command = "./exe-ifcc"
-    run_command(exe_command, "ifcc-execute.txt")
+        if "getchar" in inputfilename:
+            exe_command = f"echo -n 'A' | ./exe-ifcc{suffix}"
+        else:
+            exe_command = f"./exe-ifcc{suffix}"
+        run_command(exe_command, f"ifcc-execute{suffix}.txt")
 
-    if open("gcc-execute.txt").read() != open("ifcc-execute.txt").read() :
-        print_fail("TEST FAIL (different results at execution)")
-        all_ok=False
+        if open("gcc-execute.txt").read() != open(f"ifcc-execute{suffix}.txt").read() :
+            print_fail("TEST FAIL (different results at execution)"+label)
+            all_ok=False
 
-        if args.verbose:
-            print("GCC:")
-            dumpfile("gcc-execute.txt")
-            print("you:")
-            dumpfile("ifcc-execute.txt")
-        continue
+            if args.verbose:
+                print("GCC:")
+                dumpfile("gcc-execute.txt")
+                print("you:")
+                dumpfile(f"ifcc-execute{suffix}.txt")
+            continue
 
-    ## last but not least
-    print_ok("TEST OK")
+        ## last but not least
+        print_ok("TEST OK"+label)
 
 if not (all_ok or args.verbose):
     print("Some test-cases failed. Run ifcc-test.py with option '--verbose' for more detailed feedback.")
@@ -0,0 +1,11 @@
+int main() {
+    int x = 0;
+    int y = 1;
+    if (y) {
+        while (x < 3) {
+            x++;
+        }
+    }
+    x = x + 10;
+    return x;
+}
@@ -0,0 +1,18 @@
+int find(int n) {
+    int i = 0;
+    int s = 0;
+    while (i < 100) {
+        s = s + i;
+        if (s > n) {
+            return i;
+        }
+        i++;
+    }
+    return 0 - 1;
+}
+
+int main() {
+    int a = find(10);
+    int b = find(50);
+    return a * 10 + b;
+}
@@ -0,0 +1,27 @@
+int mix(int a, int b) {
+    return a * 3 + b;
+}
+
+int main() {
+    int a = 1;
+    int b = 2;
+    int c = 3;
+    int d = 4;
+    int e = 5;
+    int f = 6;
+    int g = 7;
+    int h = 8;
+    int i = 0;
+    while (i < 10) {
+        a = a + b;
+        b = b + c;
+        c = mix(c, d);
+        d = d + e;
+        e = e ^ f;
+        f = f + g;
+        g = mix(g, h) % 1000;
+        h = h + a;
+        i++;
+    }
+    return (a + b + c + d + e + f + g + h) % 256;
+}
@@ -0,0 +1,16 @@
+float scale(float x, int k) {
+    return x * k;
+}
+
+int main() {
+    float sum = 0.5;
+    float step = 1.5;
+    int i = 0;
+    while (i < 6) {
+        sum = sum + scale(step, i);
+        step = step + 0.25;
+        i++;
+    }
+    int r = sum;
+    return r;
+}
@@ -0,0 +1,34 @@
+int fill(int n) {
+    int total = 0;
+    if (n > 2) {
+        int a[4];
+        int i = 0;
+        while (i < 4) {
+            a[i] = n * i;
+            i++;
+        }
+        total = a[0] + a[1] + a[2] + a[3];
+    } else {
+        int b[4];
+        int j = 0;
+        while (j < 4) {
+            b[j] = n + j;
+            j++;
+        }
+        total = b[3] - b[0];
+    }
+    {
+        int c[3];
+        c[0] = total;
+        c[1] = total * 2;
+        c[2] = c[0] + c[1];
+        total = c[2];
+    }
+    return total;
+}
+
+int main() {
+    int x = fill(5);
+    int y = fill(1);
+    return (x + y) % 256;
+}
@@ -0,0 +1,36 @@
+int scale(int n) {
+    int x = 3;
+    int y = x * 4;
+    int debug = 0;
+    int r = n;
+    if (debug) {
+        r = r * 1000;
+        putchar(68);
+    }
+    int i = 0;
+    while (i < y) {
+        if (x > 2) {
+            r = r + x;
+        } else {
+            r = r - 1;
+        }
+        i++;
+    }
+    return r;
+}
+
+float ratio() {
+    float a = 1.0;
+    float b = 3.0;
+    float c = a / b;
+    int k = 7;
+    float d = k;
+    return c * d;
+}
+
+int main() {
+    int s = scale(5);
+    float f = ratio();
+    int g = f * 1000;
+    return (s + g) % 256;
+}
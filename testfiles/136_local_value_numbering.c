@@ -0,0 +1,27 @@
+int square_sum(int a, int b) {
+    int s = a * b + a * b;
+    int t[4];
+    t[0] = a;
+    t[1] = b;
+    int i = 1;
+    int u = t[i] + t[i];
+    t[i] = 7;
+    int v = t[i] + u;
+    int x = a * b;
+    a = 5;
+    int y = a * b;
+    return s + u + v + x + y;
+}
+
+float mix(int n, float f) {
+    float g = f + n;
+    float h = f * n;
+    return g + h;
+}
+
+int main() {
+    int r = square_sum(3, 4);
+    float m = mix(3, 0.5);
+    int k = m * 10;
+    return (r + k) % 256;
+}
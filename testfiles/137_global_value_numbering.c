@@ -0,0 +1,34 @@
+int bound(int n, int m) {
+    int limit = n * m + 1;
+    int r = 0;
+    if (n > m) {
+        r = (m * n + 1) * 2;
+    } else {
+        r = (n * m + 1) - 3;
+    }
+    if (m < n) {
+        r = r + 1;
+    }
+    r = r + (n * m + 1);
+    return r + limit;
+}
+
+float mean(int a, int b) {
+    float s = a + b;
+    float t = 0.0;
+    if (a < b) {
+        t = (b + a) * 0.5;
+    } else {
+        t = s * 0.5;
+    }
+    float u = s + (a + b);
+    return t + u;
+}
+
+int main() {
+    int x = bound(7, 3);
+    int y = bound(2, 9);
+    float z = mean(3, 4);
+    int w = z * 10;
+    return (x + y + w) % 256;
+}
@@ -0,0 +1,44 @@
+int g = 6;
+int counter = 0;
+
+int bump() {
+    counter = counter + 1;
+    return counter;
+}
+
+int sum(int n, int d) {
+    int s = 0;
+    int i = 0;
+    while (i < n) {
+        int j = 0;
+        while (j < 3) {
+            s = s + n * 4 + g + j;
+            j++;
+        }
+        i++;
+    }
+    int k = 0;
+    while (k < n) {
+        s = s + 100 / d;
+        k++;
+    }
+    return s;
+}
+
+int calls(int n) {
+    int s = 0;
+    int i = 0;
+    while (i < n) {
+        s = s + counter * 2;
+        bump();
+        i++;
+    }
+    return s;
+}
+
+int main() {
+    int a = sum(5, 7);
+    int b = sum(0, 0);
+    int c = calls(4);
+    return (a + b + c) % 256;
+}
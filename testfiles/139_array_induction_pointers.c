@@ -0,0 +1,87 @@
+int fill(int n) {
+    int a[20];
+    int b[20];
+    int i = 0;
+    while (i < 20) {
+        a[i] = i * 3 - 7;
+        b[i] = 0;
+        i++;
+    }
+
+    i = 1;
+    while (i < 19) {
+        b[i] = a[i - 1] + a[i + 1];
+        i = i + 1;
+    }
+
+    i = 19;
+    while (i >= 0) {
+        b[i] += a[i];
+        b[i] *= 2;
+        b[i] -= 1;
+        i = i - 1;
+    }
+
+    int s = 0;
+    i = 0;
+    while (i < n) {
+        s = s + b[i];
+        i += 3;
+    }
+
+    int j = 0;
+    while (j != 10) {
+        s = s + a[j] % 5;
+        j++;
+    }
+    return s + j;
+}
+
+float scale(int n) {
+    float f[8];
+    int i = 0;
+    while (i < 8) {
+        f[i] = i * 1.5;
+        i++;
+    }
+    i = 0;
+    while (i < 8) {
+        f[i] /= 2.0;
+        f[i] = f[i] + 0.25;
+        i++;
+    }
+    float total = 0.0;
+    i = n;
+    while (i < 8) {
+        total = total + f[i];
+        i++;
+    }
+    return total;
+}
+
+int nested() {
+    int m[12];
+    int i = 0;
+    while (i < 12) {
+        m[i] = 1;
+        i++;
+    }
+    int r = 0;
+    i = 0;
+    while (i < 3) {
+        int k = 0;
+        while (k < 4) {
+            m[k] = m[k] + i;
+            r = r + m[i + 4] + m[k];
+            k++;
+        }
+        i++;
+    }
+    return r;
+}
+
+int main() {
+    int total = fill(20) + fill(0) + fill(7);
+    total = total + scale(0) + scale(5) + scale(9);
+    return (total + nested()) % 256;
+}
@@ -0,0 +1,57 @@
+int sum(int n) {
+    int s = 0;
+    int i = 0;
+    while (i < n) {
+        s = s + i * 3;
+        i = i + 1;
+    }
+    return s;
+}
+
+int countdown(int n, int step) {
+    int s = 0;
+    while (n >= 0) {
+        s = s + n;
+        n = n - 3;
+    }
+    return s + step;
+}
+
+int main() {
+    int a[10];
+    int i = 0;
+    while (i < 10) {
+        a[i] = i * i;
+        i++;
+    }
+    int t = 0;
+    i = 1;
+    while (i <= 9) {
+        t = t + a[i];
+        i = i + 2;
+    }
+    int k = 100;
+    while (k > 37) {
+        t = t + k;
+        k = k - 7;
+    }
+    int j = 0;
+    while (j != 6) {
+        t = t + j;
+        j = j + 2;
+    }
+    t = t + sum(0) + sum(1) + sum(3) + sum(4) + sum(5) + sum(13);
+    t = t + countdown(-1, 1) + countdown(10, 2) + countdown(11, 3);
+    int big = 0;
+    int m = 2147483640;
+    while (m < 2147483647) {
+        big = big + 1;
+        m = m + 1;
+    }
+    int q = 0;
+    while (q < 40) {
+        big = big + q;
+        q = q + 1;
+    }
+    return (t + big) % 256;
+}
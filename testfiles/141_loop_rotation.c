@@ -0,0 +1,36 @@
+int calls;
+
+int below(int x, int n) {
+    calls = calls + 1;
+    return x < n;
+}
+
+int main() {
+    int i = 0;
+    int s = 0;
+    while (below(i, 5)) {
+        s = s + i;
+        i = i + 1;
+    }
+    int j = 10;
+    int last = 0;
+    while (j * 2 > 4) {
+        last = j * 2;
+        j = j - 3;
+    }
+    int k = 7;
+    while (k < 3) {
+        s = s + 100;
+    }
+    int a = 0;
+    int t = 0;
+    while (a < 4) {
+        int b = a;
+        while (b < 6) {
+            t = t + b;
+            b = b + 1;
+        }
+        a = a + 1;
+    }
+    return s + calls * 3 + last + j + k + t + a;
+}
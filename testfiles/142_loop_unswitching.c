@@ -0,0 +1,48 @@
+int mode;
+
+int scale(int n, int flag) {
+    int s = 0;
+    int i = 0;
+    while (i < n) {
+        if (flag) {
+            s = s + i * 2;
+        } else {
+            s = s - i;
+        }
+        i = i + 1;
+    }
+    return s;
+}
+
+int accumulate(int n) {
+    int t = 0;
+    int i = 0;
+    while (i < n) {
+        t = t + i;
+        if (mode > 1) {
+            t = t + 5;
+        }
+        i = i + 1;
+    }
+    return t + i;
+}
+
+int main() {
+    int r = scale(10, 1) + scale(10, 0) + scale(0, 1);
+    mode = 2;
+    r = r + accumulate(6);
+    mode = 0;
+    r = r + accumulate(6);
+    int a[5];
+    int k = 0;
+    int neg = r < 0;
+    while (k < 5) {
+        if (neg) {
+            a[k] = 0 - k;
+        } else {
+            a[k] = k * k;
+        }
+        k = k + 1;
+    }
+    return (r + a[4] + a[2]) % 256;
+}
@@ -0,0 +1,42 @@
+int calls;
+
+int touch(int v) {
+    calls = calls + 1;
+    return v;
+}
+
+int main() {
+    int a = 0;
+    int b = 3;
+    int r = 0;
+    if (a && touch(1)) {
+        r = r + 1;
+    }
+    if (b || touch(1)) {
+        r = r + 2;
+    }
+    if ((a || touch(0)) && touch(5)) {
+        r = r + 4;
+    }
+    if (b > 2 && (touch(0) || b == 3)) {
+        r = r + 8;
+    }
+    int x = a && touch(7);
+    int y = b || touch(7);
+    int z = (b && touch(9)) + (a || touch(0)) * 10;
+    char c = 'a';
+    int w = c && b;
+    int i = 0;
+    int n = 0;
+    while (i < 10 && touch(i) != 6) {
+        i = i + 1;
+        n = n + 1;
+    }
+    while (0 && touch(1)) {
+        n = n + 100;
+    }
+    if (1 || touch(1)) {
+        n = n + 1000;
+    }
+    return (r + x * 16 + y * 32 + z * 64 + w + n + calls * 3) % 256;
+}
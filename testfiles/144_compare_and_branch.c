@@ -0,0 +1,48 @@
+int pick(int a, int b) {
+    int r = 0;
+    if (a == b) {
+        r = r + 1;
+    }
+    if (a != b) {
+        r = r + 2;
+    }
+    if (a < b) {
+        r = r + 4;
+    }
+    if (a <= b) {
+        r = r + 8;
+    }
+    if (a > b) {
+        r = r + 16;
+    }
+    if (a >= b) {
+        r = r + 32;
+    }
+    return r;
+}
+
+int main() {
+    int s = pick(1, 2) + pick(2, 1) * 3 + pick(-5, -5) * 7;
+    int x = 4;
+    int y = 9;
+    int less = x < y;
+    if (less) {
+        s = s + less * 100;
+    }
+    int t = x > y;
+    if (t) {
+        s = s + 1;
+    } else {
+        s = s + t + 3;
+    }
+    char c = 'k';
+    if (c > 'a') {
+        s = s + 5;
+    }
+    int i = 10;
+    while (i >= 0) {
+        i = i - 3;
+        s = s + i;
+    }
+    return s % 256;
+}
@@ -0,0 +1,47 @@
+int sign(int x) {
+    if (x < 0) {
+        return -1;
+        x = 5;
+    }
+    if (x == 0) {
+        return 0;
+    } else {
+        return 1;
+    }
+    return 7;
+}
+
+int classify(int a, int b) {
+    int r = 0;
+    if (a > b) {
+        if (a > 2 * b) {
+            r = 3;
+        } else {
+            r = 2;
+        }
+    } else {
+        if (a == b) {
+        }
+    }
+    while (a > 10) {
+        if (b > 0) {
+        }
+        a = a - 3;
+    }
+    return r + a;
+}
+
+int main() {
+    int s = sign(-4) + sign(0) * 3 + sign(9) * 5;
+    int t = 0;
+    int i = 0;
+    while (i < 6) {
+        t = t + classify(i * 7, i + 2);
+        i = i + 1;
+    }
+    {
+    }
+    if (t > 1000) {
+    }
+    return s + t;
+}
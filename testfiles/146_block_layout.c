@@ -0,0 +1,62 @@
+int find(int n, int key) {
+    int i = 0;
+    while (i < n) {
+        if ((i * 7) % 13 == key) {
+            return i;
+        }
+        i = i + 1;
+    }
+    return -1;
+}
+
+int grade(int score) {
+    if (score >= 90) {
+        return 4;
+    }
+    if (score >= 75) {
+        return 3;
+    } else if (score >= 50) {
+        return 2;
+    }
+    return 0;
+}
+
+int mix(int n) {
+    int a[12];
+    int i = 0;
+    while (i < n) {
+        if (i % 3 == 0) {
+            a[i] = i * 2;
+        } else {
+            a[i] = 100 - i;
+        }
+        i = i + 1;
+    }
+    int s = 0;
+    i = 0;
+    while (i < n) {
+        s = s + a[i];
+        i = i + 1;
+    }
+    return s;
+}
+
+int main() {
+    int total = 0;
+    int s = 0;
+    while (s <= 100) {
+        total = total + grade(s);
+        s = s + 7;
+    }
+    int j = 0;
+    int k = 0;
+    while (j < 4) {
+        k = 0;
+        while (k < 3) {
+            total = total + find(12, j * 3 + k);
+            k = k + 1;
+        }
+        j = j + 1;
+    }
+    return total + mix(12) % 50 + find(12, 20);
+}
@@ -0,0 +1,97 @@
+int hits = 3;
+
+int record(int p) {
+    p = (p != 0);
+    if (p + p) {
+        p = 13;
+        hits -= (-p);
+    }
+    return p;
+}
+
+int flag;
+
+int next(int x) {
+    return x - 2;
+}
+
+int pick(int p, int a) {
+    int r;
+    if (next(p)) {
+        r = a + 1;
+    } else {
+        r = a * 3;
+    }
+    return r;
+}
+
+int guarded() {
+    int m = 13;
+    if (flag) {
+        m = next(m);
+    }
+    int r = m && flag;
+    return r + m;
+}
+
+int imin(int a, int b) {
+    int m;
+    if (a < b) {
+        m = a;
+    } else {
+        m = b;
+    }
+    return m;
+}
+
+int iabs(int x) {
+    if (x < 0) {
+        x = -x;
+    }
+    return x;
+}
+
+float fmax2(float a, float b) {
+    float m = b;
+    if (a > b) {
+        m = a;
+    }
+    return m;
+}
+
+int clamp(int v, int lo, int hi) {
+    if (v < lo) {
+        v = lo;
+    } else {
+        if (v > hi) {
+            v = hi;
+        }
+    }
+    return v;
+}
+
+int main() {
+    int small = 0;
+    int big = 0;
+    int i = 0;
+    int acc = 0;
+    while (i < 40) {
+        int v = (i * 37) % 23 - 11;
+        if (v > 0) {
+            big = big + v;
+        } else {
+            small = small - v;
+        }
+        acc = acc + clamp(v, -5, 6) + iabs(v) + imin(v, i - 20);
+        i = i + 1;
+    }
+    float f = fmax2(1.5, 2.5) + fmax2(3.25, -1.0);
+    int fi = f * 4;
+    char c = 'x';
+    if (c > 'm') {
+        c = 'm';
+    }
+    int r = record(0) + record(5) * 10;
+    r = r + pick(2, 38) + pick(5, 1) + guarded();
+    return (acc + small * 3 + big + c + fi + r + hits) % 256;
+}
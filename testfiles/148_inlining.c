@@ -0,0 +1,58 @@
+int counter;
+
+int square(int x) {
+    return x * x;
+}
+
+int add3(int a, int b, int c) {
+    return a + b + c;
+}
+
+float scale(float f, int k) {
+    return f * k;
+}
+
+void bump(int n) {
+    counter = counter + n;
+}
+
+int sign(int v) {
+    if (v < 0) {
+        return -1;
+    }
+    if (v > 0) {
+        return 1;
+    }
+    return 0;
+}
+
+int sumTo(int n) {
+    int s = 0;
+    int i = 1;
+    while (i <= n) {
+        s = s + square(i);
+        i = i + 1;
+    }
+    return s;
+}
+
+int fact(int n) {
+    if (n <= 1) {
+        return 1;
+    }
+    return n * fact(n - 1);
+}
+
+int main() {
+    int t = 0;
+    int i = -3;
+    while (i <= 3) {
+        t = t + sign(i) * square(i) + add3(i, 1, square(2));
+        bump(i + 4);
+        i = i + 1;
+    }
+    square(5);
+    float f = scale(2.5, 3);
+    int g = f;
+    return (t + sumTo(6) + counter + g + fact(5)) % 256;
+}
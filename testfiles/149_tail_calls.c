@@ -0,0 +1,94 @@
+#include <stdio.h>
+
+int fact(int n)
+{
+    if (n <= 1)
+        return 1;
+    return n * fact(n - 1);
+}
+
+int sum(int n)
+{
+    if (n == 0)
+        return 0;
+    return n + sum(n - 1);
+}
+
+int gcd(int a, int b)
+{
+    if (b == 0)
+        return a;
+    return gcd(b, a % b);
+}
+
+int scale(int x, int k)
+{
+    return x * k + 1;
+}
+
+int twice(int x)
+{
+    return scale(x, 2);
+}
+
+void show(int x)
+{
+    putchar('0' + x % 10);
+    putchar(10);
+}
+
+void report(int x)
+{
+    show(x + 3);
+}
+
+float half(float x, int n)
+{
+    if (n == 0)
+        return x;
+    return half(x / 2, n - 1);
+}
+
+int count(int n, int acc)
+{
+    if (n == 0)
+        return acc;
+    if (n % 3 == 0)
+        return count(n - 1, acc + 2);
+    return count(n - 1, acc + 1);
+}
+
+int base(int n)
+{
+    if (n > 5)
+        return base(n - 1) + 1;
+    return n + 100;
+}
+
+int prodb(int n)
+{
+    if (n <= 0)
+        return base(n);
+    return n * prodb(n - 1);
+}
+
+int sumb(int n)
+{
+    if (n <= 0)
+        return base(n + 8);
+    return sumb(n - 1) + n;
+}
+
+int main()
+{
+    int r = fact(10) % 1000;
+    r = r + sum(20000) % 97;
+    r = r + gcd(1071, 462);
+    r = r + twice(5) + twice(r);
+    report(r);
+    float h = half(1024.0, 4);
+    r = r + h;
+    r = r + count(20000, 0) % 101;
+    r = r + prodb(3) + sumb(4);
+    return r % 256;
+}
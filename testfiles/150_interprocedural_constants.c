@@ -0,0 +1,58 @@
+int checksum(int n, int base, int mod)
+{
+    int s = 0;
+    int i = 0;
+    int a[16];
+    while (i < 16) {
+        a[i] = (i * base + 3) % mod;
+        i = i + 1;
+    }
+    i = 0;
+    while (i < n) {
+        s = s * base + a[i % 16];
+        s = s % mod;
+        i = i + 1;
+    }
+    if (s > 1000) {
+        s = s - 1000;
+    }
+    return s;
+}
+
+int walk(int n, int step)
+{
+    if (n <= step) {
+        return n + 1;
+    }
+    return 2 * walk(n - step, step) - n % 5;
+}
+
+float scale(float x, int times, float factor)
+{
+    float r = x;
+    int i = 0;
+    while (i < times) {
+        r = r * factor;
+        i = i + 1;
+    }
+    if (r > 1000.0) {
+        r = 1000.0;
+    }
+    if (r < 0.5) {
+        r = 0.5;
+    }
+    return r;
+}
+
+int main()
+{
+    int r = checksum(8, 7, 97);
+    r = r + checksum(12, 7, 97);
+    r = r + checksum(5, 3, 101);
+    r = r + walk(10, 3) % 50;
+    r = r + walk(9, 2) % 50;
+    float f = scale(1.5, 3, 2.0);
+    f = f + scale(3.0, 2, 2.0);
+    r = r + f;
+    return r % 256;
+}
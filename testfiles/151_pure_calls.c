@@ -0,0 +1,77 @@
+int bias = 3;
+
+int fib(int n)
+{
+    if (n < 2) {
+        return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+}
+
+int mixer(int a, int b)
+{
+    int x = a * 31 + b;
+    int y = x ^ (a * 7);
+    int z = y + (b & 15);
+    if (z > 1000) {
+        z = z - 1000;
+    } else {
+        z = z + 17;
+    }
+    if (x > y) {
+        z = z + x - y;
+    } else {
+        z = z + y - x;
+    }
+    int w = z * 3 + a - b;
+    if (w < 0) {
+        w = -w;
+    }
+    return w % 1009 + (x & 3) + (y | 1);
+}
+
+int biased(int a)
+{
+    int r = a * 5 + bias;
+    if (r > 40) {
+        r = r - 40;
+    } else {
+        r = r + bias * 2;
+    }
+    if (a > r) {
+        r = r + a;
+    }
+    return r + bias * a - (a & 7) + (r ^ a);
+}
+
+int noisy(int c)
+{
+    putchar(c);
+    return c + 1;
+}
+
+int main()
+{
+    int total = 0;
+    int i = 0;
+    while (i < 20) {
+        total = total + mixer(11, 42) % 13 + fib(15) % 7;
+        total = total + fib(15) % 5;
+        i = i + 1;
+    }
+    int a = biased(6);
+    int b = biased(6);
+    bias = 10;
+    int c = biased(6);
+    total = total + a + b + c;
+    int d = noisy(65) + noisy(65);
+    putchar(10);
+    total = total + d;
+    int k = 0;
+    while (k < 5) {
+        total = total + biased(k) + biased(2);
+        bias = bias + 1;
+        k = k + 1;
+    }
+    return total % 256;
+}
@@ -0,0 +1,46 @@
+int fib(int n)
+{
+    if (n < 2) {
+        return n;
+    }
+    return (fib(n - 1) + fib(n - 2)) % 100003;
+}
+
+int score(int n)
+{
+    if (n <= 0) {
+        return 1 - n;
+    }
+    if (n % 2 == 0) {
+        return score(n / 2) + score(n - 1) % 7;
+    }
+    return score(n - 1) * 3 % 1009 + score(n - 3) % 11;
+}
+
+int tri(int n)
+{
+    if (n <= 0) {
+        return 0;
+    }
+    return (tri(n - 1) + n) % 1000;
+}
+
+int total = 0;
+
+int counted(int n)
+{
+    total = total + 1;
+    if (n < 2) {
+        return 1;
+    }
+    return counted(n - 1) + counted(n - 2);
+}
+
+int main()
+{
+    int r = fib(27) % 1000;
+    r = r + score(25) + score(-4) + tri(5000) % 100;
+    r = r + counted(12);
+    r = r + total;
+    return r % 256;
+}